@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "roomConfig.h"
+
+/**
+ * @brief Цель планирования: перцентиль времени до завершения всех студентов не больше deadline_ms
+ */
+struct PlanTarget {
+    double percentile = 95.0; // Перцентиль времени, когда все студенты набрали посещения
+    int deadline_ms = 200000; // Граница для перцентиля (по умолчанию - таймаут main.cpp)
+};
+
+/**
+ * @brief Пространство поиска параметров класса
+ *
+ * Вместимость ищется двоичным поиском в [min_capacity, max_capacity], остальные параметры перебираются по спискам.
+ */
+struct PlanSpace {
+    int min_capacity = 1;
+    int max_capacity = 40;
+    std::vector<int> need_ks40_values = { 10, 15, 20 }; // Пороги начала занятия для КС-40
+    std::vector<int> need_ks44_values = { 8, 12, 16 }; // Пороги начала занятия для КС-44
+    std::vector<int> session_ms_values = { 5000 }; // Длительности занятия, мс
+};
+
+/**
+ * @brief Настройки оценки одной точки пространства
+ */
+struct PlanOptions {
+    int runs_per_point = 200; // Максимальное кол-во прогонов модели в точке
+    int batch_runs = 40; // Прогонов между проверками досрочной остановки
+    int threads = 0; // Кол-во потоков (0 - по числу ядер)
+    uint64_t seed = 1; // Зерно первого прогона, в каждой точке используются одни и те же зерна
+    // Точка не моделируется, если оценка MarkovEstimator превышает deadline_ms в столько раз (0 - не отсекать)
+    double model_prune_factor = 0.0;
+    // Выполнять прогоны пакетами по RoomEnsemble::LANES в одном проходе: результаты те же, что у RoomSimulator,
+    // поэтому режим служит для сверки моделей; по замерам он медленнее RoomSimulator и по умолчанию выключен
+    bool lockstep_ensemble = false;
+    // Стоимость конфигурации, по умолчанию - кол-во мест; должна не убывать с ростом вместимости
+    std::function<double(const RoomConfig&)> cost;
+};
+
+/**
+ * @brief Оценка одной конфигурации
+ */
+struct PlanPoint {
+    RoomConfig config;
+    int runs = 0; // Выполнено прогонов (меньше runs_per_point при досрочной остановке)
+    double exceed_share = 0.0; // Доля прогонов, не завершившихся к deadline_ms
+    int percentile_ms = 0; // Перцентиль времени завершения (для недопустимых точек - deadline_ms)
+    bool feasible = false; // Точка удовлетворяет цели
+    bool stopped_early = false; // Оценка остановлена досрочно как заведомо недопустимая
+    double model_percentile_ms = -1.0; // Перцентиль по MarkovEstimator (-1 - модель не дает завершения)
+    bool pruned = false; // Точка отсечена по оценке MarkovEstimator без прогонов
+    double cost = 0.0;
+};
+
+/**
+ * @brief Результат планирования
+ */
+struct PlanResult {
+    bool found = false; // Найдена хотя бы одна допустимая конфигурация
+    PlanPoint best; // Самая дешевая допустимая конфигурация
+    std::vector<PlanPoint> evaluated; // Все оцененные точки в порядке оценки
+};
+
+/**
+ * @brief Ищет самую дешевую конфигурацию класса, при которой цель по времени завершения выполняется
+ *
+ * В каждой точке параллельно выполняется до runs_per_point прогонов RoomSimulator с одними и теми же зернами.
+ * Перед прогонами точка оценивается аналитически (MarkovEstimator) и при model_prune_factor > 0 может быть
+ * отсечена без моделирования.
+ * Оценка точки останавливается досрочно, как только цель заведомо не выполнима (или нижняя доверительная
+ * граница доли опозданий выше допустимой). Вместимость ищется двоичным поиском, комбинации, которые не
+ * могут быть дешевле уже найденной, пропускаются.
+ *
+ * @param base Базовая конфигурация: состав групп и интервалы ожидания
+ * @param target Цель по перцентилю времени завершения
+ * @param space Пространство поиска
+ * @param options Настройки оценки
+ * @return Лучшая конфигурация и все оцененные точки
+ */
+PlanResult planCapacity(const RoomConfig& base, const PlanTarget& target, const PlanSpace& space, const PlanOptions& options);
+
+/**
+ * @brief Оценивает одну конфигурацию
+ *
+ * @param config Конфигурация класса
+ * @param target Цель по перцентилю времени завершения
+ * @param options Настройки оценки
+ * @return Оценка точки
+ */
+PlanPoint evaluatePlanPoint(const RoomConfig& config, const PlanTarget& target, const PlanOptions& options);
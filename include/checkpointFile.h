@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Заголовок файла контрольной точки класса
+ *
+ * Время хранится в миллисекундах от начала работы класса, чтобы таймеры можно было продолжить в другом процессе.
+ */
+struct CheckpointHeader {
+    char magic[8]; // "CROOMCK"
+    uint32_t version;
+    uint32_t writing; // 1, пока контрольная точка записывается; такая половина файла не восстанавливается
+    uint64_t generation; // Номер контрольной точки в файле (восстанавливается половина с большим номером)
+    int32_t total_ks40;
+    int32_t total_ks44;
+    int32_t capacity;
+    int32_t in_session; // Идет ли занятие
+    int32_t group; // Группа занятия (0 - нет)
+    int32_t completed_ks40;
+    int32_t completed_ks44;
+    int32_t reserved;
+    int64_t checkpoint_ms; // Момент контрольной точки
+    int64_t session_end_ms; // Момент окончания текущего занятия
+    int64_t sessions_started;
+    int64_t visits_credited;
+    int64_t lock_acquisitions;
+    int64_t wakeups;
+};
+
+/**
+ * @brief Запись о студенте; студенты КС-40 идут первыми, затем КС-44
+ */
+struct CheckpointRecord {
+    static constexpr uint8_t IN_ROOM = 1; // Студент в классе
+    static constexpr uint8_t ATTENDED = 2; // Текущее занятие засчитано
+
+    int64_t backoff_until_ms; // Конец паузы перед следующей попыткой (0 - паузы нет)
+    uint16_t visits;
+    uint8_t flags;
+    uint8_t reserved[5];
+};
+
+/**
+ * @brief Файл контрольной точки фиксированного размера, отображенный в память
+ *
+ * Файл состоит из двух половин, в каждой - заголовок и по одной записи на студента. Точки пишутся в половины
+ * по очереди, поэтому записи меняются на месте, а предыдущая завершенная точка остается нетронутой. Пока идет
+ * запись, в заголовке половины стоит флаг writing: если процесс упадет посреди записи, при восстановлении будет
+ * выбрана другая половина. Половина, в которую пишется точка, отстает на одну точку, поэтому кроме измененных
+ * студентов в нее копируются записи, измененные предыдущей точкой, и стоимость остается пропорциональной изменениям.
+ */
+class CheckpointFile {
+public:
+    static constexpr uint32_t VERSION = 2;
+
+    CheckpointFile() = default;
+    ~CheckpointFile();
+
+    CheckpointFile(const CheckpointFile&) = delete;
+    CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+    /**
+     * @brief Создает (или перезаписывает) файл на records записей и отображает его для записи
+     *
+     * Обе половины недействительны до первого commit().
+     */
+    bool create(const std::string& path, int records);
+
+    /**
+     * @brief Отображает существующий файл только для чтения и выбирает последнюю завершенную точку
+     *
+     * @return false, если файла нет, он поврежден, ни одна половина не записана до конца или файл другой версии
+     */
+    bool openReadOnly(const std::string& path);
+
+    /**
+     * @brief Закрывает отображение
+     */
+    void close();
+
+    bool isOpen() const;
+    const std::string& path() const;
+    int recordCount() const;
+
+    /**
+     * @brief Начинает точку в половине, не содержащей последнюю завершенную точку, и помечает ее как записываемую
+     *
+     * Записи, измененные предыдущей точкой, копируются из другой половины; до commit() половина может быть
+     * в промежуточном состоянии.
+     */
+    void beginWrite();
+
+    /**
+     * @brief Записывает запись студента в начатую точку
+     */
+    void writeRecord(int index, const CheckpointRecord& record);
+
+    /**
+     * @brief Записывает заголовок начатой половины со снятым флагом writing и сбрасывает изменения на диск
+     */
+    bool commit(CheckpointHeader header);
+
+    /**
+     * @brief Заголовок последней завершенной точки (после openReadOnly - выбранной половины)
+     */
+    const CheckpointHeader& header() const;
+    const CheckpointRecord& record(int index) const;
+
+private:
+    std::string file_path;
+    int fd = -1;
+    void* mapping = nullptr;
+    size_t mapped_size = 0;
+    int records = 0;
+    bool writable = false;
+    int current = 0; // Половина с последней завершенной точкой
+    int target = 0; // Половина, в которую пишется начатая точка
+    uint64_t last_generation = 0;
+    std::vector<int> written; // Записи, измененные последней точкой: в другой половине они устарели
+    std::vector<int> writing_now; // Записи, измененные начатой точкой
+
+    size_t halfSize() const;
+    CheckpointHeader* headerPtr(int half) const;
+    CheckpointRecord* recordsPtr(int half) const;
+    bool map(size_t size, bool write);
+    bool syncRange(size_t offset, size_t length);
+};
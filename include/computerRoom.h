@@ -3,39 +3,300 @@
 #include <condition_variable>
 #include <vector>
 #include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <ostream>
+#include <string>
+#include <utility>
+#include "roomConfig.h"
+#include "traceRecorder.h"
+#include "latencyHistogram.h"
+#include "checkpointFile.h"
+#include "roomEvents.h"
+#include "roomPlacement.h"
+#include "visitIndex.h"
+#include "roomSync.h"
+
+/**
+ * @brief Снимок счетчиков класса для мониторинга, собирается без захвата мьютекса
+ */
+struct RoomMetrics {
+    int occupancy = 0; // Кол-во студентов в классе
+    int current_group = 0; // Группа, занимающая класс (0 - нет, 1 - КС-40, 2 - КС-44)
+    bool in_session = false; // Идет ли занятие
+    int sessions_started = 0; // Кол-во начавшихся занятий
+    int total_ks40 = 0; // Кол-во студентов КС-40
+    int total_ks44 = 0; // Кол-во студентов КС-44
+    int completed_ks40 = 0; // Студенты КС-40, набравшие 2 посещения
+    int completed_ks44 = 0; // Студенты КС-44, набравшие 2 посещения
+    long long visits_credited = 0; // Всего засчитано посещений
+    long long lock_acquisitions = 0; // Захваты мьютекса, включая повторные после пробуждения
+    long long wakeups = 0; // Пробуждения студентов на условных переменных
+    int seat_waiters = 0; // Студенты, ожидающие места снаружи
+    int prestaged_sessions = 0; // Занятия, начатые подготовленной группой сразу после окончания предыдущего
+    long long seat_rejections = 0; // Попытки, не вставшие в заполненную очередь ожидания места
+    long long seat_timeouts = 0; // Попытки, не дождавшиеся места за wait_timeout_ms
+    long long lock_free_entries = 0; // Входы, в которых место и присутствие заняты без мьютекса класса
+    long long lock_free_visits = 0; // Из них посещения, от входа до конца занятия прошедшие без мьютекса класса
+    long long uptime_ms = 0; // Время работы класса с создания, мс
+    long long session_time_ms = 0; // Суммарная длительность занятий, включая текущее, мс
+    double utilisation = 0.0; // Доля времени работы, занятая занятиями
+    double sessions_per_hour = 0.0; // Начатых занятий в час работы
+};
+
+/**
+ * @brief Фактическое размещение класса: привязка потоков и узлы страниц состояния
+ */
+struct PlacementReport {
+    int numa_nodes = 1; // Кол-во NUMA-узлов машины
+    bool numa_from_system = false; // Топология прочитана из ОС
+    int node = -1; // Узел класса (-1 - без привязки)
+    std::vector<int> cpus; // Процессоры потоков класса (пусто - без привязки)
+    bool memory_policy_applied = false; // Состояние выделялось под политикой узла
+    int pinned_threads = 0; // Разные потоки, успешно привязанные классом к процессорам (повторные вызовы не считаются)
+    int state_pages_local = 0; // Страницы состояния на узле класса
+    int state_pages_remote = 0; // Страницы состояния на других узлах
+    int state_pages_unknown = 0; // Страницы, узел которых ОС не сообщила
+    bool counters_available = false; // Доступны счетчики numastat
+    long long local_allocations = 0; // Прирост local_node с создания класса (по всей системе)
+    long long remote_allocations = 0; // Прирост other_node с создания класса (по всей системе)
+};
+
+/**
+ * @brief Чем закончилась одна попытка студента (visitOnce)
+ */
+enum class AttemptOutcome : uint8_t {
+    Attended, // Попал на занятие своей группы и досидел до конца
+    TimedOut, // Не дождался начала занятия за S мс и вышел
+    Evicted, // Выгнан из-за занятия другой группы
+    Rejected, // Очередь ожидания места группы заполнена или место не освободилось за wait_timeout_ms
+    Stopped // Класс остановлен во время попытки
+};
+
+/**
+ * @brief Где находится студент в studentBehavior
+ */
+enum class StudentWaitKind : uint8_t {
+    NotStarted, // Поток студента еще не запущен
+    Running, // Выполняется между ожиданиями
+    WaitSeat, // Ждет места на условной переменной класса (без пакетного впуска)
+    WaitAdmission, // Ждет в очереди, пока класс впустит его на место
+    WaitSessionStart, // В классе ждет начала занятия своей группы
+    Attending, // На занятии, ждет его окончания
+    Backoff, // Пауза перед следующей попыткой
+    Finished // Вышел из studentBehavior
+};
+
+/**
+ * @brief Текущее ожидание студента и его длительность
+ */
+struct StudentWait {
+    StudentWaitKind kind = StudentWaitKind::NotStarted;
+    long long waited_ms = 0;
+};
+
+/**
+ * @brief Распределения задержек студентов одной группы
+ */
+struct StudentLatency {
+    LatencyHistogram time_to_seat_us; // От решения прийти до получения места, мкс
+    LatencyHistogram time_to_session_us; // От входа до начала занятия или ухода после S мс ожидания, мкс
+    LatencyHistogram evictions; // Кол-во выгонов за время работы студента (записывается при остановке)
+    LatencyHistogram time_to_completion_us; // От запуска студента до второго посещения, мкс
+
+    /**
+     * @brief Добавляет распределения другой группы или другого прогона
+     */
+    void merge(const StudentLatency& other);
+
+    /**
+     * @brief Обнуляет все распределения (не параллельно с записью)
+     */
+    void reset();
+};
 
 class ComputerRoom {
+#ifdef ROOM_SCHEDULE_HOOKS
+    friend class ScheduleExplorer; // Проверяет инварианты по внутреннему состоянию между шагами потоков
+#endif
 private:
-  std::mutex mtx; 
-    std::condition_variable cv; // Условная переменная для ожидания событий
+    // Объявлена первой: политика памяти узла действует, пока конструктор выделяет и обнуляет состояние
+    MemoryPolicyScope memory_policy;
+    RoomMutex mtx;
+    RoomCondition cv; // Условная переменная для ожидания событий
 
-    const int CAPACITY = 20; // Максимальная вместимость компьютерного класса
-    const int TOTAL_KS40 = 30; // Общее кол-во студентов в КС-40
-    const int TOTAL_KS44 = 24; // Общее кол-во студентов в КС-44
-    const int NEED_KS40 = 15; // Необходимое кол-во студентов КС-40 для начала занятия
-    const int NEED_KS44 = 12; // Необходимое кол-во студентов КС-44 для начала занятия
+    const int CAPACITY; // Максимальная вместимость компьютерного класса
+    const int TOTAL_KS40; // Общее кол-во студентов в КС-40
+    const int TOTAL_KS44; // Общее кол-во студентов в КС-44
+    const int NEED_KS40; // Необходимое кол-во студентов КС-40 для начала занятия
+    const int NEED_KS44; // Необходимое кол-во студентов КС-44 для начала занятия
+    const bool BATCHED_ADMISSION; // Пакетный впуск ожидающих студентов самим классом
+    const bool PRESTAGE; // Подготовка следующего занятия во время текущего
+    const bool LOCK_FREE_ENTRY; // Вход без мьютекса класса, пока класс свободен (только без вывода событий)
+    const int SESSION_MS; // Длительность занятия, мс
+    const int MIN_WAIT_MS; // Минимальное время ожидания студентом начала занятия, мс
+    const int MAX_WAIT_MS; // Максимальное время ожидания студентом начала занятия, мс
+    const int RETRY_DELAY_MS; // Пауза студента перед следующей попыткой, мс
+    const int WAIT_LIST_LIMIT; // Макс. кол-во студентов группы, ожидающих места (0 - без ограничения)
+    const int WAIT_TIMEOUT_MS; // Макс. время ожидания места, мс (0 - без ограничения)
 
-    // Текущее состояние компьютерного класса
-    int occupancy = 0; // Кол-во студентов в классе
-    int present_ks40 = 0; // Кол-во студентов КС-40 в классе
-    int present_ks44 = 0; // Кол-во студентов КС-44 в классе
-    int current_group = 0; // Группа, занимающая класс (0 - нет, 1 - КС-40, 2 - КС-44)
-    bool class_in_session = false; // Флаг, что занятие в процессе
+    std::ostream out; // Поток событий класса: std::cout или пустой поток, если вывод отключен
+
+    // Преподаватель - один поток на все время жизни класса, завершающий занятия по таймеру
+    std::thread teacher;
+    RoomCondition teacher_cv;
+    bool teacher_exit = false; // Завершить поток преподавателя (деструктор); после stop() поток ждет reset()
+    std::chrono::steady_clock::time_point session_end_time;
+
+    TraceRecorder* tracer = nullptr; // Необязательная запись временной шкалы (nullptr - отключена)
+    std::chrono::steady_clock::time_point session_begin_time;
+
+    // Упакованное состояние мест: занятость, группа, флаг занятия и присутствие групп в одном атомарном слове,
+    // чтобы студент мог занять место и войти в свободный класс одной CAS-операцией без захвата мьютекса
+    static constexpr uint64_t OCCUPANCY_MASK = 0xFFFF; // Биты 0-15: кол-во занятых мест
+    static constexpr int GROUP_SHIFT = 16; // Биты 16-17: группа, занимающая класс (0 - нет, 1 - КС-40, 2 - КС-44)
+    static constexpr uint64_t GROUP_MASK = 0x3ull << GROUP_SHIFT;
+    static constexpr uint64_t SESSION_BIT = 1ull << 18; // Бит 18: флаг, что занятие в процессе
+    static constexpr int PRESENT_KS40_SHIFT = 20; // Биты 20-35: кол-во студентов КС-40 в классе
+    static constexpr int PRESENT_KS44_SHIFT = 36; // Биты 36-51: кол-во студентов КС-44 в классе
+    static constexpr uint64_t PRESENT_MASK = 0xFFFF;
+    static constexpr int ENTERING_SHIFT = 52; // Биты 52-63: студенты, вошедшие без мьютекса, но еще не поставившие флаг присутствия
+    static constexpr uint64_t ENTERING_MASK = 0xFFF;
+    std::atomic<uint64_t> seat_state{0};
+    std::atomic<int> seat_waiters{0}; // Кол-во студентов, ожидающих места под мьютексом
+
+    // Очередь студентов группы, ожидающих места (кольцевой буфер, растет только если в очереди больше студентов, чем в группе)
+    struct WaitList {
+        std::vector<int> ids;
+        std::vector<long long> tickets; // Порядковые номера постановки в очередь для честного выбора между группами
+        int head = 0;
+        int size = 0;
+    };
+    WaitList wait_list_ks40;
+    WaitList wait_list_ks44;
+    long long next_wait_ticket = 0;
+    int staged_group = 0; // Группа, чья очередь набрала порог для следующего занятия (0 - не выбрана)
+    int seat_queue_ks40 = 0; // Студенты КС-40, ожидающие места (в очереди или на условной переменной класса)
+    int seat_queue_ks44 = 0; // Студенты КС-44, ожидающие места
+    std::atomic<long long> seat_rejections{0}; // Кол-во попыток, не вставших в заполненную очередь
+    std::atomic<long long> seat_timeouts{0}; // Кол-во попыток, не дождавшихся места за WAIT_TIMEOUT_MS
+    std::vector<int> admitted_ks40; // Кол-во решений о впуске, еще не полученных студентами КС-40
+    std::vector<int> admitted_ks44; // Кол-во решений о впуске, еще не полученных студентами КС-44
+    std::vector<RoomCondition> admit_cv_ks40; // Персональные условные переменные для пробуждения впущенных студентов КС-40
+    std::vector<RoomCondition> admit_cv_ks44; // Персональные условные переменные для пробуждения впущенных студентов КС-44
+
+    // Счетчики для оценки конкуренции за мьютекс
+    std::atomic<long long> lock_acquisitions{0}; // Кол-во захватов мьютекса, включая повторные после пробуждения
+    std::atomic<int> sessions_started{0}; // Кол-во начавшихся занятий
+    std::atomic<long long> wakeups{0}; // Кол-во пробуждений студентов на условных переменных
+    std::atomic<long long> visits_credited{0}; // Всего засчитано посещений
+    std::atomic<int> completed_ks40{0}; // Кол-во студентов КС-40, набравших 2 посещения
+    std::atomic<int> completed_ks44{0}; // Кол-во студентов КС-44, набравших 2 посещения
+    std::atomic<int> prestaged_sessions{0}; // Кол-во занятий, начатых подготовленной группой
+    std::atomic<long long> lock_free_entries{0}; // Кол-во входов без мьютекса класса
+    std::atomic<long long> lock_free_visits{0}; // Кол-во посещений, прошедших целиком без мьютекса класса
+    std::chrono::steady_clock::time_point created_at; // Создание класса, от него считается загрузка (не сдвигается при восстановлении)
+    std::atomic<long long> session_busy_us{0}; // Суммарная длительность завершенных занятий, мкс
+    std::atomic<long long> session_started_us{0}; // Начало текущего занятия, мкс от created_at
+    LatencyHistogram lock_wait_ns; // Время ожидания захвата мьютекса студентом, нс
+    StudentLatency latency_ks40; // Задержки студентов КС-40
+    StudentLatency latency_ks44; // Задержки студентов КС-44
+    std::vector<std::chrono::steady_clock::time_point> started_at_ks40; // Время запуска каждого студента КС-40
+    std::vector<std::chrono::steady_clock::time_point> started_at_ks44; // Время запуска каждого студента КС-44
+
+    // Студенты, вошедшие без мьютекса класса, ждут начала и конца занятия на отдельном мьютексе: он захватывается
+    // только для проверки условия, поэтому не ждет долгих критических секций класса. Порядок захвата: mtx, затем lobby_mtx
+    RoomMutex lobby_mtx;
+    RoomCondition lobby_cv;
+    std::atomic<int> lobby_waiters{0}; // Студенты, ждущие на lobby_cv (без них уведомление не нужно)
+    std::atomic<bool> events_subscribed{false}; // Есть подписчики событий: вход без мьютекса отключен, чтобы не терять события входа
 
     std::atomic<bool> stop_flag{false}; // Флаг для остановки всех потоков
+    RoomMutex backoff_mtx; // Пауза студента прерывается остановкой класса
+    RoomCondition backoff_cv;
 
     // Информация о студентах
     std::vector<int> visits_ks40; // Кол-во посещений для каждого студента КС-40
     std::vector<int> visits_ks44; // Кол-во посещений для каждого студента КС-44
-    std::vector<bool> in_room_ks40; // Флаги присутствия студентов КС-40 в классе
-    std::vector<bool> in_room_ks44; // Флаги присутствия студентов КС-44 в классе
+    VisitIndex visit_index_ks40; // Студенты КС-40 по кол-ву посещений
+    VisitIndex visit_index_ks44; // Студенты КС-44 по кол-ву посещений
+    // Флаги присутствия: студент ставит свой флаг и без мьютекса (вход в свободный класс), снимают флаги только под мьютексом
+    std::vector<std::atomic<bool>> in_room_ks40; // Флаги присутствия студентов КС-40 в классе
+    std::vector<std::atomic<bool>> in_room_ks44; // Флаги присутствия студентов КС-44 в классе
     std::vector<bool> attended_this_session_ks40; // Флаги посещения текущего занятия для КС-40
     std::vector<bool> attended_this_session_ks44; // Флаги посещения текущего занятия для КС-44
+    std::vector<long long> backoff_until_ks40; // Конец паузы студента КС-40, мс от epoch (0 - паузы нет)
+    std::vector<long long> backoff_until_ks44; // Конец паузы студента КС-44, мс от epoch (0 - паузы нет)
+    std::vector<std::atomic<uint64_t>> wait_state_ks40; // Ожидание студента КС-40: (мкс от epoch << 8) | StudentWaitKind
+    std::vector<std::atomic<uint64_t>> wait_state_ks44; // Ожидание студента КС-44: (мкс от epoch << 8) | StudentWaitKind
+
+    // Контрольные точки: изменения студентов с прошлой точки копируются под мьютексом и дописываются в файл на месте
+    std::chrono::steady_clock::time_point epoch; // Начало работы класса (при восстановлении сдвигается назад)
+    std::vector<int> dirty_students; // Измененные студенты: КС-40 - [0, TOTAL_KS40), КС-44 - со сдвигом TOTAL_KS40
+    std::vector<uint8_t> dirty_flags;
+
+    // Студенты, чье состояние менялось с создания или прошлого reset (индексы как у dirty_students): только их
+    // возвращает в начальное состояние reset
+    std::vector<int> touched_students;
+    std::vector<uint8_t> touched_flags;
+    std::mutex checkpoint_mtx; // Последовательность параллельных вызовов checkpoint
+    CheckpointFile checkpoint_file;
+    std::vector<std::pair<int, CheckpointRecord>> checkpoint_staging;
+    size_t last_checkpoint_records = 0;
+
+    RoomEventHub events; // Подписчики на события класса
+
+    // Размещение: процессоры потоков класса и счетчики numastat на момент создания
+    int placement_node;
+    std::vector<int> placement_cpus;
+    std::atomic<int> pinned_threads{0};
+    uint64_t placement_serial; // Номер класса для потоков, уже привязанных к его процессорам
+    std::mutex pinned_mtx;
+    std::vector<std::thread::id> pinned_ids; // Разные привязанные потоки (защищено pinned_mtx)
+    NumaCounters counters_at_start;
 
     // Доп методы
     int getRandomTime();
     bool canStartClass(int group);
+    int presentCount(int group) const;
+    void addPresent(int group, int delta);
+    bool tryEnterWithoutLock(int group, int student_id, int& visits_before);
+    bool waitInLobby(int group, int student_id, bool attending, std::chrono::steady_clock::time_point deadline);
+    void notifyLobbyLocked();
     void startClassLocked(int group);
+    void endClassLocked();
+    void teacherLoop();
+    std::chrono::steady_clock::time_point traceNow() const;
+    void traceSpan(TraceRecorder::Span span, int group, int id, std::chrono::steady_clock::time_point begin);
+    void setSessionStateLocked(bool in_session, int group);
+    void releaseSeatLocked();
+    void enterRoomLocked(int group, int student_id);
+    bool leaveRoomLocked(int group, int student_id, RoomEventKind kind);
+    void retreatLocked(std::unique_lock<RoomMutex>& lock, int group, int student_id, AttemptOutcome outcome,
+                       bool seat_freed, bool single_attempt);
+    void pushWaitingLocked(int group, int student_id);
+    bool removeWaitingLocked(int group, int student_id);
+    bool joinSeatQueueLocked(int group);
+    void leaveSeatQueueLocked(int group);
+    int nextWaitingGroupLocked();
+    int stageNextGroupLocked();
+    void admitWaitingLocked();
+    void creditVisitLocked(int group, int student_id);
+    void markDirtyLocked(int group, int student_id);
+    void markTouchedLocked(int index);
+    void sleepUnlessStopped(std::chrono::milliseconds duration);
+    void beginBackoffLocked(int group, int student_id);
+    void publishLocked(RoomEventKind kind, int group, int student_id, int value = 0);
+    void pinWorker();
+    AttemptOutcome runStudent(int group, int student_id, bool single_attempt);
+    void setWaitState(int group, int student_id, StudentWaitKind kind);
+    long long msSinceEpoch(std::chrono::steady_clock::time_point time) const;
+    CheckpointRecord checkpointRecordLocked(int index) const;
+    StudentLatency& latencyOf(int group);
+    static uint64_t microsecondsSince(std::chrono::steady_clock::time_point begin);
+    void waitSessionEndLocked(std::unique_lock<RoomMutex>& lock);
+    bool waitSessionStartLocked(std::unique_lock<RoomMutex>& lock, std::chrono::steady_clock::time_point deadline);
 
 
 public:
@@ -43,9 +304,25 @@ public:
      * @brief Конструктор класса ComputerRoom
      * 
      * Инициализирует векторы для хранения информации о студентах и устанавливает начальное состояние компьютерного класса.
+     * 
+     * @param config Параметры класса (вместимость, размеры групп, пороги начала занятия)
+     */
+    explicit ComputerRoom(const RoomConfig& config = RoomConfig());
+
+    /**
+     * @brief Деструктор класса ComputerRoom
+     * 
+     * Останавливает класс и дожидается завершения потока преподавателя.
      */
-    ComputerRoom();
+    ~ComputerRoom();
     
+    /**
+     * @brief Подключает запись временной шкалы ожиданий, занятий и удержания мьютекса
+     * 
+     * @param recorder Буфер интервалов или nullptr, чтобы отключить запись. Вызывается до запуска студентов.
+     */
+    void setTracer(TraceRecorder* recorder);
+
     /**
      * @brief Останавливает все потоки студентов
      * 
@@ -53,6 +330,19 @@ public:
      */
     void stop();
 
+    /**
+     * @brief Возвращает класс в начальное состояние без освобождения памяти и перезапуска преподавателя
+     * 
+     * Сбрасываются только студенты, чье состояние менялось с создания или прошлого reset, поэтому стоимость
+     * пропорциональна числу затронутых студентов, а не размеру групп. Счетчики, гистограммы и время работы
+     * (загрузка, epoch) отсчитываются заново, флаг остановки снимается. Подписки на события, запись временной шкалы
+     * и размещение сохраняются; следующая контрольная точка в тот же файл перезаписывает сброшенных студентов.
+     * 
+     * Вызывается, когда ни один поток не находится в studentBehavior или visitOnce: после stop() и выхода студентов
+     * или до первого запуска.
+     */
+    void reset();
+
     
     /**
      * @brief Поведение студента в компьютерном классе
@@ -63,13 +353,178 @@ public:
      * Метод моделирует поведение студента: попытки войти в класс, ожидание начала занятия, получение посещений и выход из класса.
      */
     void studentBehavior(int group, int student_id); 
+
+    /**
+     * @brief Одна попытка студента: дождаться места, дождаться занятия не дольше S мс и досидеть его или выйти
+     * 
+     * В отличие от studentBehavior не повторяет попытку и не делает паузу после выхода. Вызывающий гарантирует,
+     * что для одного студента одновременно выполняется не больше одной попытки (и не работает studentBehavior).
+     * 
+     * @param group Номер группы (1 - КС-40, 2 - КС-44)
+     * @param student_id Идентификатор студента в группе
+     * @return Исход попытки
+     */
+    AttemptOutcome visitOnce(int group, int student_id);
+
+    /**
+     * @brief Вход студента без ожидания: место и присутствие, как у студента, вошедшего под мьютексом
+     * 
+     * Вход может набрать порог и начать занятие, во время занятия группы студенту засчитывается посещение. Дальше
+     * студент в классе как любой другой: начало занятия другой группы его выгоняет, конец занятия - выводит.
+     * Вызывающий гарантирует, что для студента не выполняется попытка (studentBehavior или visitOnce).
+     * 
+     * @param group Номер группы (1 - КС-40, 2 - КС-44)
+     * @param student_id Идентификатор студента в группе
+     * @return true если студент вошел, false если мест нет, идет занятие другой группы или студент уже в классе
+     */
+    bool enterStudent(int group, int student_id);
+
+    /**
+     * @brief Выход студента, вошедшего через enterStudent
+     * 
+     * @return false, если класс уже вывел студента (выгон или конец занятия) и выходить не из чего
+     */
+    bool leaveStudent(int group, int student_id);
+
+    /**
+     * @brief Быстрый путь входа: пытается занять место одной CAS-операцией без захвата мьютекса
+     * 
+     * @param group Номер группы (1 - КС-40, 2 - КС-44)
+     * @return true если место занято, false если класс заполнен или идет занятие другой группы
+     */
+    bool tryAcquireSeat(int group);
+
+    /**
+     * @brief Освобождает место, занятое через tryAcquireSeat
+     * 
+     * Мьютекс захватывается только если есть студенты, ожидающие свободного места.
+     */
+    void releaseSeat();
+
+    /**
+     * @brief Текущее кол-во занятых мест (чтение без блокировки)
+     */
+    int currentOccupancy() const;
+
+    /**
+     * @brief Группа, занимающая класс (0 - нет, 1 - КС-40, 2 - КС-44), чтение без блокировки
+     */
+    int currentGroup() const;
+
+    /**
+     * @brief Идет ли сейчас занятие (чтение без блокировки)
+     */
+    bool classInSession() const;
+
+    /**
+     * @brief Кол-во захватов мьютекса с момента создания класса, включая повторные захваты после пробуждения
+     */
+    long long lockAcquisitions() const;
+
+    /**
+     * @brief Кол-во начавшихся занятий
+     */
+    int sessionsStarted() const;
+
+    /**
+     * @brief Снимок счетчиков класса без захвата мьютекса (для мониторинга во время работы)
+     */
+    RoomMetrics metrics() const;
+
+    /**
+     * @brief Гистограмма времени ожидания захвата мьютекса студентами, нс
+     */
+    const LatencyHistogram& lockWaitHistogram() const;
+
+    /**
+     * @brief Распределения задержек студентов группы (можно читать во время работы)
+     * 
+     * @param group Номер группы (1 - КС-40, 2 - КС-44)
+     */
+    const StudentLatency& studentLatency(int group) const;
+
+    /**
+     * @brief Текущее ожидание студента без захвата мьютекса (для сторожевого потока)
+     * 
+     * @param group Номер группы (1 - КС-40, 2 - КС-44)
+     * @param student_id Идентификатор студента в группе
+     */
+    StudentWait studentWait(int group, int student_id) const;
+
+    /**
+     * @brief Записывает контрольную точку состояния класса в файл
+     * 
+     * Состояние снимается за один захват мьютекса; в файл записываются только студенты, изменившиеся с прошлой
+     * точки в тот же файл (первая точка в файл записывает всех). Сохраняются счетчики, посещения, флаги присутствия
+     * и посещения текущего занятия, время окончания занятия и пауз студентов.
+     * 
+     * @param path Путь к файлу
+     * @return true, если точка записана и сброшена на диск
+     */
+    bool checkpoint(const std::string& path);
+
+    /**
+     * @brief Восстанавливает состояние из контрольной точки, вызывается до запуска студентов
+     * 
+     * Файл отображается в память только для чтения. Посещения, счетчики, текущее занятие с оставшимся временем и
+     * паузы студентов продолжаются с момента точки; все счетчики, включая захваты мьютекса, принимают значения точки. Присутствие не восстанавливается: места принадлежат потокам,
+     * поэтому студенты заходят заново, а флаг посещения не дает засчитать текущее занятие повторно.
+     * 
+     * @param path Путь к файлу
+     * @return false, если файла нет, он поврежден или записан для других размеров групп
+     */
+    bool restore(const std::string& path);
+
+    /**
+     * @brief Кол-во записей студентов, записанных последней контрольной точкой
+     */
+    size_t lastCheckpointRecords() const;
     
+    /**
+     * @brief Фактическое размещение класса: узел, процессоры, привязанные потоки и узлы страниц состояния
+     */
+    PlacementReport placementReport() const;
+
+    /**
+     * @brief Подписывает на события класса (вход, выход, выгон, посещение, начало и конец занятия, завершение)
+     * 
+     * Можно вызывать во время работы. Публикация не блокирует студентов: если подписчик не успевает забирать
+     * события через drain, они отбрасываются или объединяются согласно policy.
+     * 
+     * @param capacity Размер очереди подписки
+     * @param policy Поведение при переполнении очереди
+     */
+    std::shared_ptr<EventSubscription> subscribe(size_t capacity = 4096, OverflowPolicy policy = OverflowPolicy::Drop);
+
+    /**
+     * @brief Отменяет подписку, события в ней остаются доступны для drain
+     */
+    void unsubscribe(const std::shared_ptr<EventSubscription>& subscription);
+
     /**
      * @brief Проверяет, все ли студенты выполнили требования по посещениям
      * 
      * @return true если все студенты посетили минимум 2 занятия, false в обратном случае
      */
     bool allStudentsCompleted();
+
+    /**
+     * @brief Кол-во студентов группы с указанным кол-вом посещений за O(1)
+     * 
+     * @param group Номер группы (1 - КС-40, 2 - КС-44)
+     * @param visits Кол-во посещений (2 - набравшие 2 и больше)
+     */
+    int studentsWithVisits(int group, int visits);
+
+    /**
+     * @brief Студенты группы, еще не набравшие 2 посещений: сначала без посещений, затем с одним
+     * 
+     * Обходятся только отстающие студенты, а не весь список группы.
+     * 
+     * @param group Номер группы (1 - КС-40, 2 - КС-44)
+     * @param limit Максимальное кол-во возвращаемых студентов
+     */
+    std::vector<int> laggingStudents(int group, size_t limit = SIZE_MAX);
     
     /**
      * @brief Выводит подробную статистику посещений
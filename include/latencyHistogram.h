@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Гистограмма задержек с логарифмически-линейными корзинами
+ *
+ * Каждая степень двойки делится на SUB_BUCKETS равных корзин (относительная погрешность не больше 1/SUB_BUCKETS, как у HDR
+ * с двумя значащими цифрами). Запись - одна атомарная операция над корзиной без блокировок и выделения памяти, чтение
+ * возможно параллельно с записью. Гистограммы с одинаковой сеткой корзин складываются через merge().
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKETS = 64 * SUB_BUCKETS;
+
+    /**
+     * @brief Записывает значение (обычно задержку в наносекундах)
+     */
+    void record(uint64_t value);
+
+    /**
+     * @brief Кол-во записанных значений
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Сумма записанных значений
+     */
+    uint64_t sum() const;
+
+    /**
+     * @brief Максимальное записанное значение
+     */
+    uint64_t max() const;
+
+    /**
+     * @brief Значение перцентиля (верхняя граница корзины, не больше max)
+     *
+     * @param percentile Перцентиль от 0 до 100
+     * @return Значение или 0, если гистограмма пуста
+     */
+    uint64_t percentile(double percentile) const;
+
+    /**
+     * @brief Добавляет к гистограмме все значения другой гистограммы
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Обнуляет гистограмму без освобождения памяти (не параллельно с record)
+     */
+    void reset();
+
+private:
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+    void raiseMax(uint64_t value);
+
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> total_count{0};
+    std::atomic<uint64_t> total_sum{0};
+    std::atomic<uint64_t> max_value{0};
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include "roomConfig.h"
+
+/**
+ * @brief Аналитическая оценка времени, за которое все студенты набирают посещения
+ */
+struct MarkovEstimate {
+    bool feasible = false; // Занятия вообще могут начинаться (пороги не больше вместимости и размеров групп)
+    double expected_sessions = 0.0; // Ожидаемое кол-во занятий до завершения
+    double expected_ms = 0.0; // Ожидаемое время завершения, мс
+    double session_gap_ms = 0.0; // Средняя задержка между концом занятия и началом следующего, мс
+    double switch_probability = 0.0; // Доля занятий, после которых следующее занятие - у другой группы
+    std::vector<double> completion_cdf; // completion_cdf[t] - вероятность завершить не позже начала t-го занятия
+    std::vector<double> completion_ms; // completion_ms[t] - время начала t-го занятия, мс
+
+    /**
+     * @brief Перцентиль времени завершения, мс (-1, если перцентиль не достигается в пределах модели)
+     *
+     * @param percentile Перцентиль от 0 до 100
+     */
+    double percentileMs(double percentile) const;
+};
+
+/**
+ * @brief Редуцированная марковская модель класса
+ *
+ * Модель состоит из двух частей, которые при заданной последовательности занятий независимы:
+ * - цепь групп занятий: после занятия группы g класс заполняют заблокированные студенты (вся другая группа и
+ *   не попавшие на занятие студенты g) в случайном порядке, и занятие получает группа, первой набравшая порог.
+ *   Если класс заполнился без занятия, состав класса обновляется по одному студенту (см. refreshChain);
+ * - цепь посещений группы по состояниям (кол-во студентов с 0 и с 1 посещением, требуется 2 посещения, как в
+ *   allStudentsCompleted): на каждом занятии группы посещение получают min(capacity, размер группы) случайных
+ *   студентов группы (гипергеометрический переход).
+ * Распределение числа занятий до завершения считается свёрткой этих цепей, время - как время начала последнего
+ * нужного занятия. Модель не учитывает дозаход студентов после паузы и неполные занятия и предполагает случайный
+ * порядок входа (в RoomSimulator студенты обходятся по кругу), поэтому ее ошибка растет, когда вместимость
+ * близка к порогам. Решение занимает единицы миллисекунд.
+ */
+class MarkovEstimator {
+public:
+    static constexpr int MAX_SESSIONS = 400; // Горизонт модели в занятиях
+
+    explicit MarkovEstimator(const RoomConfig& config);
+
+    /**
+     * @brief Решает модель
+     */
+    MarkovEstimate estimate() const;
+
+private:
+    RoomConfig config;
+
+    std::vector<double> groupCompletionCdf(int group_size) const;
+    void race(int pool_ks40, int pool_ks44, double& win_ks40, double& win_ks44, std::vector<double>& fail) const;
+    bool refreshChain(std::vector<double>& win_ks40, std::vector<double>& time_ms) const;
+};
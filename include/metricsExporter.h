@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include "computerRoom.h"
+
+/**
+ * @brief Фоновый экспортер метрик класса в текстовом формате Prometheus
+ *
+ * Отвечает на любой HTTP-запрос к локальному TCP- или Unix-сокету текущим снимком метрик.
+ * Читает только атомарные счетчики ComputerRoom, поэтому опрос никогда не захватывает мьютекс класса.
+ */
+class MetricsExporter {
+public:
+    explicit MetricsExporter(const ComputerRoom& room);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * @brief Запускает экспортер на 127.0.0.1
+     *
+     * @param port Порт (0 - выбрать свободный, см. port())
+     * @return true, если сокет открыт и поток запущен
+     */
+    bool startTcp(int port);
+
+    /**
+     * @brief Запускает экспортер на Unix-сокете (существующий файл сокета заменяется)
+     *
+     * @param path Путь к сокету
+     * @return true, если сокет открыт и поток запущен
+     */
+    bool startUnix(const std::string& path);
+
+    /**
+     * @brief Останавливает поток экспортера и закрывает сокет
+     */
+    void stop();
+
+    /**
+     * @brief Фактический TCP-порт после startTcp (0, если экспортер не запущен на TCP)
+     */
+    int port() const;
+
+    /**
+     * @brief Текущие метрики в текстовом формате Prometheus
+     */
+    std::string render() const;
+
+private:
+    bool startListening(int fd);
+    void serveLoop();
+    void serveClient(int client) const;
+
+    const ComputerRoom& room;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    int listen_fd = -1;
+    int bound_port = 0;
+    std::string unix_path;
+};
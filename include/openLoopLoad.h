@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "roomConfig.h"
+#include "latencyHistogram.h"
+
+/**
+ * @brief Процесс прибытия студентов
+ */
+enum class ArrivalProcess : uint8_t {
+    Poisson, // Экспоненциальные интервалы со средней частотой rate_per_s
+    Bursty, // Пачки по burst_size студентов, пачки приходят по Пуассону с частотой rate_per_s / burst_size
+    Trace // Моменты прибытия из trace_ms
+};
+
+/**
+ * @brief Настройки открытой нагрузки
+ */
+struct LoadOptions {
+    ArrivalProcess process = ArrivalProcess::Poisson;
+    double rate_per_s = 10.0; // Средняя частота прибытий, попыток в секунду
+    int burst_size = 10; // Размер пачки для ArrivalProcess::Bursty
+    std::vector<int> trace_ms; // Моменты прибытий от начала для ArrivalProcess::Trace, мс
+    int duration_ms = 10000; // Длительность подачи нагрузки, мс
+    int drain_ms = 5000; // Сколько ждать завершения начатых и ожидающих попыток после конца подачи, мс
+    uint64_t seed = 1; // Зерно процесса прибытий и выбора студентов
+};
+
+/**
+ * @brief Результат прогона открытой нагрузки
+ *
+ * Задержка отсчитывается от запланированного момента прибытия, а не от фактического начала попытки, поэтому
+ * ожидание свободного студента и опоздание генератора входят в задержку (без coordinated omission).
+ * Попытки, не завершившиеся к концу drain_ms, записываются в latency_us с задержкой до конца прогона.
+ */
+struct LoadResult {
+    double offered_rate = 0.0; // Запланированная частота прибытий, попыток в секунду
+    int offered = 0; // Запланировано прибытий
+    int completed = 0; // Завершено попыток
+    int attended = 0; // Попыток, закончившихся посещением занятия
+    int timed_out = 0; // Попыток, закончившихся уходом после S мс ожидания
+    int evicted = 0; // Попыток, закончившихся выгоном
+    int rejected = 0; // Попыток, отклоненных ограничением очереди ожидания места
+    int unfinished = 0; // Попыток, не начатых или не завершенных к концу прогона
+    int sessions = 0; // Проведено занятий
+    double elapsed_s = 0.0; // Длительность прогона, с
+    double throughput = 0.0; // Завершенных попыток в секунду
+    double visit_rate = 0.0; // Засчитанных посещений в секунду
+    LatencyHistogram latency_us; // От запланированного прибытия до исхода попытки, мкс
+    LatencyHistogram attended_latency_us; // То же для попыток с посещением, мкс
+};
+
+/**
+ * @brief Точка кривой нагрузки
+ */
+struct LoadPoint {
+    double rate_per_s = 0.0;
+    uint64_t p50_us = 0;
+    uint64_t p99_us = 0;
+    uint64_t max_us = 0;
+    double throughput = 0.0;
+    double visit_rate = 0.0;
+    int offered = 0;
+    int unfinished = 0;
+};
+
+/**
+ * @brief Генератор открытой нагрузки на компьютерный класс
+ *
+ * Вместо замкнутого цикла studentBehavior попытки (visitOnce) прибывают по расписанию независимо от того,
+ * успевает ли класс. Группа прибытия выбирается пропорционально размеру группы, попытку выполняет свободный
+ * студент этой группы; если свободных нет, прибытие ждет в очереди группы. Каждый студент - отдельный поток,
+ * одновременно у студента не больше одной попытки.
+ */
+class OpenLoopGenerator {
+public:
+    /**
+     * @brief Запланированные моменты прибытий от начала прогона, мкс
+     */
+    static std::vector<int64_t> arrivals(const LoadOptions& options);
+
+    /**
+     * @brief Читает моменты прибытий для ArrivalProcess::Trace: по одному числу мс на строку
+     *
+     * @return false, если файл не открылся или содержит не число
+     */
+    static bool loadTrace(const std::string& path, std::vector<int>& trace_ms);
+
+    /**
+     * @brief Подает нагрузку на новый класс с параметрами config
+     *
+     * @param result Результат (гистограммы не копируются, поэтому заполняется переданный объект)
+     */
+    static void run(const RoomConfig& config, const LoadOptions& options, LoadResult& result);
+
+    /**
+     * @brief Кривая задержек и пропускной способности по возрастающим частотам прибытий
+     */
+    static std::vector<LoadPoint> sweep(const RoomConfig& config, const LoadOptions& options, const std::vector<double>& rates);
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "computerRoom.h"
+
+/**
+ * @brief Итоги одного прогона пакетного запуска
+ */
+struct BatchRunSummary {
+    int run = 0; // Номер прогона с 1
+    bool completed = false; // Все студенты набрали 2 посещения до таймаута
+    double elapsed_ms = 0.0; // От запуска студентов до завершения или таймаута, мс
+    double reset_us = 0.0; // Длительность ComputerRoom::reset перед прогоном, мкс
+    int sessions = 0; // Начато занятий
+    int prestaged_sessions = 0; // Из них начато сразу после предыдущего
+    long long visits = 0; // Засчитано посещений
+    int completed_ks40 = 0;
+    int completed_ks44 = 0;
+    long long lock_acquisitions = 0;
+    long long lock_free_visits = 0; // Посещений, прошедших целиком без мьютекса класса
+    long long wakeups = 0;
+    long long seat_rejections = 0;
+    long long seat_timeouts = 0;
+    double utilisation = 0.0; // Доля времени прогона, занятая занятиями
+    uint64_t completion_p50_ms = 0; // Время до второго посещения по обеим группам, мс
+    uint64_t completion_p99_ms = 0;
+};
+
+/**
+ * @brief Пакетный запуск симуляций на одном классе без вывода событий
+ *
+ * Класс и потоки студентов (по одному на студента, как в main) создаются один раз. Перед каждым прогоном класс
+ * возвращается в начальное состояние через ComputerRoom::reset, и пул заново запускает studentBehavior; после
+ * завершения всех студентов или таймаута класс останавливается, и пул ждет выхода студентов из studentBehavior.
+ * Поэтому прогоны подряд не платят за выделение состояния, запуск потоков и вывод в консоль.
+ */
+class RoomBatchRunner {
+public:
+    /**
+     * @param config Параметры класса (вывод событий отключается)
+     */
+    explicit RoomBatchRunner(const RoomConfig& config);
+    ~RoomBatchRunner();
+
+    RoomBatchRunner(const RoomBatchRunner&) = delete;
+    RoomBatchRunner& operator=(const RoomBatchRunner&) = delete;
+
+    /**
+     * @brief Выполняет один прогон: сброс класса, запуск студентов пула, ожидание завершения, остановка
+     *
+     * @param timeout_ms Макс. длительность прогона, мс
+     */
+    BatchRunSummary runOnce(int timeout_ms);
+
+    /**
+     * @brief Выполняет runs прогонов подряд и пишет в out по строке JSON на прогон
+     *
+     * @return Кол-во прогонов, завершившихся до таймаута
+     */
+    int run(int runs, int timeout_ms, std::ostream& out);
+
+    /**
+     * @brief Записывает итоги прогона одной строкой JSON (без перевода строки)
+     */
+    static void writeJson(std::ostream& out, const BatchRunSummary& summary);
+
+    ComputerRoom& room();
+
+private:
+    void studentLoop(int group, int student_id);
+
+    ComputerRoom batch_room;
+    int total_students;
+    int runs_done = 0;
+    LatencyHistogram completion_us; // Время до второго посещения обеих групп последнего прогона
+
+    // Пул студентов: прогон запускается сменой поколения, конец прогона - выход всех студентов
+    std::vector<std::thread> students;
+    std::mutex pool_mtx;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    uint64_t generation = 0;
+    int running = 0; // Студентов внутри studentBehavior
+    bool closing = false;
+};
+
+/**
+ * @brief Читает параметры класса из файла строк "ключ = значение" (# - комментарий)
+ *
+ * Ключи совпадают с полями RoomConfig: capacity, total_ks40, total_ks44, need_ks40, need_ks44, session_ms,
+ * min_wait_ms, max_wait_ms, retry_delay_ms, batched_admission, wait_list_limit, wait_timeout_ms,
+ * prestage_next_session, lock_free_entry (логические значения - 0/1 или false/true). Не указанные ключи не меняются.
+ *
+ * @return false, если файл не открылся, ключ неизвестен или значение не число
+ */
+bool loadRoomConfig(const std::string& path, RoomConfig& config);
@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+
+/**
+ * @brief Размещение класса на машине с несколькими NUMA-узлами
+ */
+struct RoomPlacement {
+    int numa_node = -1; // Узел для состояния класса и его потоков (-1 - без привязки)
+    std::vector<int> cpus; // Процессоры для потоков класса (пусто - все процессоры numa_node)
+};
+
+/**
+ * @brief Параметры компьютерного класса
+ *
+ * Значения по умолчанию соответствуют варианту 20: класс на 20 мест, группы КС-40 и КС-44.
+ */
+struct RoomConfig {
+    int capacity = 20; // Максимальная вместимость компьютерного класса
+    int total_ks40 = 30; // Общее кол-во студентов в КС-40
+    int total_ks44 = 24; // Общее кол-во студентов в КС-44
+    int need_ks40 = 15; // Необходимое кол-во студентов КС-40 для начала занятия
+    int need_ks44 = 12; // Необходимое кол-во студентов КС-44 для начала занятия
+
+    int session_ms = 5000; // Длительность занятия, мс
+    int min_wait_ms = 1000; // Минимальное время ожидания студентом начала занятия, мс
+    int max_wait_ms = 2000; // Максимальное время ожидания студентом начала занятия, мс
+    int retry_delay_ms = 1000; // Пауза студента перед следующей попыткой после выхода из класса, мс
+
+    bool batched_admission = true; // Пакетный впуск ожидающих студентов при освобождении мест и начале занятия
+    int wait_list_limit = 0; // Макс. кол-во студентов группы, ожидающих места; остальные уходят на паузу retry_delay_ms (0 - без ограничения)
+    int wait_timeout_ms = 0; // Макс. время ожидания места, после которого студент уходит на паузу retry_delay_ms, мс (0 - без ограничения)
+    bool prestage_next_session = false; // Выбирать группу следующего занятия по очередям заранее и начинать его сразу после текущего (нужен batched_admission)
+    bool lock_free_entry = true; // Вход в свободный класс, ожидание и занятие без мьютекса класса, если ничто не требует его (нет вывода событий и подписчиков)
+    bool verbose = true; // Вывод событий класса в консоль
+    RoomPlacement placement; // Привязка потоков студентов и преподавателя и памяти класса (по умолчанию - нет)
+};
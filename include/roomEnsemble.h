@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "roomConfig.h"
+#include "roomSimulator.h"
+
+/**
+ * @brief Пакетная модель: LANES независимых прогонов RoomSimulator в одном проходе по студентам
+ *
+ * Состояние хранится по полосам: для каждого студента - массив из LANES значений фазы, таймера, посещений и
+ * генератора, для класса - массивы заполненности, присутствующих по группам, группы и конца занятия. Прогоны
+ * идут в одном виртуальном времени, а порядок обхода студентов в такте у всех прогонов одинаков, поэтому ветви
+ * RoomSimulator::run заменяются масками по полосам, и внутренние циклы по полосам без ветвлений векторизуются
+ * компилятором (при сборке с оптимизацией). Редкие события - начало и конец занятия - обходят всех студентов
+ * только если они произошли хотя бы в одной полосе.
+ *
+ * Результат каждого прогона совпадает с RoomSimulator::run с тем же зерном и отсечкой. Маскированный шаг по всем
+ * полосам дороже пропусков скалярной модели, поэтому пакетная модель не быстрее RoomSimulator и включается только
+ * явно (PlanOptions::lockstep_ensemble, --ensemble в режиме планирования) - для сверки двух реализаций модели.
+ */
+class RoomEnsemble {
+public:
+    static constexpr int LANES = 8; // Прогонов в одном проходе: 8 полос int32 - один регистр AVX2
+
+    /**
+     * @brief Конструктор класса RoomEnsemble
+     *
+     * @param config Параметры класса
+     */
+    explicit RoomEnsemble(const RoomConfig& config);
+
+    /**
+     * @brief Выполняет прогоны для всех зерен пакетами по LANES
+     *
+     * @param seeds Зерна прогонов (кол-во не обязано быть кратно LANES)
+     * @param cutoff_ms Отсечка, как в RoomSimulator::run
+     * @return Результаты в порядке зерен
+     */
+    std::vector<SimResult> run(const std::vector<uint64_t>& seeds, int cutoff_ms);
+
+    /**
+     * @brief Выполняет LANES прогонов с зернами seeds[0..LANES) и записывает результаты в results[0..LANES)
+     */
+    void runLanes(const uint64_t* seeds, int cutoff_ms, SimResult* results);
+
+    /**
+     * @brief Длительность такта модели, мс (та же, что у RoomSimulator)
+     */
+    int tickMs() const;
+
+private:
+    struct alignas(32) LaneInts {
+        int32_t v[LANES];
+    };
+    struct alignas(64) LaneRandoms {
+        uint64_t v[LANES];
+    };
+
+    // Фазы студента, те же, что в RoomSimulator
+    enum Phase : int32_t {
+        READY,
+        BLOCKED,
+        IN_ROOM,
+        ATTENDING,
+        BACKOFF
+    };
+
+    RoomConfig config;
+    int tick_ms;
+    int session_ticks;
+    int min_wait_ticks;
+    int max_wait_ticks;
+    int retry_ticks;
+
+    // Состояние студентов по полосам, выделяется один раз и переиспользуется между пакетами
+    std::vector<int> group_of;
+    std::vector<LaneInts> phase;
+    std::vector<LaneInts> timer;
+    std::vector<LaneInts> visits;
+    std::vector<LaneRandoms> rng;
+
+    // Состояние классов по полосам
+    LaneInts occupancy;
+    LaneInts present[3];
+    LaneInts session_group;
+    LaneInts session_end;
+    LaneInts lagging;
+    LaneInts sessions;
+
+    void endSessions(int now, const int32_t* ending);
+    void startSessions(int group, int now, const int32_t* starting);
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Вид события класса
+ */
+enum class RoomEventKind : uint8_t {
+    Entered, // Студент вошел в класс (сам или пакетным впуском)
+    Left, // Студент вышел: не дождался начала занятия или занятие закончилось
+    Evicted, // Студента, находившегося в классе, выгнали из-за занятия другой группы
+    VisitCredited, // Студенту засчитано посещение, value - всего посещений
+    SessionStarted, // Началось занятие группы, student_id - номер занятия, value - студентов в классе
+    SessionEnded, // Занятие закончилось, student_id - номер занятия, value - вышло студентов
+    Completed // Студент набрал 2 посещения
+};
+
+/**
+ * @brief Событие класса
+ */
+struct RoomEvent {
+    uint64_t seq = 0; // Порядковый номер события в классе (у объединенных - последнего из них)
+    int64_t time_us = 0; // Время события, мкс от начала работы класса
+    RoomEventKind kind = RoomEventKind::Entered;
+    int8_t group = 0; // Группа (1 - КС-40, 2 - КС-44)
+    int student_id = 0; // Студент в группе (для событий занятия - номер занятия)
+    int value = 0; // Зависит от вида события
+    uint32_t count = 1; // Сколько событий объединено в это (больше 1 только при OverflowPolicy::Coalesce)
+};
+
+/**
+ * @brief Что делать с событием, если подписчик не успевает забирать события и очередь заполнена
+ */
+enum class OverflowPolicy : uint8_t {
+    Drop, // Отбросить событие и увеличить счетчик отброшенных
+    Coalesce // Объединить с другими событиями того же вида и группы: подписчик получит последнее и их кол-во
+};
+
+/**
+ * @brief Подписка на события класса: ограниченная очередь с одним производителем и несколькими потребителями
+ *
+ * Производитель - класс: события публикуются под мьютексом класса, поэтому в каждый момент пишет один поток.
+ * Очередь - кольцевой буфер с порядковым номером в каждой ячейке: публикация не ждет и не выделяет память,
+ * потребители забирают события пачками через drain из любого кол-ва потоков, захватывая диапазон ячеек CAS.
+ *
+ * При Coalesce переполнение переводит подписку в режим объединения: события складываются в ячейки по (вид, группа),
+ * и drain отдает их после содержимого очереди, упорядочив пачку по seq. Производитель возвращается к очереди только
+ * после того, как потребители забрали все объединенные события, поэтому у одного потребителя seq событий возрастает.
+ */
+class EventSubscription {
+public:
+    /**
+     * @brief Конструктор подписки
+     *
+     * @param capacity Размер очереди (округляется вверх до степени двойки)
+     * @param policy Поведение при переполнении
+     */
+    EventSubscription(size_t capacity, OverflowPolicy policy);
+
+    EventSubscription(const EventSubscription&) = delete;
+    EventSubscription& operator=(const EventSubscription&) = delete;
+
+    /**
+     * @brief Публикует событие, не блокируется. Вызывается только одним потоком одновременно.
+     */
+    void publish(const RoomEvent& event);
+
+    /**
+     * @brief Забирает до max_events событий
+     *
+     * @param events Куда записать события
+     * @param max_events Сколько событий можно записать
+     * @return Кол-во записанных событий
+     */
+    size_t drain(RoomEvent* events, size_t max_events);
+
+    /**
+     * @brief Забирает до max_events событий, добавляя их в конец вектора
+     */
+    size_t drain(std::vector<RoomEvent>& events, size_t max_events);
+
+    /**
+     * @brief Кол-во событий, отброшенных при OverflowPolicy::Drop
+     */
+    uint64_t dropped() const;
+
+    /**
+     * @brief Кол-во событий, попавших в объединение при OverflowPolicy::Coalesce
+     */
+    uint64_t coalesced() const;
+
+    OverflowPolicy policy() const;
+    size_t capacity() const;
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> sequence{0};
+        RoomEvent event;
+    };
+
+    // Ячейка объединения: последнее событие пишется под seqlock-счетчиком version по атомарным словам,
+    // чтобы чтение во время записи не было гонкой данных
+    static constexpr size_t EVENT_WORDS = (sizeof(RoomEvent) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    struct alignas(64) CoalesceSlot {
+        std::atomic<uint32_t> version{0};
+        std::atomic<uint32_t> pending{0};
+        std::atomic<uint64_t> latest[EVENT_WORDS] = {};
+    };
+    static constexpr int KINDS = 7;
+    static constexpr int SLOTS = KINDS * 3;
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    OverflowPolicy overflow_policy;
+
+    alignas(64) uint64_t tail = 0; // Следующая позиция записи, меняется только производителем
+    alignas(64) std::atomic<uint64_t> head{0}; // Следующая позиция чтения, потребители сдвигают ее CAS
+    std::atomic<bool> coalescing{false}; // Меняется только производителем
+    std::atomic<uint64_t> dropped_count{0};
+    std::atomic<uint64_t> coalesced_count{0};
+    CoalesceSlot slots[SLOTS];
+
+    bool tryPush(const RoomEvent& event);
+    void coalesce(const RoomEvent& event);
+    bool coalescedDrained() const;
+    size_t drainCoalesced(RoomEvent* events, size_t max_events);
+};
+
+/**
+ * @brief Подписчики класса, публикация рассылает событие в каждую подписку
+ *
+ * Список меняется и обходится под мьютексом класса.
+ */
+class RoomEventHub {
+public:
+    std::shared_ptr<EventSubscription> subscribe(size_t capacity, OverflowPolicy policy);
+    void unsubscribe(const std::shared_ptr<EventSubscription>& subscription);
+
+    /**
+     * @brief Есть ли подписчики (без подписчиков события не формируются)
+     */
+    bool active() const { return !subscriptions.empty(); }
+
+    /**
+     * @brief Присваивает событию seq и рассылает его
+     */
+    void publish(RoomEvent event);
+
+private:
+    std::vector<std::shared_ptr<EventSubscription>> subscriptions;
+    uint64_t next_seq = 0;
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "roomConfig.h"
+
+/**
+ * @brief Топология NUMA, прочитанная из /sys/devices/system/node
+ *
+ * На системах без NUMA (или не Linux) - один узел со всеми процессорами.
+ */
+class NumaTopology {
+public:
+    /**
+     * @brief Определяет топологию текущей машины
+     */
+    static NumaTopology detect();
+
+    int nodeCount() const;
+
+    /**
+     * @brief Процессоры узла (пустой список для несуществующего узла)
+     */
+    const std::vector<int>& cpusOf(int node) const;
+
+    /**
+     * @brief Узел процессора (-1, если процессор не найден)
+     */
+    int nodeOfCpu(int cpu) const;
+
+    /**
+     * @brief Размещение для i-го из нескольких классов: классы распределяются по узлам по кругу
+     */
+    RoomPlacement placementForRoom(int room_index) const;
+
+    /**
+     * @brief Узлы прочитаны из ОС (false - запасной вариант с одним узлом)
+     */
+    bool fromSystem() const;
+
+private:
+    std::vector<std::vector<int>> node_cpus;
+    bool from_system = false;
+};
+
+/**
+ * @brief Привязывает текущий поток к процессорам
+ *
+ * @return false, если список пуст или ОС не поддерживает привязку
+ */
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+/**
+ * @brief Узел NUMA, на котором находится страница адреса (-1, если ОС этого не сообщает)
+ *
+ * Страница должна быть уже выделена (записана хотя бы раз).
+ */
+int pageNode(const void* address);
+
+/**
+ * @brief Счетчики выделения страниц ядром по всем узлам (/sys/devices/system/node/node<N>/numastat)
+ */
+struct NumaCounters {
+    bool available = false; // Счетчики доступны в ОС
+    long long local_node = 0; // Страницы, выделенные процессу на его узле
+    long long other_node = 0; // Страницы, выделенные процессу на другом узле
+};
+
+NumaCounters readNumaCounters();
+
+/**
+ * @brief Предпочтительный узел для новых страниц текущего потока на время жизни объекта
+ *
+ * Используется в конструкторе класса: состояние выделяется и обнуляется (первое касание) под политикой узла,
+ * после чего restore возвращает прежнюю политику потока. Уже выделенные malloc страницы не перемещаются,
+ * поэтому привязка памяти - лучшая попытка, фактическое размещение проверяется через pageNode.
+ */
+class MemoryPolicyScope {
+public:
+    explicit MemoryPolicyScope(int node);
+    ~MemoryPolicyScope();
+
+    MemoryPolicyScope(const MemoryPolicyScope&) = delete;
+    MemoryPolicyScope& operator=(const MemoryPolicyScope&) = delete;
+
+    /**
+     * @brief Политика узла была установлена
+     */
+    bool applied() const;
+
+    /**
+     * @brief Возвращает прежнюю политику (повторный вызов ничего не делает)
+     */
+    void restore();
+
+private:
+    bool active = false;
+    bool was_applied = false;
+    int old_mode = 0;
+    std::vector<unsigned long> old_mask;
+};
@@ -0,0 +1,289 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "computerRoom.h"
+#include "latencyHistogram.h"
+
+/**
+ * @brief Операции протокола класса-сервиса
+ */
+enum class RoomOp : uint8_t {
+    Status = 0, // Снимок класса: занято мест и группа
+    TryEnter = 1, // Вход студента без ожидания (enterStudent), ответ сразу; студента может выгнать занятие другой группы
+    Leave = 2, // Выход студента, вошедшего через TryEnter по этому соединению
+    Visit = 3, // Одна попытка студента visitOnce, ответ после ее завершения
+    AttachRing = 4, // Перейти на кольца в разделяемой памяти (дескриптор памяти передается с кадром)
+    Doorbell = 5 // В кольце появились кадры (в обе стороны)
+};
+
+/**
+ * @brief Результат запроса
+ */
+enum class RoomStatus : uint8_t {
+    Ok = 0,
+    Refused = 1, // TryEnter: класс заполнен, идет занятие другой группы или класс остановлен
+    Busy = 2, // Visit, TryEnter: у студента уже идет попытка или он вошел через TryEnter
+    BadRequest = 3, // Неизвестная операция, группа или студент
+    Attended = 4, // Исходы Visit, как AttemptOutcome
+    TimedOut = 5,
+    Evicted = 6, // Для Leave: класс уже вывел студента (выгон или конец занятия)
+    Rejected = 7,
+    Stopped = 8
+};
+
+/**
+ * @brief Кадр запроса: 8 байт в порядке байтов хоста (сервис только локальный)
+ *
+ * Клиент может отправлять кадры подряд, не дожидаясь ответов; ответ несет тот же tag. Ответы на быстрые операции
+ * приходят в порядке запросов, ответ на Visit - после завершения попытки.
+ */
+struct RoomRequest {
+    uint32_t tag = 0;
+    uint8_t op = 0;
+    uint8_t group = 0;
+    uint16_t student_id = 0;
+};
+
+/**
+ * @brief Кадр ответа: 8 байт, вместе с результатом - состояние класса в момент ответа
+ */
+struct RoomReply {
+    uint32_t tag = 0;
+    uint8_t op = 0;
+    uint8_t status = 0;
+    uint8_t occupancy = 0;
+    uint8_t group = 0;
+};
+
+static_assert(sizeof(RoomRequest) == 8, "RoomRequest is a fixed 8-byte frame");
+static_assert(sizeof(RoomReply) == 8, "RoomReply is a fixed 8-byte frame");
+
+/**
+ * @brief Кольцо одного производителя и одного потребителя в разделяемой памяти
+ */
+template <typename Frame>
+struct SharedRing {
+    static constexpr uint32_t SLOTS = 4096; // Степень двойки
+    alignas(64) std::atomic<uint32_t> head; // Следующий кадр для чтения (пишет потребитель)
+    alignas(64) std::atomic<uint32_t> tail; // Следующий свободный слот (пишет производитель)
+    alignas(64) Frame frames[SLOTS];
+
+    /**
+     * @brief Кол-во непрочитанных кадров
+     */
+    uint32_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Записывает до count кадров, возвращает кол-во записанных (меньше, если кольцо заполнено)
+     */
+    size_t push(const Frame* source, size_t count) {
+        uint32_t at = tail.load(std::memory_order_relaxed);
+        uint32_t free_slots = SLOTS - (at - head.load(std::memory_order_acquire));
+        size_t written = count < free_slots ? count : free_slots;
+        for (size_t i = 0; i < written; ++i) frames[(at + i) & (SLOTS - 1)] = source[i];
+        tail.store(at + static_cast<uint32_t>(written), std::memory_order_release);
+        return written;
+    }
+
+    /**
+     * @brief Читает до limit кадров в target, возвращает кол-во прочитанных
+     */
+    size_t pop(Frame* target, size_t limit) {
+        uint32_t at = head.load(std::memory_order_relaxed);
+        uint32_t ready = tail.load(std::memory_order_acquire) - at;
+        size_t read = limit < ready ? limit : ready;
+        for (size_t i = 0; i < read; ++i) target[i] = frames[(at + i) & (SLOTS - 1)];
+        head.store(at + static_cast<uint32_t>(read), std::memory_order_release);
+        return read;
+    }
+};
+
+/**
+ * @brief Разделяемая память соединения: кольцо запросов клиента и кольцо ответов сервера
+ */
+struct SharedRings {
+    SharedRing<RoomRequest> requests;
+    SharedRing<RoomReply> replies;
+};
+
+/**
+ * @brief Локальный сервер класса на Unix-сокете: студенты - запросы внешних процессов вместо потоков
+ *
+ * Один поток обслуживает все соединения через epoll. Все кадры, прочитанные из сокета за одно событие,
+ * обрабатываются пакетом, и ответы на них уходят одной записью. Быстрые операции выполняются в цикле событий: Status
+ * читает слово мест без блокировки, TryEnter и Leave - вход и выход студента под мьютексом класса (без ожидания
+ * занятия). Visit - в пуле рабочих потоков (попытка длится до конца занятия), ответ возвращается в цикл через eventfd. После AttachRing кадры идут через кольца в разделяемой памяти
+ * (memfd клиента), а сокет несет только кадры Doorbell. Только Linux, на других ОС start возвращает false.
+ */
+class RoomServer {
+public:
+    /**
+     * @param room Класс, которым управляют клиенты
+     * @param visit_workers Потоков для Visit (0 - по одному на студента: больше попыток одновременно не бывает)
+     */
+    explicit RoomServer(ComputerRoom& room, int visit_workers = 0);
+    ~RoomServer();
+
+    RoomServer(const RoomServer&) = delete;
+    RoomServer& operator=(const RoomServer&) = delete;
+
+    /**
+     * @brief Запускает сервер на Unix-сокете (существующий файл сокета заменяется)
+     *
+     * @param path Путь к сокету
+     * @return true, если сокет открыт и поток запущен
+     */
+    bool start(const std::string& path);
+
+    /**
+     * @brief Останавливает цикл событий и пул, закрывает соединения
+     *
+     * Начатые Visit досиживаются до конца; чтобы не ждать занятия, сначала остановите класс (ComputerRoom::stop).
+     */
+    void stop();
+
+    int connections() const; // Открытых соединений
+    long long requestsServed() const; // Обработанных запросов
+
+private:
+    struct Connection;
+    struct Completion {
+        int fd;
+        uint64_t serial;
+        int student; // Индекс студента в visiting
+        RoomReply reply;
+    };
+    struct VisitJob {
+        int fd;
+        uint64_t serial;
+        RoomRequest request;
+    };
+
+    void eventLoop();
+    void acceptClients();
+    bool readClient(Connection& connection);
+    void handleFrames(Connection& connection, const RoomRequest* frames, size_t count);
+    void handleRequest(Connection& connection, const RoomRequest& request);
+    void attachRing(Connection& connection, const RoomRequest& request);
+    void drainRing(Connection& connection);
+    void sendReply(Connection& connection, const RoomReply& reply);
+    bool flushClient(Connection& connection);
+    void closeClient(int fd);
+    void deliverCompletions();
+    void visitWorker();
+    RoomReply replyTo(const RoomRequest& request, RoomStatus status) const;
+    int studentIndex(int group, int student_id) const;
+
+    ComputerRoom& room;
+    int workers_wanted;
+    int total_ks40;
+    int total_ks44;
+
+    std::thread loop;
+    std::atomic<bool> running{false};
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1; // eventfd: готовы ответы Visit или вызван stop()
+    std::string socket_path;
+    std::vector<std::unique_ptr<Connection>> clients; // По дескриптору сокета
+    std::vector<RoomRequest> read_buffer; // Пакет кадров одного чтения
+    uint64_t next_serial = 1; // Отличает новое соединение на том же дескрипторе от закрытого
+    std::atomic<int> open_connections{0};
+    std::atomic<long long> served{0};
+
+    // Пул Visit: очередь заданий и готовые ответы
+    std::vector<std::thread> workers;
+    std::mutex jobs_mtx;
+    std::condition_variable jobs_cv;
+    std::deque<VisitJob> jobs;
+    bool jobs_closed = false;
+    std::vector<Completion> completions;
+    std::vector<bool> visiting; // У студента идет попытка или он вошел через TryEnter (только в цикле событий)
+};
+
+/**
+ * @brief Клиент сервера класса с блокирующими вызовами (для тестов и однопоточных генераторов нагрузки)
+ */
+class RoomClient {
+public:
+    RoomClient() = default;
+    ~RoomClient();
+
+    RoomClient(const RoomClient&) = delete;
+    RoomClient& operator=(const RoomClient&) = delete;
+
+    bool connect(const std::string& path);
+    void close();
+    int fd() const;
+
+    /**
+     * @brief Отправляет кадры подряд (через кольцо, если оно подключено)
+     */
+    bool send(const RoomRequest* requests, size_t count);
+
+    /**
+     * @brief Ждет count ответов не дольше timeout_ms, возвращает кол-во полученных
+     */
+    size_t receive(RoomReply* replies, size_t count, int timeout_ms);
+
+    /**
+     * @brief Создает кольца в разделяемой памяти и передает их серверу, дальше кадры идут через них
+     */
+    bool attachRing();
+
+    bool ringAttached() const;
+
+private:
+    bool sendFrames(const void* data, size_t bytes);
+
+    int socket_fd = -1;
+    SharedRings* rings = nullptr;
+    std::vector<char> pending; // Принятые байты неполного кадра
+};
+
+/**
+ * @brief Настройки нагрузочного клиента
+ */
+struct BenchOptions {
+    int connections = 1000; // Одновременных соединений
+    int depth = 4; // Запросов в полете на соединение
+    int duration_ms = 2000;
+    int drain_ms = 1000; // Ожидание ответов после конца замера (для Visit - не меньше ожидания и занятия)
+    RoomOp op = RoomOp::TryEnter; // TryEnter (с Leave после входа), Status или Visit
+    int students = 24; // Студентов каждой группы для TryEnter и Visit (номера по ячейкам соединений по кругу)
+    bool ring = false; // Через кольца в разделяемой памяти
+};
+
+/**
+ * @brief Результат нагрузочного клиента
+ */
+struct BenchResult {
+    long long requests = 0; // Получено ответов
+    int connected = 0; // Удалось открыть соединений
+    double elapsed_s = 0.0;
+    double requests_per_s = 0.0;
+    LatencyHistogram latency_us; // От отправки запроса до ответа
+    long long by_status[9] = {}; // Ответов по RoomStatus
+    long long unanswered = 0; // Запросов без ответа к концу ожидания
+    LatencyHistogram attempt_us; // Visit: от запроса до исхода попытки (без ответов Busy)
+};
+
+/**
+ * @brief Нагрузочный клиент: все соединения в одном потоке на epoll, каждое держит depth запросов в полете
+ */
+class ServerBench {
+public:
+    /**
+     * @brief Выполняет замер (результат - выходной параметр: гистограмма не копируется)
+     */
+    static void run(const std::string& path, const BenchOptions& options, BenchResult& result);
+};
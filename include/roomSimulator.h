@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "roomConfig.h"
+
+/**
+ * @brief Результат одного прогона модели класса
+ */
+struct SimResult {
+    bool completed = false; // Все студенты набрали REQUIRED_VISITS посещений до отсечки
+    int completion_ms = 0; // Время, когда последний студент набрал посещения (или время отсечки)
+    int sessions = 0; // Кол-во проведенных занятий
+};
+
+/**
+ * @brief Однопоточная модель компьютерного класса в виртуальном времени
+ *
+ * Повторяет ветви studentBehavior без потоков и реального ожидания: время идет тактами, равными
+ * наибольшему общему делителю длительностей из RoomConfig (для параметров по умолчанию - 1 секунда).
+ * Упрощения относительно ComputerRoom:
+ * - время ожидания начала занятия выбирается из целых тактов в [min_wait_ms, max_wait_ms];
+ * - студенты, не попавшие в класс, повторяют попытку каждый такт, а не по уведомлению;
+ * - после завершения занятия студент сразу уходит на паузу retry_delay_ms.
+ * Прогон полностью определяется зерном, поэтому результаты воспроизводимы.
+ */
+class RoomSimulator {
+public:
+    static constexpr int REQUIRED_VISITS = 2; // Требуемое кол-во посещений, как в allStudentsCompleted
+
+    /**
+     * @brief Конструктор класса RoomSimulator
+     *
+     * @param config Параметры класса
+     */
+    explicit RoomSimulator(const RoomConfig& config);
+
+    /**
+     * @brief Выполняет один прогон модели
+     *
+     * @param seed Зерно генератора случайных чисел
+     * @param cutoff_ms Отсечка: прогон останавливается, если к этому времени не все студенты завершили
+     * @return Результат прогона
+     */
+    SimResult run(uint64_t seed, int cutoff_ms);
+
+    /**
+     * @brief Длительность такта модели, мс
+     */
+    int tickMs() const;
+
+    /**
+     * @brief Генератор случайных чисел студента (xorshift64*), общий для скалярной и пакетной моделей
+     */
+    static uint64_t nextRandom(uint64_t& state);
+
+    /**
+     * @brief Начальное состояние генератора студента по зерну прогона и номеру студента
+     */
+    static uint64_t seedStudent(uint64_t seed, int student);
+
+private:
+    // Фазы студента, соответствующие ветвям studentBehavior
+    enum Phase : uint8_t {
+        READY, // Решает, идти ли на занятие
+        BLOCKED, // Ждет места снаружи
+        IN_ROOM, // В классе ждет начала занятия до дедлайна
+        ATTENDING, // На занятии своей группы
+        BACKOFF // Пауза перед следующей попыткой
+    };
+
+    RoomConfig config;
+    int tick_ms;
+    int session_ticks;
+    int min_wait_ticks;
+    int max_wait_ticks;
+    int retry_ticks;
+
+    // Состояние прогона, выделяется один раз и переиспользуется между прогонами
+    std::vector<uint8_t> phase;
+    std::vector<int> group_of; // Группа студента (1 - КС-40, 2 - КС-44), студенты КС-40 идут первыми
+    std::vector<int> timer; // Дедлайн ожидания в классе или конец паузы, такт
+    std::vector<int> visits;
+    std::vector<uint64_t> rng;
+
+    void startSession(int group, int now, int& session_group, int& session_end, int present[3], int& occupancy, int& lagging);
+};
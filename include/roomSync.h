@@ -0,0 +1,109 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief Примитивы синхронизации класса
+ *
+ * В обычной сборке это std::mutex, std::condition_variable и std::chrono::steady_clock. Сборка с ROOM_SCHEDULE_HOOKS
+ * (только schedule_tests) подставляет примитивы, через которые ScheduleExplorer сам решает, какой поток класса
+ * выполняется следующим и когда наступает время таймаутов, поэтому стенд исполняет настоящий код ComputerRoom.
+ */
+#ifdef ROOM_SCHEDULE_HOOKS
+
+class ScheduleExplorer;
+
+/**
+ * @brief Часы класса: под управлением планировщика - виртуальное время, которое двигает только он
+ */
+struct ScheduledClock {
+    using duration = std::chrono::steady_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::steady_clock::time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now();
+};
+
+/**
+ * @brief Мьютекс, захват и освобождение которого - точки переключения потоков планировщика
+ */
+class ScheduledMutex {
+public:
+    ScheduledMutex() = default;
+    ScheduledMutex(const ScheduledMutex&) = delete;
+    ScheduledMutex& operator=(const ScheduledMutex&) = delete;
+
+    void lock();
+    void unlock();
+    bool try_lock();
+
+    /**
+     * @brief Поток планировщика, владеющий мьютексом (-1 - свободен)
+     */
+    int holder() const { return owner; }
+
+private:
+    friend class ScheduleExplorer;
+    friend class ScheduledCondition;
+    std::mutex native; // Захватывается по-настоящему; под планировщиком - только когда он свободен
+    int owner = -1; // Меняется планировщиком под его мьютексом
+};
+
+/**
+ * @brief Условная переменная: ожидание отдает управление планировщику, таймаут наступает, когда он двигает время
+ */
+class ScheduledCondition {
+public:
+    ScheduledCondition() = default;
+    ScheduledCondition(const ScheduledCondition&) = delete;
+    ScheduledCondition& operator=(const ScheduledCondition&) = delete;
+
+    void notify_one();
+    void notify_all();
+    void wait(std::unique_lock<ScheduledMutex>& lock);
+    std::cv_status wait_until(std::unique_lock<ScheduledMutex>& lock, ScheduledClock::time_point deadline);
+
+    template <class Predicate>
+    void wait(std::unique_lock<ScheduledMutex>& lock, Predicate predicate) {
+        while (!predicate()) wait(lock);
+    }
+
+    template <class Predicate>
+    bool wait_until(std::unique_lock<ScheduledMutex>& lock, ScheduledClock::time_point deadline, Predicate predicate) {
+        while (!predicate()) {
+            if (wait_until(lock, deadline) == std::cv_status::timeout) return predicate();
+        }
+        return true;
+    }
+
+    template <class Rep, class Period, class Predicate>
+    bool wait_for(std::unique_lock<ScheduledMutex>& lock, const std::chrono::duration<Rep, Period>& duration, Predicate predicate) {
+        return wait_until(lock, ScheduledClock::now() + std::chrono::duration_cast<ScheduledClock::duration>(duration), predicate);
+    }
+
+private:
+    friend class ScheduleExplorer;
+    std::condition_variable native; // Для потоков, которые планировщик уже отпустил
+};
+
+using RoomMutex = ScheduledMutex;
+using RoomCondition = ScheduledCondition;
+using RoomClock = ScheduledClock;
+
+/**
+ * @brief Точка переключения перед операцией над атомарным состоянием, которое меняется и без мьютекса
+ */
+void roomSchedulePoint();
+
+#else
+
+using RoomMutex = std::mutex;
+using RoomCondition = std::condition_variable;
+using RoomClock = std::chrono::steady_clock;
+
+inline void roomSchedulePoint() {}
+
+#endif
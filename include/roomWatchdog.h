@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include "computerRoom.h"
+#include "traceRecorder.h"
+
+/**
+ * @brief Настройки сторожевого потока
+ */
+struct WatchdogOptions {
+    int poll_ms = 250; // Период проверки прогресса, мс
+    int stall_ms = 5000; // Время без новых посещений и занятий, после которого класс считается зависшим, мс
+    int report_limit = 20; // Сколько дольше всех ждущих студентов перечислять в отчете
+    std::ostream* report_stream = nullptr; // Куда печатать отчет (nullptr - не печатать)
+    TraceRecorder* tracer = nullptr; // Временная шкала, которую нужно сохранить при зависании (nullptr - не сохранять)
+    std::string trace_path; // Файл для временной шкалы
+    std::function<void(const std::string&)> on_stall; // Вызывается с текстом отчета при каждом зависании
+};
+
+/**
+ * @brief Сторожевой поток, обнаруживающий зависание класса
+ *
+ * Раз в poll_ms читает счетчики засчитанных посещений и начатых занятий. Если за stall_ms ни один не изменился,
+ * формирует отчет: состояние класса и студенты, дольше всех находящиеся в одном ожидании studentBehavior.
+ * Все чтения выполняются без мьютекса класса. Следующий отчет возможен только после возобновления прогресса.
+ */
+class RoomWatchdog {
+public:
+    RoomWatchdog(const ComputerRoom& room, const WatchdogOptions& options);
+    ~RoomWatchdog();
+
+    RoomWatchdog(const RoomWatchdog&) = delete;
+    RoomWatchdog& operator=(const RoomWatchdog&) = delete;
+
+    /**
+     * @brief Запускает сторожевой поток
+     */
+    void start();
+
+    /**
+     * @brief Останавливает сторожевой поток
+     */
+    void stop();
+
+    /**
+     * @brief Кол-во обнаруженных зависаний
+     */
+    int stallCount() const;
+
+    /**
+     * @brief Текст последнего отчета (пустая строка, если зависаний не было)
+     */
+    std::string lastReport() const;
+
+    /**
+     * @brief Формирует отчет о текущем состоянии класса
+     *
+     * @param stalled_ms Сколько класс не продвигается, мс
+     */
+    std::string report(long long stalled_ms) const;
+
+    /**
+     * @brief Название ожидания студента для отчета
+     */
+    static const char* waitName(StudentWaitKind kind);
+
+private:
+    const ComputerRoom& room;
+    WatchdogOptions options;
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool running = false;
+    std::atomic<int> stalls{0};
+    mutable std::mutex report_mtx;
+    std::string last_report;
+
+    void watchLoop();
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "computerRoom.h"
+#include "roomConfig.h"
+
+#ifndef ROOM_SCHEDULE_HOOKS
+#error "scheduleExplorer.cpp собирается только с ROOM_SCHEDULE_HOOKS (цель schedule_tests)"
+#endif
+
+/**
+ * @brief Параметры исследования расписаний
+ */
+struct ScheduleOptions {
+    int max_attempts = 3; // Попыток visitOnce на студента; студент, побывавший на 2 занятиях, завершается раньше
+    int max_steps = 3000; // Решений планировщика в одном расписании, после них расписание считается успешным
+    int lose_notification = 0; // Потерять n-е уведомление расписания (0 - не терять): ошибка для проверки самого стенда
+};
+
+/**
+ * @brief Результат одного расписания
+ */
+struct ScheduleResult {
+    bool ok = true; // Инварианты не нарушены
+    std::string violation; // Описание нарушения
+    std::vector<int> choices; // Выбор на каждом шаге: поток (студенты, затем преподаватель) или часы, см. clockChoice()
+    uint64_t seed = 0; // Зерно случайного расписания
+    int steps = 0;
+    bool finished = false; // Все студенты завершились раньше max_steps
+    int sessions = 0; // Начавшихся занятий
+    int prestaged_sessions = 0; // Из них начатых подготовленной группой сразу после предыдущего
+    long long seat_timeouts = 0; // Попыток, не дождавшихся места за wait_timeout_ms
+    long long seat_rejections = 0; // Попыток, не вставших в заполненную очередь (wait_list_limit)
+    int raced_timeouts = 0; // Сроков ожидания впуска, истекших, когда класс уже впустил студента
+    long long lock_free_entries = 0; // Входов без мьютекса класса
+    long long lock_free_visits = 0; // Из них посещений, прошедших целиком без мьютекса класса
+};
+
+/**
+ * @brief Итог исследования множества расписаний
+ */
+struct ExploreStats {
+    long long schedules = 0; // Проверено расписаний
+    long long finished = 0; // Расписаний, в которых все студенты завершились
+    long long sessions = 0; // Занятий во всех расписаниях
+    long long prestaged_sessions = 0; // Занятий, начатых подготовленной группой
+    long long seat_timeouts = 0;
+    long long seat_rejections = 0;
+    long long raced_timeouts = 0;
+    long long lock_free_entries = 0;
+    long long lock_free_visits = 0;
+    bool complete = false; // Перебор исчерпал все расписания в пределах ограничений
+    ScheduleResult failure; // Первое найденное нарушение (failure.ok == false)
+};
+
+/**
+ * @brief Стенд детерминированного перебора чередований потоков класса
+ *
+ * Исполняет настоящий ComputerRoom: потоки студентов (visitOnce до max_attempts раз) и преподавателя работают
+ * на примитивах из roomSync.h, и в каждый момент выполняется только поток, выбранный планировщиком. Потоки
+ * переключаются в точках синхронизации: захват и освобождение мьютекса, ожидание условной переменной, операции
+ * над словом мест. Время виртуальное: оно стоит, пока потоки выполняются, и продвигается отдельным выбором
+ * "часы" до ближайшего срока ожидания, поэтому конец занятия и таймауты упорядочены так же, как в реальном времени.
+ * Время S ожидания начала занятия фиксируется равным min_wait_ms, чтобы расписание определялось выборами.
+ *
+ * После каждого шага, когда мьютекс класса свободен, проверяются инварианты: занятость не больше вместимости,
+ * счетчики присутствия совпадают с флагами с точностью до студентов, входящих без мьютекса (ENTERING), и не больше
+ * занятых мест, во время занятия никто не входит без мьютекса, во время занятия в классе нет чужой группы,
+ * посещение засчитывается не больше одного раза за занятие, подготовленная группа бывает только во время занятия,
+ * счетчики ожидающих места (seat_queue_*, seat_waiters) совпадают с очередями и состояниями студентов с учетом
+ * wait_list_limit и wait_timeout_ms,
+ * и пока есть незавершенные студенты, хотя бы один поток может продолжить работу. Студент, начинающий ждать конца
+ * занятия, должен быть в классе - так проверяется, что при подготовке он не просиживает следующее занятие, начатое
+ * подряд с его собственным. Расписание воспроизводится по зерну или по записанным выборам.
+ */
+class ScheduleExplorer {
+public:
+    /**
+     * @brief Конструктор класса ScheduleExplorer
+     *
+     * @param config Параметры класса (вывод отключается, max_wait_ms приравнивается к min_wait_ms)
+     * @param options Ограничения расписаний
+     */
+    ScheduleExplorer(const RoomConfig& config, const ScheduleOptions& options = ScheduleOptions());
+    ~ScheduleExplorer();
+
+    /**
+     * @brief Выполняет случайное расписание, полностью определяемое зерном
+     */
+    ScheduleResult runRandom(uint64_t seed);
+
+    /**
+     * @brief Воспроизводит расписание по последовательности выборов
+     */
+    ScheduleResult replay(const std::vector<int>& choices);
+
+    /**
+     * @brief Выполняет count случайных расписаний с зернами first_seed, first_seed + 1, ...
+     *
+     * Останавливается на первом нарушении.
+     */
+    ExploreStats exploreRandom(uint64_t first_seed, long long count);
+
+    /**
+     * @brief Перебирает в глубину все расписания с не более чем preemption_bound вытеснениями
+     *
+     * Вытеснение - переключение на другой поток (или часы), когда предыдущий еще может продолжить работу.
+     * Останавливается на первом нарушении или после max_schedules расписаний.
+     */
+    ExploreStats exploreExhaustive(int preemption_bound, long long max_schedules);
+
+    /**
+     * @brief Значение выбора "продвинуть время" в ScheduleResult::choices
+     */
+    int clockChoice() const;
+
+private:
+    friend class ScheduledMutex;
+    friend class ScheduledCondition;
+    friend struct ScheduledClock;
+
+    enum class ThreadState : uint8_t {
+        Ready, // Выполняется или стоит в точке переключения
+        Lock, // Ждет мьютекс
+        Wait, // Ждет уведомления или срока на условной переменной
+        Finished // Студент завершился
+    };
+
+    struct ThreadSlot {
+        ThreadState state = ThreadState::Ready;
+        ScheduledMutex* mutex = nullptr; // Lock и Wait: мьютекс, который поток захватит
+        ScheduledCondition* condition = nullptr; // Wait: условная переменная
+        bool timed = false; // Wait: есть срок
+        ScheduledClock::time_point deadline;
+        bool timed_out = false; // Ожидание закончилось по сроку
+        std::condition_variable turn; // Поток ждет своей очереди
+    };
+
+    enum class Mode : uint8_t { Random, Replay, Exhaustive };
+
+    // Шаг перебора: доступные варианты и индекс выбранного
+    struct Frame {
+        std::vector<int> options;
+        size_t next = 0;
+    };
+
+    RoomConfig config;
+    ScheduleOptions options;
+    int total; // Студентов
+    int teacher; // Индекс потока преподавателя, после студентов
+    int clock; // Индекс выбора "часы"
+
+    // Состояние прогона, защищено schedule_mtx
+    std::mutex schedule_mtx;
+    std::condition_variable run_cv; // Главный поток ждет подключения потоков и конца расписания
+    std::vector<ThreadSlot> threads;
+    int attached = 0;
+    bool done = false;
+    int granted = -1; // Поток, которому отдано управление
+    int previous = -1; // Предыдущий выбор (для подсчета вытеснений)
+    int notifications = 0;
+    std::atomic<bool> free_run{false}; // Расписание закончено: примитивы работают как обычные
+    std::atomic<int64_t> clock_offset_ns{0}; // Виртуальное время от clock_base
+    ScheduledClock::time_point clock_base;
+    ComputerRoom* room = nullptr;
+    std::vector<int> enabled;
+    std::vector<int> credited_session; // Номер занятия последнего засчитанного посещения студента
+    std::vector<int> visits_seen;
+    ScheduleResult result;
+
+    // Выбор следующего шага
+    Mode mode = Mode::Random;
+    uint64_t rng = 0;
+    const std::vector<int>* replay_choices = nullptr;
+    std::vector<Frame>* stack = nullptr;
+    int preemption_bound = 0;
+    int preemptions = 0;
+
+    static std::atomic<ScheduleExplorer*> active; // Стенд, управляющий потоками сейчас
+    static thread_local int self_index; // Индекс текущего потока в активном стенде (-1 - не подключен)
+
+    ScheduleResult execute();
+    void studentThread(int index);
+
+    int selfOrAttach(std::unique_lock<std::mutex>& guard, ScheduledMutex* teacher_mutex);
+    void yieldLocked(std::unique_lock<std::mutex>& guard, int self);
+    int decideLocked();
+    void grantLocked(int next);
+    void waitTurnLocked(std::unique_lock<std::mutex>& guard, int self);
+    void collectEnabledLocked();
+    int chooseLocked();
+    void advanceClockLocked();
+    bool checkInvariantsLocked();
+    bool checkSeatQueuesLocked();
+    bool checkAttendingLocked(const ScheduledCondition& condition, int self);
+    void endRunLocked();
+
+    // Операции примитивов над текущим потоком
+    bool controls() const;
+    void schedulePoint();
+    void acquire(ScheduledMutex& mutex);
+    void release(ScheduledMutex& mutex);
+    bool wait(ScheduledCondition& condition, ScheduledMutex& mutex, bool timed, ScheduledClock::time_point deadline);
+    void notify(ScheduledCondition& condition, bool all);
+    ScheduledClock::time_point now() const;
+
+    friend void roomSchedulePoint();
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Запись временной шкалы работы класса в формате Chrome trace-event JSON
+ *
+ * Интервалы пишутся в заранее выделенный буфер без блокировок и выделения памяти.
+ * Результат открывается в Perfetto (ui.perfetto.dev) или chrome://tracing.
+ */
+class TraceRecorder {
+public:
+    /**
+     * @brief Виды интервалов, соответствующие ветвям studentBehavior и работе класса
+     */
+    enum class Span : uint8_t {
+        WaitSeat, // Студент ждет места снаружи (класс заполнен или идет занятие другой группы)
+        WaitSession, // Студент в классе ждет начала занятия не дольше S
+        Attend, // Студент на занятии своей группы до его окончания
+        Evicted, // Студента выгнали из-за занятия другой группы, пауза перед следующей попыткой
+        Backoff, // Студент не дождался начала занятия, пауза перед следующей попыткой
+        LockWait, // Студент ждет захвата мьютекса класса
+        Session, // Занятие группы от начала до завершения преподавателем
+        StartClassLocked // Мьютекс удерживается в startClassLocked
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Конструктор класса TraceRecorder
+     *
+     * @param max_events Размер буфера интервалов, интервалы сверх него отбрасываются
+     */
+    explicit TraceRecorder(std::size_t max_events = 1 << 18);
+
+    /**
+     * @brief Записывает интервал
+     *
+     * @param span Вид интервала
+     * @param group Номер группы (1 - КС-40, 2 - КС-44, 0 - сам класс)
+     * @param student_id Идентификатор студента в группе (для интервалов класса - номер занятия)
+     * @param begin Начало интервала
+     * @param end Конец интервала
+     */
+    void record(Span span, int group, int student_id, Clock::time_point begin, Clock::time_point end);
+
+    /**
+     * @brief Записывает все интервалы в поток в формате Chrome trace-event JSON
+     */
+    void writeChromeTrace(std::ostream& os) const;
+
+    /**
+     * @brief Записывает все интервалы в файл в формате Chrome trace-event JSON
+     *
+     * @return true если файл записан успешно
+     */
+    bool writeChromeTrace(const std::string& path) const;
+
+    /**
+     * @brief Кол-во записанных интервалов
+     */
+    std::size_t eventCount() const;
+
+    /**
+     * @brief Кол-во интервалов, отброшенных из-за переполнения буфера
+     */
+    std::size_t droppedCount() const;
+
+private:
+    struct Event {
+        Clock::time_point begin;
+        Clock::time_point end;
+        int student_id;
+        int8_t group;
+        Span span;
+    };
+
+    Clock::time_point origin; // Начало отсчета временной шкалы
+    std::vector<Event> events;
+    std::atomic<std::size_t> next_event{0};
+    std::atomic<std::size_t> dropped{0};
+    std::vector<std::atomic<bool>> ready; // Флаги полностью записанных интервалов
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+
+/**
+ * @brief Индекс студентов одной группы по кол-ву посещений
+ *
+ * Студенты разложены по корзинам 0, 1, ..., required (в последней - все, кто набрал required и больше). Каждая корзина -
+ * интрузивный двусвязный список на массивах next/prev, индексированных идентификатором студента, поэтому перенос
+ * студента в другую корзину, кол-во студентов в корзине и проверка завершения группы выполняются за O(1) без обхода
+ * списка группы и без выделения памяти. Потокобезопасность обеспечивает владелец (в ComputerRoom - мьютекс класса).
+ */
+class VisitIndex {
+public:
+    /**
+     * @param students Кол-во студентов группы, все начинают в корзине 0
+     * @param required Кол-во посещений, после которого студент считается завершившим
+     */
+    VisitIndex(int students, int required);
+
+    /**
+     * @brief Переносит студента в корзину по новому кол-ву посещений за O(1)
+     */
+    void setVisits(int student_id, int visits);
+
+    /**
+     * @brief Корзина студента (кол-во посещений, но не больше required)
+     */
+    int bucketOf(int student_id) const;
+
+    /**
+     * @brief Кол-во студентов с visits посещениями (для visits >= required - набравших required и больше)
+     */
+    int count(int visits) const;
+
+    /**
+     * @brief Кол-во студентов, еще не набравших required посещений
+     */
+    int lagging() const;
+
+    /**
+     * @brief Все студенты набрали required посещений
+     */
+    bool allCompleted() const;
+
+    /**
+     * @brief Первый студент корзины (-1, если корзина пуста)
+     */
+    int first(int visits) const;
+
+    /**
+     * @brief Следующий студент той же корзины (-1 в конце корзины)
+     */
+    int next(int student_id) const;
+
+    int students() const;
+    int required() const;
+
+private:
+    void unlink(int student_id);
+    void pushFront(int bucket, int student_id);
+
+    int required_visits;
+    std::vector<int> heads; // Первый студент каждой корзины
+    std::vector<int> counts; // Кол-во студентов в каждой корзине
+    std::vector<int> next_ids;
+    std::vector<int> prev_ids;
+    std::vector<int> buckets; // Корзина каждого студента
+};
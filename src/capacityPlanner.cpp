@@ -0,0 +1,176 @@
+#include "../include/capacityPlanner.h"
+#include "../include/markovEstimator.h"
+#include "../include/roomEnsemble.h"
+#include "../include/roomSimulator.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <thread>
+
+/**
+ * @brief Нижняя граница доверительного интервала Уилсона (z = 3) для доли опозданий
+ */
+static double wilsonLowerBound(int exceeded, int runs) {
+    const double z = 3.0;
+    double p = static_cast<double>(exceeded) / runs;
+    double denom = 1.0 + z * z / runs;
+    double center = p + z * z / (2.0 * runs);
+    double margin = z * std::sqrt(p * (1.0 - p) / runs + z * z / (4.0 * runs * runs));
+    return (center - margin) / denom;
+}
+
+/**
+ * @brief Выполняет прогоны [begin, end) параллельно, у каждого потока своя модель
+ *
+ * С options.lockstep_ensemble поток берет сразу RoomEnsemble::LANES прогонов и выполняет их одним проходом,
+ * результаты те же, что у RoomSimulator.
+ */
+static void runBatch(const RoomConfig& config, const PlanOptions& options, int cutoff_ms, int begin, int end, std::vector<int>& times) {
+    int threads = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, end - begin));
+
+    std::atomic<int> next{ begin };
+    auto worker = [&]() {
+        RoomSimulator simulator(config);
+        for (int run = next++; run < end; run = next++) {
+            SimResult result = simulator.run(options.seed + static_cast<uint64_t>(run), cutoff_ms);
+            times[run] = result.completed ? result.completion_ms : INT_MAX;
+        }
+    };
+    auto ensembleWorker = [&]() {
+        const int lanes = RoomEnsemble::LANES;
+        RoomEnsemble ensemble(config);
+        uint64_t seeds[lanes];
+        SimResult results[lanes];
+        for (int first = next.fetch_add(lanes); first < end; first = next.fetch_add(lanes)) {
+            // Полосы за концом пакета повторяют последний прогон, их результаты не используются
+            int count = std::min(lanes, end - first);
+            for (int l = 0; l < lanes; ++l) seeds[l] = options.seed + static_cast<uint64_t>(first + std::min(l, count - 1));
+            ensemble.runLanes(seeds, cutoff_ms, results);
+            for (int l = 0; l < count; ++l) times[first + l] = results[l].completed ? results[l].completion_ms : INT_MAX;
+        }
+    };
+    auto work = [&]() {
+        if (options.lockstep_ensemble) ensembleWorker();
+        else worker();
+    };
+    if (options.lockstep_ensemble) threads = std::min(threads, (end - begin + RoomEnsemble::LANES - 1) / RoomEnsemble::LANES);
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) workers.emplace_back(work);
+    work();
+    for (auto& thread : workers) thread.join();
+}
+
+static double configCost(const RoomConfig& config, const PlanOptions& options) {
+    return options.cost ? options.cost(config) : static_cast<double>(config.capacity);
+}
+
+PlanPoint evaluatePlanPoint(const RoomConfig& config, const PlanTarget& target, const PlanOptions& options) {
+    PlanPoint point;
+    point.config = config;
+    point.cost = configCost(config, options);
+
+    MarkovEstimate estimate = MarkovEstimator(config).estimate();
+    point.model_percentile_ms = estimate.feasible ? estimate.percentileMs(target.percentile) : -1.0;
+    if (options.model_prune_factor > 0.0
+        && (point.model_percentile_ms < 0.0 || point.model_percentile_ms > options.model_prune_factor * target.deadline_ms)) {
+        point.pruned = true;
+        point.exceed_share = 1.0;
+        point.percentile_ms = target.deadline_ms;
+        return point;
+    }
+
+    const int runs = std::max(1, options.runs_per_point);
+    const int batch = std::max(1, options.batch_runs);
+    const double allowed_share = 1.0 - target.percentile / 100.0;
+    // Перцентиль (по ближайшему рангу) не больше deadline, пока опозданий не больше runs - ceil(p * runs)
+    const int allowed_exceeded = runs - static_cast<int>(std::ceil(target.percentile / 100.0 * runs));
+
+    std::vector<int> times(runs);
+    int exceeded = 0;
+    int done = 0;
+    while (done < runs) {
+        int end = std::min(runs, done + batch);
+        runBatch(config, options, target.deadline_ms, done, end, times);
+        for (int i = done; i < end; ++i) {
+            if (times[i] > target.deadline_ms) exceeded++;
+        }
+        done = end;
+
+        if (exceeded > allowed_exceeded || (done < runs && wilsonLowerBound(exceeded, done) > allowed_share)) {
+            point.stopped_early = done < runs;
+            break;
+        }
+    }
+
+    point.runs = done;
+    point.exceed_share = static_cast<double>(exceeded) / done;
+    point.feasible = !point.stopped_early && exceeded <= allowed_exceeded;
+    if (point.feasible) {
+        std::sort(times.begin(), times.begin() + done);
+        int rank = static_cast<int>(std::ceil(target.percentile / 100.0 * done));
+        point.percentile_ms = times[std::max(0, rank - 1)];
+    }
+    else {
+        point.percentile_ms = target.deadline_ms;
+    }
+    return point;
+}
+
+PlanResult planCapacity(const RoomConfig& base, const PlanTarget& target, const PlanSpace& space, const PlanOptions& options) {
+    PlanResult result;
+
+    auto better = [](const PlanPoint& a, const PlanPoint& b) {
+        if (a.cost != b.cost) return a.cost < b.cost;
+        return a.percentile_ms < b.percentile_ms;
+    };
+
+    for (int session_ms : space.session_ms_values) {
+        for (int need_ks40 : space.need_ks40_values) {
+            for (int need_ks44 : space.need_ks44_values) {
+                RoomConfig config = base;
+                config.session_ms = session_ms;
+                config.need_ks40 = need_ks40;
+                config.need_ks44 = need_ks44;
+
+                // Занятие группы не начнется, если порог больше вместимости
+                int lo = std::max({ space.min_capacity, need_ks40, need_ks44 });
+                int hi = space.max_capacity;
+                if (lo > hi) continue;
+
+                // Комбинация не может быть дешевле найденной даже при минимальной вместимости
+                config.capacity = lo;
+                if (result.found && configCost(config, options) > result.best.cost) continue;
+
+                config.capacity = hi;
+                PlanPoint top = evaluatePlanPoint(config, target, options);
+                result.evaluated.push_back(top);
+                if (!top.feasible) continue;
+
+                // Двоичный поиск минимальной допустимой вместимости
+                PlanPoint best_here = top;
+                while (lo < hi) {
+                    int mid = lo + (hi - lo) / 2;
+                    config.capacity = mid;
+                    PlanPoint point = evaluatePlanPoint(config, target, options);
+                    result.evaluated.push_back(point);
+                    if (point.feasible) {
+                        best_here = point;
+                        hi = mid;
+                    }
+                    else {
+                        lo = mid + 1;
+                    }
+                }
+
+                if (!result.found || better(best_here, result.best)) {
+                    result.best = best_here;
+                    result.found = true;
+                }
+            }
+        }
+    }
+    return result;
+}
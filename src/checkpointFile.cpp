@@ -0,0 +1,194 @@
+#include "../include/checkpointFile.h"
+#include <cstring>
+#ifndef _WIN32 // Файл отображается через POSIX mmap, на Windows контрольные точки не поддерживаются
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char CHECKPOINT_MAGIC[8] = "CROOMCK";
+
+CheckpointFile::~CheckpointFile() {
+    close();
+}
+
+bool CheckpointFile::isOpen() const {
+    return mapping != nullptr;
+}
+
+const std::string& CheckpointFile::path() const {
+    return file_path;
+}
+
+int CheckpointFile::recordCount() const {
+    return records;
+}
+
+size_t CheckpointFile::halfSize() const {
+    return sizeof(CheckpointHeader) + sizeof(CheckpointRecord) * static_cast<size_t>(records);
+}
+
+CheckpointHeader* CheckpointFile::headerPtr(int half) const {
+    return reinterpret_cast<CheckpointHeader*>(static_cast<char*>(mapping) + halfSize() * static_cast<size_t>(half));
+}
+
+CheckpointRecord* CheckpointFile::recordsPtr(int half) const {
+    return reinterpret_cast<CheckpointRecord*>(headerPtr(half) + 1);
+}
+
+const CheckpointHeader& CheckpointFile::header() const {
+    return *headerPtr(current);
+}
+
+const CheckpointRecord& CheckpointFile::record(int index) const {
+    return recordsPtr(current)[index];
+}
+
+void CheckpointFile::writeRecord(int index, const CheckpointRecord& record) {
+    recordsPtr(target)[index] = record;
+    writing_now.push_back(index);
+}
+
+#ifndef _WIN32
+
+bool CheckpointFile::map(size_t size, bool write) {
+    void* address = mmap(nullptr, size, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) return false;
+    mapping = address;
+    mapped_size = size;
+    writable = write;
+    return true;
+}
+
+/**
+ * @brief Сбрасывает на диск байты [offset, offset + length), msync требует адрес, кратный размеру страницы
+ */
+bool CheckpointFile::syncRange(size_t offset, size_t length) {
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = offset / page * page;
+    return msync(static_cast<char*>(mapping) + begin, offset + length - begin, MS_SYNC) == 0;
+}
+
+bool CheckpointFile::create(const std::string& path, int count) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    records = count;
+    size_t size = 2 * halfSize();
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || !map(size, true)) {
+        close();
+        return false;
+    }
+    file_path = path;
+
+    // Новый файл недействителен до первой завершенной записи
+    for (int half = 0; half < 2; ++half) {
+        std::memcpy(headerPtr(half)->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        headerPtr(half)->version = VERSION;
+        headerPtr(half)->writing = 1;
+    }
+    current = 1;
+    last_generation = 0;
+    return true;
+}
+
+bool CheckpointFile::openReadOnly(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(CheckpointHeader)
+        || !map(static_cast<size_t>(info.st_size), false)) {
+        close();
+        return false;
+    }
+
+    // Размеры групп берутся из первого заголовка: с ними должны совпасть размер файла и второй заголовок
+    const CheckpointHeader& first = *static_cast<const CheckpointHeader*>(mapping);
+    if (std::memcmp(first.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || first.version != VERSION
+        || first.total_ks40 < 0 || first.total_ks44 < 0) {
+        close();
+        return false;
+    }
+    records = first.total_ks40 + first.total_ks44;
+    if (2 * halfSize() != mapped_size) {
+        close();
+        return false;
+    }
+
+    int chosen = -1;
+    for (int half = 0; half < 2; ++half) {
+        const CheckpointHeader& candidate = *headerPtr(half);
+        if (std::memcmp(candidate.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || candidate.version != VERSION
+            || candidate.writing != 0 || candidate.total_ks40 + candidate.total_ks44 != records) continue;
+        if (chosen < 0 || candidate.generation > headerPtr(chosen)->generation) chosen = half;
+    }
+    if (chosen < 0) {
+        close();
+        return false;
+    }
+    current = chosen;
+    last_generation = headerPtr(chosen)->generation;
+    file_path = path;
+    return true;
+}
+
+void CheckpointFile::close() {
+    if (mapping) munmap(mapping, mapped_size);
+    if (fd >= 0) ::close(fd);
+    mapping = nullptr;
+    mapped_size = 0;
+    fd = -1;
+    records = 0;
+    writable = false;
+    current = 0;
+    target = 0;
+    last_generation = 0;
+    written.clear();
+    writing_now.clear();
+    file_path.clear();
+}
+
+void CheckpointFile::beginWrite() {
+    target = 1 - current;
+    headerPtr(target)->writing = 1;
+    // Флаг должен попасть на диск раньше записей студентов
+    syncRange(halfSize() * static_cast<size_t>(target), sizeof(CheckpointHeader));
+
+    // Половина отстает на одну точку: записи, измененные последней точкой, копируются из нее
+    for (int index : written) recordsPtr(target)[index] = recordsPtr(current)[index];
+    writing_now.clear();
+}
+
+bool CheckpointFile::commit(CheckpointHeader header) {
+    if (!writable) return false;
+    size_t offset = halfSize() * static_cast<size_t>(target);
+    if (!syncRange(offset, halfSize())) return false;
+
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = VERSION;
+    header.writing = 0;
+    header.generation = last_generation + 1;
+    *headerPtr(target) = header;
+    if (!syncRange(offset, sizeof(CheckpointHeader))) return false;
+
+    current = target;
+    last_generation = header.generation;
+    written.swap(writing_now);
+    return true;
+}
+
+#else
+
+bool CheckpointFile::map(size_t, bool) { return false; }
+bool CheckpointFile::create(const std::string&, int) { return false; }
+bool CheckpointFile::openReadOnly(const std::string&) { return false; }
+void CheckpointFile::close() {}
+void CheckpointFile::beginWrite() {}
+bool CheckpointFile::syncRange(size_t, size_t) { return false; }
+bool CheckpointFile::commit(CheckpointHeader) { return false; }
+
+#endif
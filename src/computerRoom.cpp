@@ -4,27 +4,97 @@
 #include <thread>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
 #ifdef _WIN32 // Подключение библиотеки windows.h только при компиляции на Windows
 #include <windows.h>
 #endif
 
-ComputerRoom::ComputerRoom()
-    : visits_ks40(TOTAL_KS40, 0),
+// Разделитель блоков вывода, строковая константа вместо std::string(60, '*') на каждое занятие
+static const char* const SEPARATOR = "************************************************************";
+
+/**
+ * @brief Уникальный номер класса: по нему поток отличает уже выполненную привязку от класса по тому же адресу
+ */
+static uint64_t nextPlacementSerial() {
+    static std::atomic<uint64_t> serial{0};
+    return ++serial;
+}
+
+ComputerRoom::ComputerRoom(const RoomConfig& config)
+    : memory_policy(config.placement.numa_node),
+      CAPACITY(config.capacity),
+      TOTAL_KS40(config.total_ks40),
+      TOTAL_KS44(config.total_ks44),
+      NEED_KS40(config.need_ks40),
+      NEED_KS44(config.need_ks44),
+      BATCHED_ADMISSION(config.batched_admission),
+      PRESTAGE(config.prestage_next_session && config.batched_admission),
+      LOCK_FREE_ENTRY(config.lock_free_entry && !config.verbose),
+      SESSION_MS(config.session_ms),
+      MIN_WAIT_MS(config.min_wait_ms),
+      MAX_WAIT_MS(config.max_wait_ms),
+      RETRY_DELAY_MS(config.retry_delay_ms),
+      WAIT_LIST_LIMIT(config.wait_list_limit),
+      WAIT_TIMEOUT_MS(config.wait_timeout_ms),
+      out(config.verbose ? std::cout.rdbuf() : nullptr),
+      admitted_ks40(TOTAL_KS40, 0),
+      admitted_ks44(TOTAL_KS44, 0),
+      admit_cv_ks40(TOTAL_KS40),
+      admit_cv_ks44(TOTAL_KS44),
+      visits_ks40(TOTAL_KS40, 0),
       visits_ks44(TOTAL_KS44, 0),
-      in_room_ks40(TOTAL_KS40, false),
-      in_room_ks44(TOTAL_KS44, false),
+      visit_index_ks40(TOTAL_KS40, 2),
+      visit_index_ks44(TOTAL_KS44, 2),
+      in_room_ks40(TOTAL_KS40),
+      in_room_ks44(TOTAL_KS44),
       attended_this_session_ks40(TOTAL_KS40, false),
-      attended_this_session_ks44(TOTAL_KS44, false) {
+      attended_this_session_ks44(TOTAL_KS44, false),
+      wait_state_ks40(TOTAL_KS40),
+      wait_state_ks44(TOTAL_KS44),
+      placement_node(config.placement.numa_node),
+      placement_cpus(config.placement.cpus),
+      placement_serial(nextPlacementSerial()) {
+    wait_list_ks40.ids.resize(TOTAL_KS40);
+    wait_list_ks40.tickets.resize(TOTAL_KS40);
+    wait_list_ks44.ids.resize(TOTAL_KS44);
+    wait_list_ks44.tickets.resize(TOTAL_KS44);
+    started_at_ks40.resize(TOTAL_KS40);
+    started_at_ks44.resize(TOTAL_KS44);
+    backoff_until_ks40.assign(TOTAL_KS40, 0);
+    backoff_until_ks44.assign(TOTAL_KS44, 0);
+    dirty_students.reserve(TOTAL_KS40 + TOTAL_KS44);
+    dirty_flags.assign(TOTAL_KS40 + TOTAL_KS44, 0);
+    touched_students.reserve(TOTAL_KS40 + TOTAL_KS44);
+    touched_flags.assign(TOTAL_KS40 + TOTAL_KS44, 0);
+    epoch = RoomClock::now();
+    created_at = epoch;
+
+    // Состояние уже выделено и обнулено на узле, дальше поток-создатель работает с прежней политикой
+    memory_policy.restore();
+    if (placement_cpus.empty() && placement_node >= 0) placement_cpus = NumaTopology::detect().cpusOf(placement_node);
+    counters_at_start = readNumaCounters();
+
+    teacher = std::thread(&ComputerRoom::teacherLoop, this);
+}
+
+ComputerRoom::~ComputerRoom() {
+    stop();
+    {
+        std::lock_guard<RoomMutex> lock(mtx);
+        teacher_exit = true;
+    }
+    teacher_cv.notify_all();
+    if (teacher.joinable()) teacher.join();
 }
 
 /**
  * @brief Генерирует случайное время ожидания для принятия студентом решения поснщения занятия
  * 
- * @return Случайное число от 1 до 2 секунд
+ * @return Случайное число от MIN_WAIT_MS до MAX_WAIT_MS миллисекунд (по умолчанию от 1 до 2 секунд)
  */
 int ComputerRoom::getRandomTime() {
     static thread_local std::mt19937 gen(std::random_device{}());
-    std::uniform_int_distribution<> dis(1, 2);
+    std::uniform_int_distribution<> dis(MIN_WAIT_MS, MAX_WAIT_MS);
     return dis(gen);
 }
 
@@ -35,13 +105,839 @@ int ComputerRoom::getRandomTime() {
  * @return true если набралось достаточно студентов для начала занятия, false в обратном случае
  */
 bool ComputerRoom::canStartClass(int group) {
-    if (group == 1) return present_ks40 >= NEED_KS40;
-    if (group == 2) return present_ks44 >= NEED_KS44;
+    if (group == 1) return presentCount(1) >= NEED_KS40;
+    if (group == 2) return presentCount(2) >= NEED_KS44;
+    return false;
+}
+
+/**
+ * @brief Кол-во студентов группы в классе (чтение без блокировки)
+ */
+int ComputerRoom::presentCount(int group) const {
+    int shift = (group == 1) ? PRESENT_KS40_SHIFT : PRESENT_KS44_SHIFT;
+    return static_cast<int>((seat_state.load() >> shift) & PRESENT_MASK);
+}
+
+/**
+ * @brief Меняет кол-во студентов группы в классе на delta (+1 или -1), вызывается под мьютексом
+ */
+void ComputerRoom::addPresent(int group, int delta) {
+    roomSchedulePoint();
+    uint64_t unit = 1ull << ((group == 1) ? PRESENT_KS40_SHIFT : PRESENT_KS44_SHIFT);
+    if (delta > 0) seat_state.fetch_add(unit);
+    else seat_state.fetch_sub(unit);
+}
+
+/**
+ * @brief Пытается занять место одной CAS-операцией над упакованным состоянием
+ * 
+ * @param group Номер группы (1 - КС-40, 2 - КС-44)
+ * @return true если место занято, false если мест нет или идет занятие другой группы
+ */
+bool ComputerRoom::tryAcquireSeat(int group) {
+    // Слово мест меняется и без мьютекса: стенд расписаний переключает потоки перед каждой операцией над ним
+    roomSchedulePoint();
+    uint64_t state = seat_state.load();
+    do {
+        if (static_cast<int>(state & OCCUPANCY_MASK) >= CAPACITY) return false;
+        if ((state & SESSION_BIT) && static_cast<int>((state & GROUP_MASK) >> GROUP_SHIFT) != group) return false;
+    } while (!seat_state.compare_exchange_weak(state, state + 1));
+    return true;
+}
+
+/**
+ * @brief Вход в свободный класс без мьютекса: место и присутствие занимаются одной CAS-операцией
+ *
+ * Подходит, только пока занятия нет, никто не ждет места и вход не набирает порог начала занятия: иначе студенту
+ * нужен мьютекс, чтобы начать занятие, получить посещение или встать в очередь. Флаг присутствия ставится после
+ * CAS, и до этого студент учтен в поле ENTERING слова мест - startClassLocked дожидается таких студентов на lobby_cv.
+ *
+ * @param visits_before Посещения студента до входа: читаются, пока вход учтен в ENTERING, поэтому класс еще не может
+ * засчитать студенту посещение, а прежние посещения упорядочены с чтением через слово мест
+ * @return true если студент в классе
+ */
+bool ComputerRoom::tryEnterWithoutLock(int group, int student_id, int& visits_before) {
+    if (!LOCK_FREE_ENTRY || events_subscribed.load() || stop_flag) return false;
+    const int need = (group == 1) ? NEED_KS40 : NEED_KS44;
+    const int shift = (group == 1) ? PRESENT_KS40_SHIFT : PRESENT_KS44_SHIFT;
+    roomSchedulePoint();
+    uint64_t state = seat_state.load();
+    do {
+        if ((state & SESSION_BIT) || seat_waiters.load() > 0) return false;
+        if (static_cast<int>(state & OCCUPANCY_MASK) >= CAPACITY) return false;
+        if (static_cast<int>((state >> shift) & PRESENT_MASK) + 1 >= need) return false;
+        if (((state >> ENTERING_SHIFT) & ENTERING_MASK) == ENTERING_MASK) return false;
+    } while (!seat_state.compare_exchange_weak(state, state + 1 + (1ull << shift) + (1ull << ENTERING_SHIFT)));
+
+    visits_before = (group == 1) ? visits_ks40[student_id] : visits_ks44[student_id];
+    roomSchedulePoint();
+    ((group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id]).store(true);
+    roomSchedulePoint();
+    if (seat_state.fetch_sub(1ull << ENTERING_SHIFT) & SESSION_BIT) {
+        // Занятие началось после CAS: преподаватель ждет, пока вошедшие поставят флаги
+        { std::lock_guard<RoomMutex> lobby(lobby_mtx); }
+        lobby_cv.notify_all();
+    }
+    lock_free_entries++;
+    return true;
+}
+
+/**
+ * @brief Ожидание студента, вошедшего без мьютекса класса: начала занятия не дольше deadline или, если attending,
+ * выхода с занятия
+ *
+ * Студент ждет, пока он в классе: его флаг снимают под мьютексом выгон при начале занятия другой группы и
+ * преподаватель в конце занятия, после чего будят ожидающих через notifyLobbyLocked (в конце занятия - после впуска
+ * очереди).
+ *
+ * @return false если истек deadline
+ */
+bool ComputerRoom::waitInLobby(int group, int student_id, bool attending, std::chrono::steady_clock::time_point deadline) {
+    const std::atomic<bool>& in_room = (group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id];
+    std::unique_lock<RoomMutex> lobby(lobby_mtx);
+    lobby_waiters++;
+    bool in_time = true;
+    while (in_room.load() && !stop_flag && (attending || !classInSession())) {
+        if (attending) lobby_cv.wait(lobby);
+        else if (lobby_cv.wait_until(lobby, deadline) == std::cv_status::timeout) {
+            in_time = !(in_room.load() && !stop_flag && !classInSession());
+            break;
+        }
+        wakeups++;
+    }
+    lobby_waiters--;
+    return in_time;
+}
+
+/**
+ * @brief Будит студентов, ждущих без мьютекса класса, после начала занятия или выгона, вызывается под мьютексом
+ *
+ * Флаги и слово мест уже изменены: ожидающий проверяет их под lobby_mtx, поэтому уведомление не теряется.
+ */
+void ComputerRoom::notifyLobbyLocked() {
+    if (lobby_waiters.load() == 0) return;
+    { std::lock_guard<RoomMutex> lobby(lobby_mtx); }
+    lobby_cv.notify_all();
+}
+
+void ComputerRoom::releaseSeat() {
+    roomSchedulePoint();
+    seat_state.fetch_sub(1);
+    // Мьютекс нужен только чтобы не потерять уведомление для студентов, ждущих места
+    if (seat_waiters.load() > 0) {
+        {
+            std::lock_guard<RoomMutex> lock(mtx);
+            lock_acquisitions++;
+            admitWaitingLocked();
+        }
+        cv.notify_all();
+    }
+}
+
+/**
+ * @brief Освобождает место без уведомления, вызывается под мьютексом
+ */
+void ComputerRoom::releaseSeatLocked() {
+    roomSchedulePoint();
+    seat_state.fetch_sub(1);
+}
+
+/**
+ * @brief Меняет флаг занятия и текущую группу, сохраняя кол-во занятых мест, вызывается под мьютексом
+ * 
+ * @param in_session Флаг, что занятие в процессе
+ * @param group Группа, занимающая класс (0 - нет, 1 - КС-40, 2 - КС-44)
+ */
+void ComputerRoom::setSessionStateLocked(bool in_session, int group) {
+    roomSchedulePoint();
+    uint64_t state = seat_state.load();
+    uint64_t desired;
+    do {
+        desired = (state & ~(GROUP_MASK | SESSION_BIT)) | (static_cast<uint64_t>(group) << GROUP_SHIFT) | (in_session ? SESSION_BIT : 0u);
+    } while (!seat_state.compare_exchange_weak(state, desired));
+}
+
+int ComputerRoom::currentOccupancy() const {
+    return static_cast<int>(seat_state.load() & OCCUPANCY_MASK);
+}
+
+int ComputerRoom::currentGroup() const {
+    return static_cast<int>((seat_state.load() & GROUP_MASK) >> GROUP_SHIFT);
+}
+
+bool ComputerRoom::classInSession() const {
+    return (seat_state.load() & SESSION_BIT) != 0;
+}
+
+void ComputerRoom::setTracer(TraceRecorder* recorder) {
+    tracer = recorder;
+}
+
+/**
+ * @brief Текущее время для начала интервала, часы читаются только при включенной записи
+ */
+std::chrono::steady_clock::time_point ComputerRoom::traceNow() const {
+    return tracer ? RoomClock::now() : std::chrono::steady_clock::time_point();
+}
+
+/**
+ * @brief Записывает интервал от begin до текущего момента, если запись включена
+ */
+void ComputerRoom::traceSpan(TraceRecorder::Span span, int group, int id, std::chrono::steady_clock::time_point begin) {
+    if (tracer) tracer->record(span, group, id, begin, RoomClock::now());
+}
+
+long long ComputerRoom::lockAcquisitions() const {
+    return lock_acquisitions.load();
+}
+
+int ComputerRoom::sessionsStarted() const {
+    return sessions_started.load();
+}
+
+/**
+ * @brief Снимок счетчиков класса только из атомарных переменных, без захвата мьютекса
+ */
+RoomMetrics ComputerRoom::metrics() const {
+    RoomMetrics snapshot;
+    uint64_t state = seat_state.load();
+    snapshot.occupancy = static_cast<int>(state & OCCUPANCY_MASK);
+    snapshot.current_group = static_cast<int>((state & GROUP_MASK) >> GROUP_SHIFT);
+    snapshot.in_session = (state & SESSION_BIT) != 0;
+    snapshot.sessions_started = sessions_started.load();
+    snapshot.total_ks40 = TOTAL_KS40;
+    snapshot.total_ks44 = TOTAL_KS44;
+    snapshot.completed_ks40 = completed_ks40.load();
+    snapshot.completed_ks44 = completed_ks44.load();
+    snapshot.visits_credited = visits_credited.load();
+    snapshot.lock_acquisitions = lock_acquisitions.load();
+    snapshot.wakeups = wakeups.load();
+    snapshot.seat_waiters = seat_waiters.load();
+    snapshot.prestaged_sessions = prestaged_sessions.load();
+    snapshot.seat_rejections = seat_rejections.load();
+    snapshot.seat_timeouts = seat_timeouts.load();
+    snapshot.lock_free_entries = lock_free_entries.load();
+    snapshot.lock_free_visits = lock_free_visits.load();
+
+    // Текущее занятие учитывается до настоящего момента; начало и сумма читаются не атомарно вместе,
+    // поэтому на границе занятия оценка может ненадолго отклониться на длительность одного занятия
+    long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(RoomClock::now() - created_at).count();
+    long long busy_us = session_busy_us.load();
+    if (snapshot.in_session) busy_us += std::max(0LL, now_us - session_started_us.load());
+    busy_us = std::min(busy_us, now_us);
+    snapshot.uptime_ms = now_us / 1000;
+    snapshot.session_time_ms = busy_us / 1000;
+    if (now_us > 0) {
+        snapshot.utilisation = static_cast<double>(busy_us) / now_us;
+        snapshot.sessions_per_hour = snapshot.sessions_started * 3600e6 / now_us;
+    }
+    return snapshot;
+}
+
+const LatencyHistogram& ComputerRoom::lockWaitHistogram() const {
+    return lock_wait_ns;
+}
+
+const StudentLatency& ComputerRoom::studentLatency(int group) const {
+    return (group == 1) ? latency_ks40 : latency_ks44;
+}
+
+StudentLatency& ComputerRoom::latencyOf(int group) {
+    return (group == 1) ? latency_ks40 : latency_ks44;
+}
+
+uint64_t ComputerRoom::microsecondsSince(std::chrono::steady_clock::time_point begin) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(RoomClock::now() - begin).count();
+    return elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0;
+}
+
+void StudentLatency::merge(const StudentLatency& other) {
+    time_to_seat_us.merge(other.time_to_seat_us);
+    time_to_session_us.merge(other.time_to_session_us);
+    evictions.merge(other.evictions);
+    time_to_completion_us.merge(other.time_to_completion_us);
+}
+
+void StudentLatency::reset() {
+    time_to_seat_us.reset();
+    time_to_session_us.reset();
+    evictions.reset();
+    time_to_completion_us.reset();
+}
+
+/**
+ * @brief Печатает p50/p99/p99.9 и максимум гистограммы одной строкой
+ * 
+ * @param scale Делитель значений (1000 - перевод мкс в мс)
+ */
+static void printLatencyLine(std::ostream& stream, const char* name, const LatencyHistogram& histogram, double scale, const char* unit) {
+    stream << "\t" << name << " (" << unit << "): n=" << histogram.count()
+           << ", p50=" << histogram.percentile(50.0) / scale
+           << ", p99=" << histogram.percentile(99.0) / scale
+           << ", p99.9=" << histogram.percentile(99.9) / scale
+           << ", max=" << histogram.max() / scale << "\n";
+}
+
+/**
+ * @brief Ставит студента в очередь ожидания места своей группы, вызывается под мьютексом
+ * 
+ * @param group Номер группы (1 - КС-40, 2 - КС-44)
+ * @param student_id Идентификатор студента в группе
+ */
+void ComputerRoom::pushWaitingLocked(int group, int student_id) {
+    WaitList& list = (group == 1) ? wait_list_ks40 : wait_list_ks44;
+    int capacity = static_cast<int>(list.ids.size());
+    if (list.size == capacity) {
+        // Очередь переполняется, только если один идентификатор используют несколько потоков
+        std::vector<int> ids(capacity * 2 + 1);
+        std::vector<long long> tickets(capacity * 2 + 1);
+        for (int i = 0; i < list.size; ++i) {
+            ids[i] = list.ids[(list.head + i) % capacity];
+            tickets[i] = list.tickets[(list.head + i) % capacity];
+        }
+        list.ids.swap(ids);
+        list.tickets.swap(tickets);
+        list.head = 0;
+        capacity = static_cast<int>(list.ids.size());
+    }
+    int tail = (list.head + list.size) % capacity;
+    list.ids[tail] = student_id;
+    list.tickets[tail] = next_wait_ticket++;
+    list.size++;
+
+    if (PRESTAGE && classInSession() && staged_group == 0) {
+        staged_group = stageNextGroupLocked();
+        if (staged_group != 0) {
+            out << "\t> Следующее занятие подготовлено для группы " << (staged_group == 1 ? "КС-40" : "КС-44")
+                << " (в очереди " << (staged_group == 1 ? wait_list_ks40.size : wait_list_ks44.size) << ")\n";
+        }
+    }
+}
+
+/**
+ * @brief Убирает студента из очереди ожидания места, не дождавшегося впуска, вызывается под мьютексом
+ * 
+ * Очередь ограничена размером группы, поэтому сдвиг хвоста за O(длины очереди) допустим.
+ * 
+ * @return false, если студента в очереди нет (уже впущен)
+ */
+bool ComputerRoom::removeWaitingLocked(int group, int student_id) {
+    WaitList& list = (group == 1) ? wait_list_ks40 : wait_list_ks44;
+    int capacity = static_cast<int>(list.ids.size());
+    for (int i = 0; i < list.size; ++i) {
+        if (list.ids[(list.head + i) % capacity] != student_id) continue;
+        for (int j = i; j + 1 < list.size; ++j) {
+            list.ids[(list.head + j) % capacity] = list.ids[(list.head + j + 1) % capacity];
+            list.tickets[(list.head + j) % capacity] = list.tickets[(list.head + j + 1) % capacity];
+        }
+        list.size--;
+        return true;
+    }
     return false;
 }
 
 /**
- * @brief Запускает занятие для указанной группы, выгоняет студентов другой, отмечает посещения, поток преподавателя для завершения занятия через 5 секунд.
+ * @brief Учитывает студента, начинающего ждать места, вызывается под мьютексом
+ * 
+ * @return false, если ожидающих студентов группы уже WAIT_LIST_LIMIT и студент должен уйти
+ */
+bool ComputerRoom::joinSeatQueueLocked(int group) {
+    int& queue = (group == 1) ? seat_queue_ks40 : seat_queue_ks44;
+    if (WAIT_LIST_LIMIT > 0 && queue >= WAIT_LIST_LIMIT) return false;
+    queue++;
+    return true;
+}
+
+void ComputerRoom::leaveSeatQueueLocked(int group) {
+    int& queue = (group == 1) ? seat_queue_ks40 : seat_queue_ks44;
+    queue--;
+}
+
+/**
+ * @brief Выбирает группу следующего занятия по очередям ожидания, вызывается под мьютексом
+ * 
+ * Подходит группа, в чьей очереди уже набрался порог начала занятия. Если подходят обе, выбирается
+ * не та, что занимает класс сейчас, чтобы группы чередовались.
+ * 
+ * @return Номер группы или 0, если ни одна очередь не набрала порог
+ */
+int ComputerRoom::stageNextGroupLocked() {
+    bool ready_ks40 = wait_list_ks40.size >= NEED_KS40 && NEED_KS40 <= CAPACITY;
+    bool ready_ks44 = wait_list_ks44.size >= NEED_KS44 && NEED_KS44 <= CAPACITY;
+    if (ready_ks40 && ready_ks44) return currentGroup() == 1 ? 2 : 1;
+    if (ready_ks40) return 1;
+    if (ready_ks44) return 2;
+    return 0;
+}
+
+/**
+ * @brief Выбирает группу, чей студент будет впущен следующим, вызывается под мьютексом
+ * 
+ * Во время занятия впускаются только студенты его группы, между занятиями - подготовленная группа,
+ * иначе - дольше всех ждущий студент.
+ * 
+ * @return Номер группы или 0, если впускать некого
+ */
+int ComputerRoom::nextWaitingGroupLocked() {
+    int only_group = classInSession() ? currentGroup() : staged_group;
+    if (only_group != 0) {
+        const WaitList& list = (only_group == 1) ? wait_list_ks40 : wait_list_ks44;
+        return list.size > 0 ? only_group : 0;
+    }
+    if (wait_list_ks40.size == 0) return wait_list_ks44.size > 0 ? 2 : 0;
+    if (wait_list_ks44.size == 0) return 1;
+    return wait_list_ks40.tickets[wait_list_ks40.head] < wait_list_ks44.tickets[wait_list_ks44.head] ? 1 : 2;
+}
+
+/**
+ * @brief Пакетно впускает ожидающих студентов на все свободные места в одной критической секции, вызывается под мьютексом
+ * 
+ * Класс сам отмечает присутствие и засчитывает посещения впущенным студентам, после чего будит каждого
+ * через его персональную условную переменную - студенту не нужно заново проходить путь входа.
+ */
+void ComputerRoom::admitWaitingLocked() {
+    if (!BATCHED_ADMISSION || stop_flag) return;
+
+    int admitted_count = 0;
+    while (true) {
+        int group = nextWaitingGroupLocked();
+        if (group == 0 || !tryAcquireSeat(group)) break;
+
+        WaitList& list = (group == 1) ? wait_list_ks40 : wait_list_ks44;
+        int student_id = list.ids[list.head];
+        list.head = (list.head + 1) % static_cast<int>(list.ids.size());
+        list.size--;
+        seat_waiters--;
+        admitted_count++;
+
+        if (group == 1) in_room_ks40[student_id] = true;
+        else in_room_ks44[student_id] = true;
+        addPresent(group, 1);
+        markDirtyLocked(group, student_id);
+        publishLocked(RoomEventKind::Entered, group, student_id, currentOccupancy());
+        out << (group == 1 ? "КС-40" : "КС-44") << ": студент " << student_id << " впущен из очереди\n";
+
+        // Засчитать посещение сразу, если занятие группы уже идет
+        const std::vector<bool>& attended = (group == 1) ? attended_this_session_ks40 : attended_this_session_ks44;
+        if (classInSession() && currentGroup() == group && !attended[student_id]) {
+            creditVisitLocked(group, student_id);
+            out << "\tПосещение засчитано для: " << (group == 1 ? "КС-40" : "КС-44") << ", студент " << student_id
+                      << "; всего посещений: " << (group == 1 ? visits_ks40[student_id] : visits_ks44[student_id]) << "\n";
+        }
+
+        if (group == 1) {
+            admitted_ks40[student_id]++;
+            admit_cv_ks40[student_id].notify_one();
+        }
+        else {
+            admitted_ks44[student_id]++;
+            admit_cv_ks44[student_id].notify_one();
+        }
+    }
+
+    if (admitted_count > 0) {
+        out << "\t> Всего в классе: " << currentOccupancy() << ", КС-40: " << presentCount(1)  << ", КС-44: " << presentCount(2) << "\n";
+    }
+
+    // Впущенных студентов может хватить для начала занятия
+    if (!classInSession()) {
+        if (canStartClass(1)) startClassLocked(1);
+        else if (canStartClass(2)) startClassLocked(2);
+    }
+}
+
+/**
+ * @brief Засчитывает посещение текущего занятия студенту и обновляет счетчики для метрик, вызывается под мьютексом
+ * 
+ * @param group Номер группы (1 - КС-40, 2 - КС-44)
+ * @param student_id Идентификатор студента в группе
+ */
+void ComputerRoom::creditVisitLocked(int group, int student_id) {
+    int& visits = (group == 1) ? visits_ks40[student_id] : visits_ks44[student_id];
+    visits++;
+    ((group == 1) ? visit_index_ks40 : visit_index_ks44).setVisits(student_id, visits);
+    if (group == 1) attended_this_session_ks40[student_id] = true;
+    else attended_this_session_ks44[student_id] = true;
+    markDirtyLocked(group, student_id);
+
+    visits_credited++;
+    publishLocked(RoomEventKind::VisitCredited, group, student_id, visits);
+    if (visits == 2) {
+        publishLocked(RoomEventKind::Completed, group, student_id, visits);
+        if (group == 1) completed_ks40++;
+        else completed_ks44++;
+        auto started_at = (group == 1) ? started_at_ks40[student_id] : started_at_ks44[student_id];
+        latencyOf(group).time_to_completion_us.record(microsecondsSince(started_at));
+    }
+}
+
+/**
+ * @brief Отмечает студента измененным с прошлой контрольной точки, вызывается под мьютексом
+ */
+void ComputerRoom::markDirtyLocked(int group, int student_id) {
+    int index = (group == 1) ? student_id : TOTAL_KS40 + student_id;
+    // Студент, вошедший без мьютекса, может сам ни разу его не захватить: reset узнает о нем по изменениям класса
+    markTouchedLocked(index);
+    if (dirty_flags[index]) return;
+    dirty_flags[index] = 1;
+    dirty_students.push_back(index);
+}
+
+/**
+ * @brief Отмечает студента для сброса в reset, вызывается под мьютексом
+ * 
+ * @param index Индекс студента: КС-40 - [0, TOTAL_KS40), КС-44 - со сдвигом TOTAL_KS40
+ */
+void ComputerRoom::markTouchedLocked(int index) {
+    if (touched_flags[index]) return;
+    touched_flags[index] = 1;
+    touched_students.push_back(index);
+}
+
+/**
+ * @brief Пауза студента, которую прерывает stop(): остановленный класс не ждет студентов на паузе
+ */
+void ComputerRoom::sleepUnlessStopped(std::chrono::milliseconds duration) {
+    std::unique_lock<RoomMutex> lock(backoff_mtx);
+    backoff_cv.wait_for(lock, duration, [this] { return stop_flag.load(); });
+}
+
+/**
+ * @brief Запоминает конец паузы студента перед следующей попыткой, вызывается под мьютексом
+ */
+void ComputerRoom::beginBackoffLocked(int group, int student_id) {
+    long long until = msSinceEpoch(RoomClock::now()) + RETRY_DELAY_MS;
+    ((group == 1) ? backoff_until_ks40[student_id] : backoff_until_ks44[student_id]) = until;
+    markDirtyLocked(group, student_id);
+    setWaitState(group, student_id, StudentWaitKind::Backoff);
+}
+
+/**
+ * @brief Вход студента на уже занятое место: флаг присутствия, начало занятия по порогу и посещение, вызывается под мьютексом
+ */
+void ComputerRoom::enterRoomLocked(int group, int student_id) {
+    const char* group_name = (group == 1) ? "КС-40" : "КС-44";
+    ((group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id]) = true;
+    addPresent(group, 1);
+    markDirtyLocked(group, student_id);
+    publishLocked(RoomEventKind::Entered, group, student_id, currentOccupancy());
+
+    out << group_name << ": студент " << student_id << " вошёл\n";
+    out << "\t> Всего в классе: " << currentOccupancy() << ", КС-40: " << presentCount(1)  << ", КС-44: " << presentCount(2) << "\n";
+
+    // Проверка для начала занятия
+    if (!classInSession() && canStartClass(group)) {
+        startClassLocked(group);
+    }
+
+    // + посещение студенту, если пришел на занятие, даже после начала
+    if (classInSession() && currentGroup() == group &&
+        !((group == 1) ? attended_this_session_ks40[student_id] : attended_this_session_ks44[student_id])) {
+        creditVisitLocked(group, student_id);
+        out << group_name << " студент " << student_id << " получил посещение (всего посещений: "
+            << (group == 1 ? visits_ks40[student_id] : visits_ks44[student_id]) << ")\n";
+    }
+}
+
+/**
+ * @brief Выводит студента из класса: снимает флаг присутствия и освобождает место, вызывается под мьютексом
+ *
+ * Общий путь выхода студента по таймауту, выгона при начале занятия другой группы и вывода в конце занятия.
+ *
+ * @param kind Событие для подписчиков (Left или Evicted)
+ * @return false, если студента в классе нет (класс уже вывел его)
+ */
+bool ComputerRoom::leaveRoomLocked(int group, int student_id, RoomEventKind kind) {
+    std::atomic<bool>& in_room = (group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id];
+    if (!in_room) return false;
+    in_room = false;
+    addPresent(group, -1);
+    releaseSeatLocked();
+    markDirtyLocked(group, student_id);
+    publishLocked(kind, group, student_id);
+    return true;
+}
+
+/**
+ * @brief Завершает неудачную попытку студента: запоминает паузу, отпускает мьютекс и, кроме одной попытки,
+ * выдерживает паузу
+ *
+ * @param outcome Исход попытки (TimedOut, Evicted или Rejected), по нему выбирается интервал временной шкалы
+ * @param seat_freed Студент освободил место: впустить ожидающих и разбудить студентов на cv
+ */
+void ComputerRoom::retreatLocked(std::unique_lock<RoomMutex>& lock, int group, int student_id, AttemptOutcome outcome,
+                                 bool seat_freed, bool single_attempt) {
+    beginBackoffLocked(group, student_id);
+    if (seat_freed) admitWaitingLocked();
+    lock.unlock();
+    if (seat_freed) cv.notify_all();
+    if (single_attempt) return;
+    auto backoff_begin = traceNow();
+    sleepUnlessStopped(std::chrono::milliseconds(RETRY_DELAY_MS));
+    traceSpan(outcome == AttemptOutcome::Evicted ? TraceRecorder::Span::Evicted : TraceRecorder::Span::Backoff,
+              group, student_id, backoff_begin);
+}
+
+/**
+ * @brief Рассылает событие подписчикам, вызывается под мьютексом
+ */
+void ComputerRoom::publishLocked(RoomEventKind kind, int group, int student_id, int value) {
+    if (!events.active()) return;
+    RoomEvent event;
+    event.time_us = std::chrono::duration_cast<std::chrono::microseconds>(RoomClock::now() - epoch).count();
+    event.kind = kind;
+    event.group = static_cast<int8_t>(group);
+    event.student_id = student_id;
+    event.value = value;
+    events.publish(event);
+}
+
+/**
+ * @brief Привязывает текущий поток класса к процессорам размещения, если они заданы
+ *
+ * Поток, уже привязанный этим классом (студент пула RoomBatchRunner на следующем прогоне), не привязывается
+ * повторно; pinned_threads считает разные потоки, а не вызовы.
+ */
+void ComputerRoom::pinWorker() {
+    static thread_local uint64_t pinned_for = 0; // Класс, к процессорам которого привязан поток
+    if (placement_cpus.empty() || pinned_for == placement_serial) return;
+    if (!pinCurrentThread(placement_cpus)) return;
+    pinned_for = placement_serial;
+
+    std::lock_guard<std::mutex> lock(pinned_mtx);
+    std::thread::id self = std::this_thread::get_id();
+    if (std::find(pinned_ids.begin(), pinned_ids.end(), self) != pinned_ids.end()) return;
+    pinned_ids.push_back(self);
+    pinned_threads = static_cast<int>(pinned_ids.size());
+}
+
+/**
+ * @brief Добавляет к отчету узлы страниц, занятых буфером
+ */
+static void countPages(PlacementReport& report, const void* data, size_t bytes) {
+    if (data == nullptr || bytes == 0) return;
+    const size_t page = 4096;
+    uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(page - 1);
+    uintptr_t last = (reinterpret_cast<uintptr_t>(data) + bytes - 1) & ~(page - 1);
+    for (uintptr_t address = first; address <= last; address += page) {
+        int node = pageNode(reinterpret_cast<const void*>(address));
+        if (node < 0) report.state_pages_unknown++;
+        else if (node == report.node || report.node < 0) report.state_pages_local++;
+        else report.state_pages_remote++;
+    }
+}
+
+PlacementReport ComputerRoom::placementReport() const {
+    NumaTopology topology = NumaTopology::detect();
+    PlacementReport report;
+    report.numa_nodes = topology.nodeCount();
+    report.numa_from_system = topology.fromSystem();
+    report.node = placement_node;
+    report.cpus = placement_cpus;
+    report.memory_policy_applied = memory_policy.applied();
+    report.pinned_threads = pinned_threads.load();
+
+    // Состояние, которого касаются студенты: сам объект (мьютекс, слово мест) и векторы студентов
+    countPages(report, this, sizeof(*this));
+    countPages(report, visits_ks40.data(), visits_ks40.size() * sizeof(int));
+    countPages(report, visits_ks44.data(), visits_ks44.size() * sizeof(int));
+    countPages(report, backoff_until_ks40.data(), backoff_until_ks40.size() * sizeof(long long));
+    countPages(report, backoff_until_ks44.data(), backoff_until_ks44.size() * sizeof(long long));
+    countPages(report, wait_state_ks40.data(), wait_state_ks40.size() * sizeof(std::atomic<uint64_t>));
+    countPages(report, wait_state_ks44.data(), wait_state_ks44.size() * sizeof(std::atomic<uint64_t>));
+    countPages(report, admit_cv_ks40.data(), admit_cv_ks40.size() * sizeof(RoomCondition));
+    countPages(report, admit_cv_ks44.data(), admit_cv_ks44.size() * sizeof(RoomCondition));
+
+    NumaCounters counters = readNumaCounters();
+    report.counters_available = counters.available && counters_at_start.available;
+    if (report.counters_available) {
+        report.local_allocations = counters.local_node - counters_at_start.local_node;
+        report.remote_allocations = counters.other_node - counters_at_start.other_node;
+    }
+    return report;
+}
+
+std::shared_ptr<EventSubscription> ComputerRoom::subscribe(size_t capacity, OverflowPolicy policy) {
+    std::lock_guard<RoomMutex> lock(mtx);
+    std::shared_ptr<EventSubscription> subscription = events.subscribe(capacity, policy);
+    events_subscribed = events.active();
+    return subscription;
+}
+
+void ComputerRoom::unsubscribe(const std::shared_ptr<EventSubscription>& subscription) {
+    std::lock_guard<RoomMutex> lock(mtx);
+    events.unsubscribe(subscription);
+    events_subscribed = events.active();
+}
+
+/**
+ * @brief Публикует, где сейчас находится студент, для сторожевого потока (одна атомарная запись)
+ */
+void ComputerRoom::setWaitState(int group, int student_id, StudentWaitKind kind) {
+    uint64_t since_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        RoomClock::now() - epoch).count());
+    std::atomic<uint64_t>& state = (group == 1) ? wait_state_ks40[student_id] : wait_state_ks44[student_id];
+    state.store((since_us << 8) | static_cast<uint64_t>(kind), std::memory_order_relaxed);
+}
+
+StudentWait ComputerRoom::studentWait(int group, int student_id) const {
+    const std::atomic<uint64_t>& state = (group == 1) ? wait_state_ks40[student_id] : wait_state_ks44[student_id];
+    uint64_t packed = state.load(std::memory_order_relaxed);
+    StudentWait wait;
+    wait.kind = static_cast<StudentWaitKind>(packed & 0xFF);
+    long long now_us = std::chrono::duration_cast<std::chrono::microseconds>(RoomClock::now() - epoch).count();
+    long long since_us = static_cast<long long>(packed >> 8);
+    wait.waited_ms = (wait.kind == StudentWaitKind::NotStarted || now_us < since_us) ? 0 : (now_us - since_us) / 1000;
+    return wait;
+}
+
+long long ComputerRoom::msSinceEpoch(std::chrono::steady_clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time - epoch).count();
+}
+
+CheckpointRecord ComputerRoom::checkpointRecordLocked(int index) const {
+    bool ks40 = index < TOTAL_KS40;
+    int id = ks40 ? index : index - TOTAL_KS40;
+    CheckpointRecord record{};
+    record.backoff_until_ms = ks40 ? backoff_until_ks40[id] : backoff_until_ks44[id];
+    record.visits = static_cast<uint16_t>(ks40 ? visits_ks40[id] : visits_ks44[id]);
+    if (ks40 ? in_room_ks40[id] : in_room_ks44[id]) record.flags |= CheckpointRecord::IN_ROOM;
+    if (ks40 ? attended_this_session_ks40[id] : attended_this_session_ks44[id]) record.flags |= CheckpointRecord::ATTENDED;
+    return record;
+}
+
+bool ComputerRoom::checkpoint(const std::string& path) {
+    std::lock_guard<std::mutex> checkpoint_lock(checkpoint_mtx);
+    const int total = TOTAL_KS40 + TOTAL_KS44;
+    bool full = !checkpoint_file.isOpen() || checkpoint_file.path() != path;
+    if (full && !checkpoint_file.create(path, total)) return false;
+
+    // Единственная критическая секция: заголовок и измененные записи копируются в буфер
+    CheckpointHeader header{};
+    checkpoint_staging.clear();
+    {
+        std::lock_guard<RoomMutex> lock(mtx);
+        lock_acquisitions++;
+        auto now = RoomClock::now();
+        header.total_ks40 = TOTAL_KS40;
+        header.total_ks44 = TOTAL_KS44;
+        header.capacity = CAPACITY;
+        header.in_session = classInSession() ? 1 : 0;
+        header.group = classInSession() ? currentGroup() : 0;
+        header.completed_ks40 = completed_ks40.load();
+        header.completed_ks44 = completed_ks44.load();
+        header.checkpoint_ms = msSinceEpoch(now);
+        header.session_end_ms = header.in_session ? msSinceEpoch(session_end_time) : 0;
+        header.sessions_started = sessions_started.load();
+        header.visits_credited = visits_credited.load();
+        header.lock_acquisitions = lock_acquisitions.load();
+        header.wakeups = wakeups.load();
+
+        if (full) {
+            for (int i = 0; i < total; ++i) checkpoint_staging.emplace_back(i, checkpointRecordLocked(i));
+        }
+        else {
+            for (int index : dirty_students) checkpoint_staging.emplace_back(index, checkpointRecordLocked(index));
+        }
+        for (int index : dirty_students) dirty_flags[index] = 0;
+        dirty_students.clear();
+    }
+
+    // Запись в файл идет без мьютекса класса
+    checkpoint_file.beginWrite();
+    for (const auto& staged : checkpoint_staging) checkpoint_file.writeRecord(staged.first, staged.second);
+    last_checkpoint_records = checkpoint_staging.size();
+    if (!checkpoint_file.commit(header)) {
+        // Следующая точка перезапишет файл целиком
+        checkpoint_file.close();
+        return false;
+    }
+    return true;
+}
+
+bool ComputerRoom::restore(const std::string& path) {
+    CheckpointFile file;
+    if (!file.openReadOnly(path)) return false;
+    const CheckpointHeader& header = file.header();
+    if (header.total_ks40 != TOTAL_KS40 || header.total_ks44 != TOTAL_KS44) return false;
+
+    std::lock_guard<RoomMutex> lock(mtx);
+    // Момент контрольной точки становится текущим моментом
+    epoch = RoomClock::now() - std::chrono::milliseconds(header.checkpoint_ms);
+
+    for (int i = 0; i < TOTAL_KS40 + TOTAL_KS44; ++i) {
+        const CheckpointRecord& record = file.record(i);
+        bool ks40 = i < TOTAL_KS40;
+        int id = ks40 ? i : i - TOTAL_KS40;
+        markTouchedLocked(i);
+        (ks40 ? visits_ks40[id] : visits_ks44[id]) = record.visits;
+        (ks40 ? visit_index_ks40 : visit_index_ks44).setVisits(id, record.visits);
+        (ks40 ? backoff_until_ks40[id] : backoff_until_ks44[id]) = record.backoff_until_ms;
+        if (ks40) attended_this_session_ks40[id] = (record.flags & CheckpointRecord::ATTENDED) != 0;
+        else attended_this_session_ks44[id] = (record.flags & CheckpointRecord::ATTENDED) != 0;
+    }
+
+    // Все счетчики продолжаются со значений точки (захват мьютекса самим restore не учитывается)
+    sessions_started = static_cast<int>(header.sessions_started);
+    visits_credited = header.visits_credited;
+    completed_ks40 = header.completed_ks40;
+    completed_ks44 = header.completed_ks44;
+    lock_acquisitions = header.lock_acquisitions;
+    wakeups = header.wakeups;
+
+    if (header.in_session) {
+        setSessionStateLocked(true, header.group);
+        session_begin_time = RoomClock::now();
+        session_started_us = std::chrono::duration_cast<std::chrono::microseconds>(session_begin_time - created_at).count();
+        session_end_time = epoch + std::chrono::milliseconds(header.session_end_ms);
+        teacher_cv.notify_one();
+    }
+
+    // Первая контрольная точка после восстановления записывает всех студентов
+    dirty_students.clear();
+    dirty_flags.assign(dirty_flags.size(), 0);
+    return true;
+}
+
+size_t ComputerRoom::lastCheckpointRecords() const {
+    return last_checkpoint_records;
+}
+
+/**
+ * @brief Ожидает окончания текущего занятия, учитывая каждое повторное получение мьютекса
+ * 
+ * При подготовке занятие отслеживается по номеру: следующее начинается в той же критической секции, в которой
+ * закончилось текущее, и студент иначе просидел бы и чужое занятие. Без подготовки сохраняется прежнее поведение:
+ * студенты выходят, только когда класс свободен, и не обгоняют через быстрый путь очередь на следующее занятие.
+ */
+void ComputerRoom::waitSessionEndLocked(std::unique_lock<RoomMutex>& lock) {
+    const int session = sessions_started.load();
+    while (classInSession() && (!PRESTAGE || sessions_started.load() == session) && !stop_flag) {
+        cv.wait(lock);
+        lock_acquisitions++;
+        wakeups++;
+    }
+}
+
+/**
+ * @brief Ожидает начала занятия не дольше deadline, учитывая каждое повторное получение мьютекса
+ * 
+ * @return true если занятие началось или класс остановлен, false если время ожидания истекло
+ */
+bool ComputerRoom::waitSessionStartLocked(std::unique_lock<RoomMutex>& lock, std::chrono::steady_clock::time_point deadline) {
+    while (!classInSession() && !stop_flag) {
+        if (cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+            lock_acquisitions++;
+            return classInSession() || stop_flag;
+        }
+        lock_acquisitions++;
+        wakeups++;
+    }
+    return true;
+}
+
+/**
+ * @brief Запускает занятие для указанной группы, выгоняет студентов другой, отмечает посещения и ставит преподавателю таймер завершения занятия через SESSION_MS.
  * 
  * @param group Номер группы (1 - КС-40, 2 - КС-44)
  */
@@ -50,112 +946,241 @@ void ComputerRoom::startClassLocked(int group) {
     SetConsoleOutputCP(65001);
     SetConsoleCP(65001);
     #endif
-    if (class_in_session || stop_flag) return;
+    if (classInSession() || stop_flag) return;
 
-    class_in_session = true;
-    current_group = group;
+    auto lock_begin = traceNow();
+    session_begin_time = lock_begin;
+    setSessionStateLocked(true, group);
+    // Вход без мьютекса невозможен с начала занятия; студенты, уже учтенные в слове мест, ставят флаги
+    // присутствия без мьютекса, и выгон и посещения ниже должны их видеть
+    if ((seat_state.load() >> ENTERING_SHIFT) & ENTERING_MASK) {
+        std::unique_lock<RoomMutex> lobby(lobby_mtx);
+        while ((seat_state.load() >> ENTERING_SHIFT) & ENTERING_MASK) lobby_cv.wait(lobby);
+    }
+    sessions_started++;
+    session_started_us = std::chrono::duration_cast<std::chrono::microseconds>(RoomClock::now() - created_at).count();
 
-    std::cout << "\n" << std::string(60, '*') << "\n";
-    std::cout << "\t! Началось занятие для группы " << (group == 1 ? "КС-40" : "КС-44") << "\n";
-    std::cout << "\tСтатистика на начало занятия:\n";
-    std::cout << "\tВ классе: " << occupancy << " студентов\n";
-    std::cout << "\t\tКС-40: " << present_ks40 << " студентов\n";
-    std::cout << "\t\tКС-44: " << present_ks44 << " студентов\n";
-    std::cout << std::string(60, '*') << "\n";
+    out << "\n" << SEPARATOR << "\n";
+    out << "\t! Началось занятие для группы " << (group == 1 ? "КС-40" : "КС-44") << "\n";
+    out << "\tСтатистика на начало занятия:\n";
+    out << "\tВ классе: " << currentOccupancy() << " студентов\n";
+    out << "\t\tКС-40: " << presentCount(1) << " студентов\n";
+    out << "\t\tКС-44: " << presentCount(2) << " студентов\n";
+    out << SEPARATOR << "\n";
+    publishLocked(RoomEventKind::SessionStarted, group, sessions_started, currentOccupancy());
 
     // Выгнать всех студентов другой группы
     if (group == 1) {
         for (int i = 0; i < TOTAL_KS44; ++i) {
-            if (in_room_ks44[i]) {
-                in_room_ks44[i] = false;
-                present_ks44--;
-                occupancy--;
-                std::cout << "\tВыгнан студент КС-44 " << i << "\n";
+            if (leaveRoomLocked(2, i, RoomEventKind::Evicted)) out << "\tВыгнан студент КС-44 " << i << "\n";
+            if (attended_this_session_ks44[i]) {
+                attended_this_session_ks44[i] = false;
+                markDirtyLocked(2, i);
             }
-            attended_this_session_ks44[i] = false;
         }
         // Засчитать посещения студентам КС-40, находящимся в классе
         for (int i = 0; i < TOTAL_KS40; ++i) {
             if (in_room_ks40[i] && !attended_this_session_ks40[i]) {
-                visits_ks40[i]++;
-                attended_this_session_ks40[i] = true;
-                std::cout << "\tПосещение засчитано для: КС-40, студент " << i 
+                creditVisitLocked(1, i);
+                out << "\tПосещение засчитано для: КС-40, студент " << i 
                           << "; всего посещений: " << visits_ks40[i] << "\n";
             }
         }
     }
     else {
         for (int i = 0; i < TOTAL_KS40; ++i) {
-            if (in_room_ks40[i]) {
-                in_room_ks40[i] = false;
-                present_ks40--;
-                occupancy--;
-                std::cout << "\tВыгнан студент КС-40 " << i << "\n";
+            if (leaveRoomLocked(1, i, RoomEventKind::Evicted)) out << "\tВыгнан студент КС-40 " << i << "\n";
+            if (attended_this_session_ks40[i]) {
+                attended_this_session_ks40[i] = false;
+                markDirtyLocked(1, i);
             }
-            attended_this_session_ks40[i] = false;
         }
         for (int i = 0; i < TOTAL_KS44; ++i) {
             if (in_room_ks44[i] && !attended_this_session_ks44[i]) {
-                visits_ks44[i]++;
-                attended_this_session_ks44[i] = true;
-                std::cout << "\tПосещение засчитано для: КС-44, студент " << i 
+                creditVisitLocked(2, i);
+                out << "\tПосещение засчитано для: КС-44, студент " << i 
                           << "; всего посещений: " << visits_ks44[i] << "\n";
             }
         }
     }
 
+    notifyLobbyLocked();
+
+    // Впустить ожидающих студентов группы на освободившиеся места и засчитать им посещения
+    admitWaitingLocked();
+
     // Оповестить всех о начале занятия
     cv.notify_all();
 
-    // Запустить поток преподавателя для завершения занятия через 5 секунд
-    std::thread([this]() {
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-        if (!stop_flag) {
-            std::unique_lock<std::mutex> lock(this->mtx);
-            if (!this->class_in_session) return;
-            
-            std::cout << "\n" << std::string(60, '*') << "\n";
-            std::cout << "Завершение занятия для группы " << (this->current_group == 1 ? "КС-40" : "КС-44") << "\n";
-            
-            // Преподаватель выводит всех оставшихся студентов
-            int exited_count = 0;
-            for (int i = 0; i < this->TOTAL_KS40; ++i) {
-                if (this->in_room_ks40[i]) {
-                    this->in_room_ks40[i] = false;
-                    this->present_ks40--;
-                    this->occupancy--;
-                    exited_count++;
-                }
-            }
-            for (int i = 0; i < this->TOTAL_KS44; ++i) {
-                if (this->in_room_ks44[i]) {
-                    this->in_room_ks44[i] = false;
-                    this->present_ks44--;
-                    this->occupancy--;
-                    exited_count++;
-                }
-            }
-            
-            std::cout << "\tВышло студентов после занятия: " << exited_count << "\n";
-            std::cout << std::string(60, '*') << "\n";
+    // Сообщить преподавателю время завершения занятия
+    session_end_time = RoomClock::now() + std::chrono::milliseconds(SESSION_MS);
+    teacher_cv.notify_one();
+
+    traceSpan(TraceRecorder::Span::StartClassLocked, group, sessions_started, lock_begin);
+}
+
+/**
+ * @brief Завершает занятие: преподаватель выводит всех оставшихся студентов и впускает ожидающих, вызывается под мьютексом
+ */
+void ComputerRoom::endClassLocked() {
+    traceSpan(TraceRecorder::Span::Session, currentGroup(), sessions_started, session_begin_time);
+
+    out << "\n" << SEPARATOR << "\n";
+    out << "Завершение занятия для группы " << (currentGroup() == 1 ? "КС-40" : "КС-44") << "\n";
+    
+    // Преподаватель выводит всех оставшихся студентов
+    int exited_count = 0;
+    for (int i = 0; i < TOTAL_KS40; ++i) {
+        if (leaveRoomLocked(1, i, RoomEventKind::Left)) exited_count++;
+    }
+    for (int i = 0; i < TOTAL_KS44; ++i) {
+        if (leaveRoomLocked(2, i, RoomEventKind::Left)) exited_count++;
+    }
+    
+    publishLocked(RoomEventKind::SessionEnded, currentGroup(), sessions_started, exited_count);
+    out << "\tВышло студентов после занятия: " << exited_count << "\n";
+    out << SEPARATOR << "\n";
 
-            this->class_in_session = false;
-            this->current_group = 0;
+    session_busy_us += std::chrono::duration_cast<std::chrono::microseconds>(RoomClock::now() - created_at).count()
+        - session_started_us.load();
+    setSessionStateLocked(false, 0);
 
-            // Сбросить флаги посещений для следующего занятия
-            for (int i = 0; i < this->TOTAL_KS40; ++i) this->attended_this_session_ks40[i] = false;
-            for (int i = 0; i < this->TOTAL_KS44; ++i) this->attended_this_session_ks44[i] = false;
+    // Сбросить флаги посещений для следующего занятия
+    for (int i = 0; i < TOTAL_KS40; ++i) {
+        if (attended_this_session_ks40[i]) {
+            attended_this_session_ks40[i] = false;
+            markDirtyLocked(1, i);
+        }
+    }
+    for (int i = 0; i < TOTAL_KS44; ++i) {
+        if (attended_this_session_ks44[i]) {
+            attended_this_session_ks44[i] = false;
+            markDirtyLocked(2, i);
+        }
+    }
+
+    if (!PRESTAGE) {
+        admitWaitingLocked();
+        return;
+    }
+
+    // Очередь подготовленной группы могла уменьшиться, если ее студентов впускали во время занятия, поэтому выбор
+    // проверяется заново. Впускается только подготовленная группа, и ее занятие начинается в этой же критической
+    // секции (admitWaitingLocked -> startClassLocked). Место между сбросом занятия и впуском может успеть занять
+    // студент с быстрого пути - тогда группе может не хватить мест до порога, и класс работает как без подготовки.
+    staged_group = stageNextGroupLocked();
+    if (staged_group == 0) {
+        admitWaitingLocked();
+        return;
+    }
+    int sessions_before = sessions_started.load();
+    admitWaitingLocked();
+    staged_group = 0;
+    if (sessions_started.load() != sessions_before) prestaged_sessions++;
+    else admitWaitingLocked(); // Подготовленной группе не хватило мест - остальные впускаются как обычно
+}
 
-            lock.unlock();
-            this->cv.notify_all();
+/**
+ * @brief Поток преподавателя: ждет начала занятия и завершает его по истечении SESSION_MS
+ * 
+ * Один поток на все время жизни класса вместо нового потока на каждое занятие.
+ */
+void ComputerRoom::teacherLoop() {
+    pinWorker();
+    std::unique_lock<RoomMutex> lock(mtx);
+    while (!teacher_exit) {
+        // Остановленный класс ждет reset или деструктора
+        if (stop_flag || !classInSession()) {
+            teacher_cv.wait(lock);
+            continue;
         }
-    }).detach();
+        if (RoomClock::now() < session_end_time) {
+            teacher_cv.wait_until(lock, session_end_time);
+            continue;
+        }
+
+        lock_acquisitions++;
+        endClassLocked();
+        // Выведенных без мьютекса студентов будим после впуска очереди, как и ждущих на cv: иначе они заняли бы
+        // освободившиеся места раньше студентов, давно ждущих места
+        notifyLobbyLocked();
+
+        lock.unlock();
+        cv.notify_all();
+        lock.lock();
+    }
 }
 
 
 void ComputerRoom::stop() {
     stop_flag = true;
+    // Захват мьютекса гарантирует, что ни один студент не пропустит уведомление между проверкой флага и ожиданием
+    { std::lock_guard<RoomMutex> lock(mtx); }
     cv.notify_all();
+    teacher_cv.notify_all();
+    for (auto& admit_cv : admit_cv_ks40) admit_cv.notify_all();
+    for (auto& admit_cv : admit_cv_ks44) admit_cv.notify_all();
+    { std::lock_guard<RoomMutex> lobby(lobby_mtx); }
+    lobby_cv.notify_all();
+    { std::lock_guard<RoomMutex> lock(backoff_mtx); }
+    backoff_cv.notify_all();
+}
+
+void ComputerRoom::reset() {
+    std::lock_guard<RoomMutex> lock(mtx);
+    for (int index : touched_students) {
+        bool ks40 = index < TOTAL_KS40;
+        int id = ks40 ? index : index - TOTAL_KS40;
+        (ks40 ? visits_ks40[id] : visits_ks44[id]) = 0;
+        (ks40 ? visit_index_ks40 : visit_index_ks44).setVisits(id, 0);
+        (ks40 ? backoff_until_ks40[id] : backoff_until_ks44[id]) = 0;
+        (ks40 ? admitted_ks40[id] : admitted_ks44[id]) = 0;
+        (ks40 ? started_at_ks40[id] : started_at_ks44[id]) = std::chrono::steady_clock::time_point();
+        (ks40 ? wait_state_ks40[id] : wait_state_ks44[id]).store(0, std::memory_order_relaxed);
+        if (ks40) {
+            in_room_ks40[id] = false;
+            attended_this_session_ks40[id] = false;
+        }
+        else {
+            in_room_ks44[id] = false;
+            attended_this_session_ks44[id] = false;
+        }
+        markDirtyLocked(ks40 ? 1 : 2, id);
+        touched_flags[index] = 0;
+    }
+    touched_students.clear();
+
+    // Очереди ожидания сохраняют выделенные буферы
+    wait_list_ks40.head = wait_list_ks40.size = 0;
+    wait_list_ks44.head = wait_list_ks44.size = 0;
+    next_wait_ticket = 0;
+    staged_group = 0;
+    seat_queue_ks40 = seat_queue_ks44 = 0;
+    seat_state = 0;
+    seat_waiters = 0;
+
+    seat_rejections = 0;
+    seat_timeouts = 0;
+    lock_free_entries = 0;
+    lock_free_visits = 0;
+    lock_acquisitions = 0;
+    sessions_started = 0;
+    wakeups = 0;
+    visits_credited = 0;
+    completed_ks40 = 0;
+    completed_ks44 = 0;
+    prestaged_sessions = 0;
+    session_busy_us = 0;
+    session_started_us = 0;
+    lock_wait_ns.reset();
+    latency_ks40.reset();
+    latency_ks44.reset();
+
+    epoch = RoomClock::now();
+    created_at = epoch;
+    session_end_time = epoch;
+    stop_flag = false;
+    teacher_cv.notify_one();
 }
 
 /**
@@ -165,169 +1190,431 @@ void ComputerRoom::stop() {
  * @param student_id Уникальный идентификатор студента в пределах группы
  */
 void ComputerRoom::studentBehavior(int group, int student_id) {
-    std::string group_name = (group == 1) ? "КС-40" : "КС-44";
+    runStudent(group, student_id, false);
+}
+
+AttemptOutcome ComputerRoom::visitOnce(int group, int student_id) {
+    return runStudent(group, student_id, true);
+}
+
+bool ComputerRoom::enterStudent(int group, int student_id) {
+    std::lock_guard<RoomMutex> lock(mtx);
+    lock_acquisitions++;
+    markTouchedLocked((group == 1) ? student_id : TOTAL_KS40 + student_id);
+    if (stop_flag || ((group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id])) return false;
+    if (!tryAcquireSeat(group)) return false;
+    enterRoomLocked(group, student_id);
+    return true;
+}
+
+bool ComputerRoom::leaveStudent(int group, int student_id) {
+    std::unique_lock<RoomMutex> lock(mtx);
+    lock_acquisitions++;
+    if (!leaveRoomLocked(group, student_id, RoomEventKind::Left)) return false;
+    admitWaitingLocked();
+    lock.unlock();
+    cv.notify_all();
+    return true;
+}
+
+/**
+ * @brief Общий цикл студента: бесконечные попытки с паузами или одна попытка без паузы
+ * 
+ * @param single_attempt true - вернуться после первой попытки (для открытой нагрузки), false - до остановки класса
+ */
+AttemptOutcome ComputerRoom::runStudent(int group, int student_id, bool single_attempt) {
+    const char* group_name = (group == 1) ? "КС-40" : "КС-44";
+    StudentLatency& latency = latencyOf(group);
+    std::chrono::steady_clock::time_point& started_at = (group == 1) ? started_at_ks40[student_id] : started_at_ks44[student_id];
+
+    if (single_attempt) {
+        // Время до второго посещения отсчитывается от первой попытки студента
+        if (started_at == std::chrono::steady_clock::time_point()) started_at = RoomClock::now();
+    }
+    else {
+        pinWorker();
+
+        // Время запуска читается другими потоками только под мьютексом после того, как студент вошел в класс
+        started_at = RoomClock::now();
+
+        // Пауза, прерванная контрольной точкой, продолжается после восстановления
+        long long backoff_left = ((group == 1) ? backoff_until_ks40[student_id] : backoff_until_ks44[student_id])
+            - msSinceEpoch(RoomClock::now());
+        if (backoff_left > 0) sleepUnlessStopped(std::chrono::milliseconds(backoff_left));
+    }
+
+    // При любом выходе из функции кол-во выгонов записывается в гистограмму, а студент отмечается завершенным
+    struct ExitRecorder {
+        ComputerRoom& room;
+        int group;
+        int student_id;
+        bool single_attempt;
+        int count = 0;
+        ~ExitRecorder() {
+            if (!single_attempt) room.latencyOf(group).evictions.record(static_cast<uint64_t>(count));
+            room.setWaitState(group, student_id, StudentWaitKind::Finished);
+        }
+    } evictions{ *this, group, student_id, single_attempt };
 
     while (!stop_flag) {
+        setWaitState(group, student_id, StudentWaitKind::Running);
     
         // Генерируем случайное время ожидания перед попыткой входа, как будто студент решает приходить ли ему на занятие
         int S = getRandomTime();
+        auto attempt_begin = RoomClock::now();
+
+        // Вход в свободный класс без мьютекса. Если затем начнется занятие группы студента, посещение засчитает
+        // startClassLocked, а из класса выведет преподаватель, и вся попытка пройдет без мьютекса класса
+        int visits_before_entry = 0;
+        auto entered_deadline = RoomClock::now() + std::chrono::milliseconds(S);
+        bool entered = tryEnterWithoutLock(group, student_id, visits_before_entry);
+        bool visited_without_lock = false;
+        auto entered_at = RoomClock::now();
+        while (entered) {
+            latency.time_to_seat_us.record(microsecondsSince(attempt_begin));
+            auto wait_begin = traceNow();
+            setWaitState(group, student_id, StudentWaitKind::WaitSessionStart);
+            waitInLobby(group, student_id, false, entered_deadline);
+            setWaitState(group, student_id, StudentWaitKind::Running);
+            traceSpan(TraceRecorder::Span::WaitSession, group, student_id, wait_begin);
+
+            bool present = (group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id];
+            if (present && !stop_flag && classInSession() && currentGroup() == group) {
+                latency.time_to_session_us.record(microsecondsSince(entered_at));
+                auto attend_begin = traceNow();
+                setWaitState(group, student_id, StudentWaitKind::Attending);
+                waitInLobby(group, student_id, true, entered_deadline);
+                setWaitState(group, student_id, StudentWaitKind::Running);
+                traceSpan(TraceRecorder::Span::Attend, group, student_id, attend_begin);
+                if (stop_flag) return AttemptOutcome::Stopped;
+                lock_free_visits++;
+                if (single_attempt) return AttemptOutcome::Attended;
+
+                // Как и под мьютексом, после занятия студент сразу входит снова и ждет до прежнего срока
+                visited_without_lock = true;
+                attempt_begin = RoomClock::now();
+                entered = tryEnterWithoutLock(group, student_id, visits_before_entry);
+                entered_at = RoomClock::now();
+                continue;
+            }
+            // Срок ожидания истек, класс вывел студента или остановлен: попытка продолжается под мьютексом
+            break;
+        }
+
+        // Быстрый путь: занимаем место без мьютекса, если есть свободные места и нет занятия другой группы
+        bool seat_acquired = entered || tryAcquireSeat(group);
         
         // Блок с захватом мьютекса для проверки условий и изменения состояния
         {
-            std::unique_lock<std::mutex> lock(mtx);
-            if (stop_flag) return;
+            auto lock_wait_begin = RoomClock::now();
+            std::unique_lock<RoomMutex> lock(mtx);
+            lock_acquisitions++;
+            auto lock_wait_end = RoomClock::now();
+            lock_wait_ns.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                lock_wait_end - lock_wait_begin).count()));
+            if (tracer) tracer->record(TraceRecorder::Span::LockWait, group, student_id, lock_wait_begin, lock_wait_end);
+            markTouchedLocked((group == 1) ? student_id : TOTAL_KS40 + student_id);
+            if (stop_flag) {
+                // Вошедший без мьютекса студент в классе, как и ждущие занятия студенты остановленного класса
+                if (seat_acquired && !entered) releaseSeatLocked();
+                return AttemptOutcome::Stopped;
+            }
 
-            // Время ожидания студентом начала занятия не более S секунд
-            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(S);
+            // Время ожидания студентом начала занятия не более S миллисекунд
+            auto deadline = (entered || visited_without_lock) ? entered_deadline : RoomClock::now() + std::chrono::milliseconds(S);
+
+            // Студент уже впущен классом из очереди ожидания; посещения до постановки в очередь - чтобы узнать,
+            // засчитал ли класс посещение при впуске
+            bool admitted = false;
+            int visits_before_admission = 0;
+
+            // Студент учтен среди ожидающих места группы (WAIT_LIST_LIMIT) и ждет места не дольше queue_deadline,
+            // если задан WAIT_TIMEOUT_MS
+            bool queued = false;
+            std::chrono::steady_clock::time_point queue_deadline;
 
             // Внутренний цикл ожидания возможности войти в класс
             while (true) {
-                if (stop_flag) return;
+                if (stop_flag) {
+                    if (seat_acquired && !entered) releaseSeatLocked();
+                    return AttemptOutcome::Stopped;
+                }
 
                 /**
                  * @condition Условия для входа в класс: если есть свободные места, занятие не идет, идет занятие группы студента
                  */
-                bool can_enter_now = (occupancy < CAPACITY) && (!class_in_session || current_group == group);
+                if (!seat_acquired && !admitted) seat_acquired = tryAcquireSeat(group);
 
-                if (can_enter_now) {
-                    // Когла получилось войти в класс, обновляем его заполненность
-                    occupancy++;
-                    if (group == 1) { 
-                        in_room_ks40[student_id] = true; 
-                        present_ks40++; 
+                if (!seat_acquired && !admitted) {
+                    // Студент не может войти, когда нет мест или идет занятие чужой группы.
+                    // Счетчик ожидающих сообщает releaseSeat, что освобождение места нужно сопроводить уведомлением
+                    seat_waiters++;
+                    auto wait_begin = traceNow();
+                    seat_acquired = tryAcquireSeat(group);
+                    bool gave_up = false; // Очередь заполнена или место не освободилось до queue_deadline
+                    if (!seat_acquired && !queued) {
+                        queued = joinSeatQueueLocked(group);
+                        gave_up = !queued;
+                        if (queued && WAIT_TIMEOUT_MS > 0) {
+                            queue_deadline = RoomClock::now() + std::chrono::milliseconds(WAIT_TIMEOUT_MS);
+                        }
                     }
-                    else { 
-                        in_room_ks44[student_id] = true; 
-                        present_ks44++; 
+
+                    if (seat_acquired || gave_up) {
+                        seat_waiters--;
+                    }
+                    else if (BATCHED_ADMISSION) {
+                        // Встаем в очередь и ждем, пока класс сам впустит студента на освободившееся место
+                        visits_before_admission = (group == 1) ? visits_ks40[student_id] : visits_ks44[student_id];
+                        pushWaitingLocked(group, student_id);
+                        setWaitState(group, student_id, StudentWaitKind::WaitAdmission);
+                        std::vector<int>& admitted_counts = (group == 1) ? admitted_ks40 : admitted_ks44;
+                        RoomCondition& admit_cv = (group == 1) ? admit_cv_ks40[student_id] : admit_cv_ks44[student_id];
+                        while (admitted_counts[student_id] == 0 && !stop_flag) {
+                            if (WAIT_TIMEOUT_MS == 0) admit_cv.wait(lock);
+                            else if (admit_cv.wait_until(lock, queue_deadline) == std::cv_status::timeout) {
+                                lock_acquisitions++;
+                                break;
+                            }
+                            lock_acquisitions++;
+                            wakeups++;
+                        }
+                        if (admitted_counts[student_id] > 0) {
+                            admitted_counts[student_id]--;
+                            admitted = true;
+                        }
+                        else if (!stop_flag && removeWaitingLocked(group, student_id)) {
+                            // Впуск не успел до queue_deadline: студент сам выходит из очереди
+                            seat_waiters--;
+                            gave_up = true;
+                        }
+                        setWaitState(group, student_id, StudentWaitKind::Running);
+                        traceSpan(TraceRecorder::Span::WaitSeat, group, student_id, wait_begin);
+                    }
+                    else {
+                        setWaitState(group, student_id, StudentWaitKind::WaitSeat);
+                        if (WAIT_TIMEOUT_MS == 0) cv.wait(lock);
+                        else gave_up = cv.wait_until(lock, queue_deadline) == std::cv_status::timeout;
+                        lock_acquisitions++;
+                        if (!gave_up) wakeups++;
+                        seat_waiters--;
+                        setWaitState(group, student_id, StudentWaitKind::Running);
+                        traceSpan(TraceRecorder::Span::WaitSeat, group, student_id, wait_begin);
                     }
 
-                    std::cout << group_name << ": студент " << student_id << " вошёл\n";
-                    std::cout << "\t> Всего в классе: " << occupancy << ", КС-40: " << present_ks40  << ", КС-44: " << present_ks44 << "\n";
+                    if (gave_up && !stop_flag) {
+                        // Студент не ждет дальше, а уходит на паузу и повторяет попытку позже
+                        if (queued) {
+                            leaveSeatQueueLocked(group);
+                            seat_timeouts++;
+                            out << group_name << ": студент " << student_id << " не дождался места за "
+                                << WAIT_TIMEOUT_MS / 1000.0 << " сек и ушел\n";
+                        }
+                        else {
+                            seat_rejections++;
+                            out << group_name << ": студент " << student_id << " не встал в заполненную очередь и ушел\n";
+                        }
+                        retreatLocked(lock, group, student_id, AttemptOutcome::Rejected, false, single_attempt);
+                        if (single_attempt) return AttemptOutcome::Rejected;
+                        break;
+                    }
+                    continue;
+                }
 
-                    // Проверка для начала занятия
-                    if (!class_in_session && canStartClass(group)) {
-                        startClassLocked(group);
+                if (queued) {
+                    leaveSeatQueueLocked(group);
+                    queued = false;
+                }
+
+                if (admitted && !((group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id])) {
+                    // Пока впущенный студент ждал мьютекса, занятие закончилось (при подготовке следующее могло уже
+                    // начаться подряд) или началось занятие другой группы, и класс его вывел: ждать конца чужого
+                    // занятия вне класса нельзя, студент начинает новую попытку
+                    admitted = false;
+                    int visits = (group == 1) ? visits_ks40[student_id] : visits_ks44[student_id];
+                    if (visits > visits_before_admission) {
+                        if (single_attempt) return AttemptOutcome::Attended;
+                        attempt_begin = RoomClock::now();
                     }
+                    continue;
+                }
+                if (!entered) {
+                    latency.time_to_seat_us.record(microsecondsSince(attempt_begin));
+                    entered_at = RoomClock::now();
+                }
 
-                    // + посещение студенту, если пришел на занятие, даже после начала
-                    if (class_in_session && current_group == group && 
-                        !((group == 1) ? attended_this_session_ks40[student_id] : attended_this_session_ks44[student_id])) {
-                        if (group == 1) { 
-                            visits_ks40[student_id]++; 
-                            attended_this_session_ks40[student_id] = true; 
-                        }
-                        else { 
-                            visits_ks44[student_id]++; 
-                            attended_this_session_ks44[student_id] = true; 
+                if (admitted) {
+                    // Присутствие и посещение уже отмечены классом при пакетном впуске
+                    admitted = false;
+                }
+                else if (entered) {
+                    // Место и присутствие заняты без мьютекса; пока студент ждал, класс мог засчитать ему посещение
+                    // и вывести его в конце занятия или выгнать при начале занятия другой группы
+                    entered = false;
+                    seat_acquired = false;
+                    markDirtyLocked(group, student_id);
+                    if (!((group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id])) {
+                        int visits = (group == 1) ? visits_ks40[student_id] : visits_ks44[student_id];
+                        if (visits > visits_before_entry) {
+                            if (single_attempt) return AttemptOutcome::Attended;
+                            attempt_begin = RoomClock::now();
+                            continue;
                         }
-                        std::cout << group_name << " студент " << student_id << " получил посещение (всего посещений: " 
-                            << (group == 1 ? visits_ks40[student_id] : visits_ks44[student_id]) << ")\n";
+                        evictions.count++;
+                        out << "\tСтудент " << student_id << " из " << group_name << " выгнан до захвата мьютекса\n";
+                        retreatLocked(lock, group, student_id, AttemptOutcome::Evicted, false, single_attempt);
+                        if (single_attempt) return AttemptOutcome::Evicted;
+                        break;
                     }
+                }
+                else {
+                    seat_acquired = false;
+
+                    // Между захватом места и мьютекса могло начаться занятие другой группы
+                    if (classInSession() && currentGroup() != group) {
+                        releaseSeatLocked();
+                        evictions.count++;
+                        out << "\tСтудент " << student_id << " из " << group_name
+                            << " попытался войти во время занятия другой группы и был выгнан\n";
+                        retreatLocked(lock, group, student_id, AttemptOutcome::Evicted, true, single_attempt);
+                        if (single_attempt) return AttemptOutcome::Evicted;
+                        break;
+                    }
+
+                    // Когла получилось войти в класс, обновляем его заполненность
+                    enterRoomLocked(group, student_id);
+                }
+
+                // Если занятие группы студента уже идет, то ожидаем окончания, и после окончания выходим
+                if (classInSession() && currentGroup() == group) {
+                    latency.time_to_session_us.record(microsecondsSince(entered_at));
+                    auto attend_begin = traceNow();
+                    setWaitState(group, student_id, StudentWaitKind::Attending);
+                    waitSessionEndLocked(lock);
+                    setWaitState(group, student_id, StudentWaitKind::Running);
+                    traceSpan(TraceRecorder::Span::Attend, group, student_id, attend_begin);
+                    if (single_attempt) return stop_flag ? AttemptOutcome::Stopped : AttemptOutcome::Attended;
+                    attempt_begin = RoomClock::now();
+                    continue;
+                }
+                else {
+                    // Если занятие еще не началось, ожидаем в течение S мс
+                    auto wait_begin = traceNow();
+                    setWaitState(group, student_id, StudentWaitKind::WaitSessionStart);
+                    int visits_before_session = (group == 1) ? visits_ks40[student_id] : visits_ks44[student_id];
+                    bool started = waitSessionStartLocked(lock, deadline);
+                    setWaitState(group, student_id, StudentWaitKind::Running);
+                    traceSpan(TraceRecorder::Span::WaitSession, group, student_id, wait_begin);
+                    if (!stop_flag) latency.time_to_session_us.record(microsecondsSince(entered_at));
 
-                    // Если занятие группы студента уже идет, то ожидаем окончания, и после окончания выходим
-                    if (class_in_session && current_group == group) {
-                        cv.wait(lock, [this]() { return !this->class_in_session || this->stop_flag; });
-                        continue;
+                    if (stop_flag) return AttemptOutcome::Stopped;
+
+                    if (!started) {
+                        // Студент не дождался начала занятия и выходит
+                        leaveRoomLocked(group, student_id, RoomEventKind::Left);
+                        out << group_name << ": студент " << student_id << " ждал " << S / 1000.0 << " сек, не дождался и вышел на " << RETRY_DELAY_MS / 1000.0 << " сек\n";
+
+                        // Место освободилось: впустить ожидающих и уведомить остальных студентов
+                        retreatLocked(lock, group, student_id, AttemptOutcome::TimedOut, true, single_attempt);
+                        if (single_attempt) return AttemptOutcome::TimedOut;
+                        break;
                     }
                     else {
-                        // Если занятие еще не началось, ожидаем в течение S сек
-                        bool started = cv.wait_until(lock, deadline, [this, group]() {
-                            return this->class_in_session || this->stop_flag;
-                        });
-
-                        if (stop_flag) return;
-
-                        if (!started) {
-                            // Студент не дождался начала занятия и выходит
-                            if (group == 1 && in_room_ks40[student_id]) {
-                                in_room_ks40[student_id] = false;
-                                present_ks40--;
-                                occupancy--;
-                            }
-                            else if (group == 2 && in_room_ks44[student_id]) {
-                                in_room_ks44[student_id] = false;
-                                present_ks44--;
-                                occupancy--;
-                            }
-                            std::cout << group_name << ": студент " << student_id << " ждал " << S << " сек, не дождался и вышел на 1 сек\n";
-                            
-                            // уведомление для других студенотов, что места в классе еще есть
-                            lock.unlock();
-                            cv.notify_all();
-                            std::this_thread::sleep_for(std::chrono::seconds(1));
-                            break;
+                        // Пока студент ждал мьютекса, класс мог вывести его: занятие его группы уже закончилось (при
+                        // подготовке следующее могло начаться подряд) или началось занятие другой группы
+                        bool present = (group == 1) ? in_room_ks40[student_id] : in_room_ks44[student_id];
+                        int visits = (group == 1) ? visits_ks40[student_id] : visits_ks44[student_id];
+                        if (!present && visits > visits_before_session) {
+                            if (single_attempt) return AttemptOutcome::Attended;
+                            attempt_begin = RoomClock::now();
+                            continue;
+                        }
+
+                        // Если занятие группы студента идет, то ожидаем окончания, и после окончания выходим
+                        if (present && classInSession() && currentGroup() == group) {
+                            auto attend_begin = traceNow();
+                            setWaitState(group, student_id, StudentWaitKind::Attending);
+                            waitSessionEndLocked(lock);
+                            setWaitState(group, student_id, StudentWaitKind::Running);
+                            traceSpan(TraceRecorder::Span::Attend, group, student_id, attend_begin);
+                            if (stop_flag) return AttemptOutcome::Stopped;
+                            if (single_attempt) return AttemptOutcome::Attended;
+                            attempt_begin = RoomClock::now();
+                            continue;
                         }
                         else {
-                            // Если занятие группы студента идет, то ожидаем окончания, и после окончания выходим
-                            if (class_in_session && current_group == group) {
-                                cv.wait(lock, [this]() { return !this->class_in_session || this->stop_flag; });
-                                if (stop_flag) return;
-                                continue;
-                            }
-                            else {
-                                // Если занятие НЕ группы студента идет, то выгоняем
-                                if (group == 1 && in_room_ks40[student_id]) {
-                                    in_room_ks40[student_id] = false;
-                                    present_ks40--;
-                                    occupancy--;
-                                }
-                                else if (group == 2 && in_room_ks44[student_id]) {
-                                    in_room_ks44[student_id] = false;
-                                    present_ks44--;
-                                    occupancy--;
-                                }
-                                std::cout << "\tСтудент " << student_id << " из " << (group == 1 ? "КС-40" : "КС-44")
-                                    << " попытался войти во время занятия другой группы и был выгнан\n";
-                                
-                                // уведомляемЮ что состояние изменилось
-                                lock.unlock();
-                                cv.notify_all();
-                                std::this_thread::sleep_for(std::chrono::seconds(1));
-                                break;
-                            }
+                            // Если занятие НЕ группы студента идет, то выгоняем
+                            leaveRoomLocked(group, student_id, RoomEventKind::Evicted);
+                            evictions.count++;
+                            out << "\tСтудент " << student_id << " из " << (group == 1 ? "КС-40" : "КС-44")
+                                << " попытался войти во время занятия другой группы и был выгнан\n";
+
+                            retreatLocked(lock, group, student_id, AttemptOutcome::Evicted, true, single_attempt);
+                            if (single_attempt) return AttemptOutcome::Evicted;
+                            break;
                         }
                     }
                 }
-                else {
-                    // Студент не может войти, когда нет мест или идет занятие чужой группы, ждем уведомления
-                    cv.wait(lock);
-                }
             } 
         } 
 
         // Перед следующей попыткой проверяем флаг остановки
-        if (stop_flag) return;
+        if (stop_flag) return AttemptOutcome::Stopped;
     }
+    return AttemptOutcome::Stopped;
 }
 
 
 bool ComputerRoom::allStudentsCompleted() {
-    std::lock_guard<std::mutex> lock(mtx);
-    for (int v : visits_ks40) if (v < 2) return false;
-    for (int v : visits_ks44) if (v < 2) return false;
-    return true;
+    std::lock_guard<RoomMutex> lock(mtx);
+    return visit_index_ks40.allCompleted() && visit_index_ks44.allCompleted();
+}
+
+int ComputerRoom::studentsWithVisits(int group, int visits) {
+    std::lock_guard<RoomMutex> lock(mtx);
+    return ((group == 1) ? visit_index_ks40 : visit_index_ks44).count(visits);
+}
+
+std::vector<int> ComputerRoom::laggingStudents(int group, size_t limit) {
+    std::lock_guard<RoomMutex> lock(mtx);
+    const VisitIndex& index = (group == 1) ? visit_index_ks40 : visit_index_ks44;
+    std::vector<int> students;
+    students.reserve(std::min(limit, static_cast<size_t>(index.lagging())));
+    for (int visits = 0; visits < index.required(); ++visits) {
+        for (int id = index.first(visits); id >= 0 && students.size() < limit; id = index.next(id)) students.push_back(id);
+    }
+    return students;
 }
 
 /**
  * @brief Выводит  статистику посещений
  */
 void ComputerRoom::printStatistics() {
-    std::lock_guard<std::mutex> lock(mtx);
+    std::lock_guard<RoomMutex> lock(mtx);
     
-    std::cout << std::string(60, '*') << "\n";
+    std::cout << SEPARATOR << "\n";
     std::cout << "\tИТОГОВАЯ СТАТИСТИКА\n";
-    std::cout << std::string(60, '*') << "\n";
-    std::cout << "Группа КС-40 (30 студентов):\n";
+    std::cout << SEPARATOR << "\n";
+    std::cout << "Группа КС-40 (студентов: " << TOTAL_KS40 << "):\n";
     for (int i = 0; i < TOTAL_KS40; ++i) {
         std::cout << "\tСтудент " << i << ": " << visits_ks40[i] << " посещений";
         std::cout << "\n";
     }
-    std::cout << std::string(60, '*') << "\n";
-    std::cout << "Группа КС-44 (24 студента):\n";
+    std::cout << SEPARATOR << "\n";
+    std::cout << "Группа КС-44 (студентов: " << TOTAL_KS44 << "):\n";
     for (int i = 0; i < TOTAL_KS44; ++i) {
         std::cout << "\tСтудент " << i << ": " << visits_ks44[i] << " посещений";
         std::cout << "\n";
     }
-    std::cout << std::string(60, '*') << "\n";
+    std::cout << SEPARATOR << "\n";
+    for (int group = 1; group <= 2; ++group) {
+        const StudentLatency& latency = studentLatency(group);
+        std::cout << "Задержки " << (group == 1 ? "КС-40" : "КС-44") << ":\n";
+        printLatencyLine(std::cout, "до получения места", latency.time_to_seat_us, 1000.0, "мс");
+        printLatencyLine(std::cout, "до начала занятия или ухода", latency.time_to_session_us, 1000.0, "мс");
+        printLatencyLine(std::cout, "выгонов на студента", latency.evictions, 1.0, "раз");
+        printLatencyLine(std::cout, "до второго посещения", latency.time_to_completion_us, 1000.0, "мс");
+    }
+    std::cout << SEPARATOR << "\n";
 }
 
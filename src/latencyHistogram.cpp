@@ -0,0 +1,95 @@
+#include "../include/latencyHistogram.h"
+#include <cmath>
+
+/**
+ * @brief Номер старшего установленного бита (value > 0)
+ */
+static int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+/**
+ * @brief Корзина значения: значения меньше SUB_BUCKETS хранятся точно, далее - SUB_BUCKETS корзин на степень двойки
+ */
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(SUB_BUCKETS)) return static_cast<int>(value);
+    int exponent = highestBit(value);
+    int sub = static_cast<int>((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+    int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    int sub = index % SUB_BUCKETS;
+    int shift = exponent - SUB_BUCKET_BITS;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + sub) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total_sum.fetch_add(value, std::memory_order_relaxed);
+    raiseMax(value);
+}
+
+void LatencyHistogram::raiseMax(uint64_t value) {
+    uint64_t seen = max_value.load(std::memory_order_relaxed);
+    while (value > seen && !max_value.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        uint64_t bucket = other.buckets[i].load(std::memory_order_relaxed);
+        if (bucket != 0) buckets[i].fetch_add(bucket, std::memory_order_relaxed);
+    }
+    total_count.fetch_add(other.count(), std::memory_order_relaxed);
+    total_sum.fetch_add(other.sum(), std::memory_order_relaxed);
+    raiseMax(other.max());
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    total_count.store(0, std::memory_order_relaxed);
+    total_sum.store(0, std::memory_order_relaxed);
+    max_value.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total_count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::sum() const {
+    return total_sum.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const {
+    return max_value.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    // Общий счетчик может опережать корзины при параллельной записи, поэтому считаем по самим корзинам
+    uint64_t total = 0;
+    for (const auto& bucket : buckets) total += bucket.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t bound = bucketUpperBound(i);
+            uint64_t largest = max();
+            return bound < largest ? bound : largest;
+        }
+    }
+    return max();
+}
@@ -2,35 +2,294 @@
 #include <thread>
 #include <vector>
 #include <chrono>
+#include <string>
+#include <memory>
 #include "computerRoom.h"
+#include "capacityPlanner.h"
+#include "metricsExporter.h"
+#include "roomWatchdog.h"
+#include "openLoopLoad.h"
+#include "roomServer.h"
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+/**
+ * @brief Режим планирования: подбирает самую дешевую конфигурацию класса под цель по времени завершения
+ * 
+ * Аргументы: --deadline-s <сек>, --percentile <P>, --ks40 <кол-во>, --ks44 <кол-во>, --runs <прогонов в точке>,
+ * --prune <множитель> - не моделировать точки, где аналитическая оценка больше дедлайна в столько раз,
+ * --ensemble - выполнять прогоны пакетами RoomEnsemble для сверки с RoomSimulator (те же результаты, но медленнее).
+ * 
+ * @return 0 если допустимая конфигурация найдена, 1 в обратном случае
+ */
+static int runPlanner(int argc, char* argv[]) {
+    RoomConfig base;
+    PlanTarget target;
+    PlanSpace space;
+    PlanOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--ensemble") options.lockstep_ensemble = true;
+        else if (!has_value) break;
+        else if (arg == "--deadline-s") target.deadline_ms = std::stoi(argv[++i]) * 1000;
+        else if (arg == "--percentile") target.percentile = std::stod(argv[++i]);
+        else if (arg == "--ks40") base.total_ks40 = std::stoi(argv[++i]);
+        else if (arg == "--ks44") base.total_ks44 = std::stoi(argv[++i]);
+        else if (arg == "--runs") options.runs_per_point = std::stoi(argv[++i]);
+        else if (arg == "--prune") options.model_prune_factor = std::stod(argv[++i]);
+    }
+
+    std::cout << "> Планирование: КС-40 " << base.total_ks40 << ", КС-44 " << base.total_ks44
+              << ", цель p" << target.percentile << " <= " << target.deadline_ms / 1000 << " сек\n";
+
+    PlanResult result = planCapacity(base, target, space, options);
+    for (const PlanPoint& point : result.evaluated) {
+        std::cout << "\tмест " << point.config.capacity << ", порог КС-40 " << point.config.need_ks40
+                  << ", порог КС-44 " << point.config.need_ks44 << ", занятие " << point.config.session_ms / 1000.0 << " сек: "
+                  << (point.feasible ? "подходит" : "не подходит");
+        if (point.pruned) std::cout << ", отсечено по модели";
+        else std::cout << ", прогонов " << point.runs << (point.stopped_early ? " (остановлено досрочно)" : "")
+                       << ", опозданий " << point.exceed_share * 100 << "%";
+        if (point.feasible) std::cout << ", p" << target.percentile << " " << point.percentile_ms / 1000.0 << " сек";
+        std::cout << ", модель: ";
+        if (point.model_percentile_ms < 0) std::cout << "не завершается";
+        else std::cout << "p" << target.percentile << " " << point.model_percentile_ms / 1000.0 << " сек";
+        std::cout << "\n";
+    }
+
+    if (!result.found) {
+        std::cout << "! Допустимая конфигурация не найдена\n";
+        return 1;
+    }
+    const RoomConfig& best = result.best.config;
+    std::cout << "> Лучшая конфигурация: мест " << best.capacity << ", порог КС-40 " << best.need_ks40
+              << ", порог КС-44 " << best.need_ks44 << ", занятие " << best.session_ms / 1000.0 << " сек, p"
+              << target.percentile << " " << result.best.percentile_ms / 1000.0 << " сек\n";
+    return 0;
+}
+
+/**
+ * @brief Режим открытой нагрузки: кривая задержек и пропускной способности по частотам прибытий
+ * 
+ * Аргументы: --open-loop <частота,частота,...> - попыток в секунду, --duration-s <сек>,
+ * --arrival-process poisson|bursty|trace, --burst <размер пачки>, --arrival-trace <файл> (мс прибытия на строку).
+ * 
+ * @return 0 при успешном завершении, 1 если трасса не прочитана
+ */
+static int runLoadCurve(int argc, char* argv[]) {
+    RoomConfig config;
+    LoadOptions options;
+    std::vector<double> rates;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--open-loop") {
+            std::string list = argv[++i];
+            size_t begin = 0;
+            while (begin < list.size()) {
+                size_t end = list.find(',', begin);
+                if (end == std::string::npos) end = list.size();
+                if (end > begin) rates.push_back(std::stod(list.substr(begin, end - begin)));
+                begin = end + 1;
+            }
+        }
+        else if (arg == "--duration-s") options.duration_ms = std::stoi(argv[++i]) * 1000;
+        else if (arg == "--burst") options.burst_size = std::stoi(argv[++i]);
+        else if (arg == "--arrival-process") {
+            std::string process = argv[++i];
+            if (process == "bursty") options.process = ArrivalProcess::Bursty;
+            else if (process == "trace") options.process = ArrivalProcess::Trace;
+            else options.process = ArrivalProcess::Poisson;
+        }
+        else if (arg == "--arrival-trace") {
+            options.process = ArrivalProcess::Trace;
+            if (!OpenLoopGenerator::loadTrace(argv[++i], options.trace_ms)) {
+                std::cerr << "! Не удалось прочитать трассу прибытий " << argv[i] << "\n";
+                return 1;
+            }
+        }
+    }
+    if (options.process == ArrivalProcess::Trace) rates.assign(1, 0.0);
+    if (rates.empty()) rates.push_back(options.rate_per_s);
+
+    std::cout << "> Открытая нагрузка: " << options.duration_ms / 1000 << " сек на точку\n";
+    std::vector<LoadPoint> curve = OpenLoopGenerator::sweep(config, options, rates);
+    for (const LoadPoint& point : curve) {
+        std::cout << "\tчастота " << point.rate_per_s << "/с, прибытий " << point.offered
+                  << ", завершено " << point.throughput << "/с, посещений " << point.visit_rate << "/с"
+                  << ", p50 " << point.p50_us / 1000.0 << " мс, p99 " << point.p99_us / 1000.0
+                  << " мс, макс " << point.max_us / 1000.0 << " мс, не завершено " << point.unfinished << "\n";
+    }
+    return 0;
+}
+
+/**
+ * @brief Режим сервера: класс без потоков студентов, студентами управляют клиенты через Unix-сокет
+ * 
+ * Аргументы: --serve <путь к сокету>, --duration-s <сек> - время работы (по умолчанию 60).
+ * 
+ * @return 0 при успешном завершении, 1 если сокет не открыт
+ */
+static int runServer(int argc, char* argv[]) {
+    RoomConfig config;
+    config.verbose = false;
+    std::string path;
+    int duration_s = 60;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--serve") path = argv[++i];
+        else if (arg == "--duration-s") duration_s = std::stoi(argv[++i]);
+    }
+
+    ComputerRoom room(config);
+    RoomServer server(room);
+    if (!server.start(path)) {
+        std::cerr << "! Не удалось открыть сокет " << path << "\n";
+        return 1;
+    }
+    std::cout << "> Сервер класса на " << path << ", " << duration_s << " сек\n";
+    std::this_thread::sleep_for(std::chrono::seconds(duration_s));
+    room.stop();
+    server.stop();
+
+    RoomMetrics metrics = room.metrics();
+    std::cout << "> Запросов: " << server.requestsServed() << ", занятий: " << metrics.sessions_started
+              << ", посещений: " << metrics.visits_credited << "\n";
+    return 0;
+}
+
+/**
+ * @brief Нагрузочный клиент сервера класса: запросов в секунду и задержки
+ * 
+ * Аргументы: --bench-server <путь к сокету>, --connections <кол-во>, --depth <запросов в полете на соединение>,
+ * --duration-s <сек>, --bench-op seat|status|visit - TryEnter/Leave, Status или попытки студентов Visit,
+ * --students <кол-во> - студентов каждой группы для seat и visit, --drain-s <сек> - ожидание ответов после замера,
+ * --ring - через кольца в разделяемой памяти.
+ * 
+ * @return 0 при успешном завершении, 1 если не удалось подключиться
+ */
+static int runServerBench(int argc, char* argv[]) {
+    std::string path;
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--ring") options.ring = true;
+        else if (!has_value) break;
+        else if (arg == "--bench-server") path = argv[++i];
+        else if (arg == "--connections") options.connections = std::stoi(argv[++i]);
+        else if (arg == "--depth") options.depth = std::stoi(argv[++i]);
+        else if (arg == "--duration-s") options.duration_ms = std::stoi(argv[++i]) * 1000;
+        else if (arg == "--students") options.students = std::stoi(argv[++i]);
+        else if (arg == "--drain-s") options.drain_ms = std::stoi(argv[++i]) * 1000;
+        else if (arg == "--bench-op") {
+            std::string op = argv[++i];
+            options.op = (op == "status") ? RoomOp::Status : (op == "visit") ? RoomOp::Visit : RoomOp::TryEnter;
+        }
+    }
+
+    BenchResult result;
+    ServerBench::run(path, options, result);
+    if (result.connected == 0) {
+        std::cerr << "! Не удалось подключиться к " << path << "\n";
+        return 1;
+    }
+    std::cout << "> Соединений " << result.connected << (options.ring ? " (кольца)" : "") << ", в полете " << options.depth
+              << ": " << result.requests_per_s << " запросов/с, p50 " << result.latency_us.percentile(50.0)
+              << " мкс, p99 " << result.latency_us.percentile(99.0) << " мкс, макс " << result.latency_us.max() << " мкс\n";
+    if (options.op == RoomOp::Visit) {
+        auto count = [&result](RoomStatus status) { return result.by_status[static_cast<int>(status)]; };
+        std::cout << "> Попыток: " << result.attempt_us.count() << " (посещение " << count(RoomStatus::Attended)
+                  << ", не дождались " << count(RoomStatus::TimedOut) << ", выгнаны " << count(RoomStatus::Evicted)
+                  << ", без места " << count(RoomStatus::Rejected) << "), студент занят: " << count(RoomStatus::Busy)
+                  << ", без ответа: " << result.unanswered << "; попытка p50 " << result.attempt_us.percentile(50.0) / 1000.0
+                  << " мс, p99 " << result.attempt_us.percentile(99.0) / 1000.0 << " мс\n";
+    }
+    return 0;
+}
+
 /**
  * @brief Главная функция программы
  * 
  * Создает компьютерный класс, запускает потоки студентов, отслеживает завершение и выводит статистику.
  * 
+ * @param argc Кол-во аргументов командной строки
+ * @param argv Аргументы: --trace <файл> - записать временную шкалу в формате Chrome trace-event JSON,
+ *             --metrics-port <порт> - отдавать метрики в формате Prometheus на 127.0.0.1:<порт>,
+ *             --watchdog-s <сек> - завершить работу с отчетом, если столько секунд нет новых посещений и занятий,
+ *             --numa-node <узел> - разместить состояние класса и потоки студентов на NUMA-узле,
+ *             --wait-limit <кол-во> - ожидать места могут не больше стольких студентов группы, остальные уходят на паузу,
+ *             --wait-timeout-ms <мс> - студент ждет места не дольше, затем уходит на паузу,
+ *             --prestage - готовить следующее занятие во время текущего и начинать его сразу после окончания,
+ *             --plan - вместо симуляции подобрать параметры класса (см. runPlanner),
+ *             --open-loop <частоты> - вместо симуляции построить кривую открытой нагрузки (см. runLoadCurve),
+ *             --serve <сокет> - вместо симуляции обслуживать клиентов класса (см. runServer),
+ *             --bench-server <сокет> - нагрузочный клиент сервера класса (см. runServerBench)
  * @return 0 при успешном завершении программы
  */
-int main() {
+int main(int argc, char* argv[]) {
     #ifdef _WIN32
     SetConsoleOutputCP(65001);
     SetConsoleCP(65001);
     #endif
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--plan") return runPlanner(argc, argv);
+        if (std::string(argv[i]) == "--open-loop") return runLoadCurve(argc, argv);
+        if (std::string(argv[i]) == "--serve") return runServer(argc, argv);
+        if (std::string(argv[i]) == "--bench-server") return runServerBench(argc, argv);
+    }
+
+    RoomConfig config;
+    std::string trace_path;
+    int metrics_port = -1;
+    int watchdog_s = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc; // Флаги без значения (--prestage) могут стоять и последними
+        if (arg == "--prestage") config.prestage_next_session = true;
+        else if (!has_value) break;
+        else if (arg == "--trace") trace_path = argv[++i];
+        else if (arg == "--metrics-port") metrics_port = std::stoi(argv[++i]);
+        else if (arg == "--watchdog-s") watchdog_s = std::stoi(argv[++i]);
+        else if (arg == "--numa-node") config.placement.numa_node = std::stoi(argv[++i]);
+        else if (arg == "--wait-limit") config.wait_list_limit = std::stoi(argv[++i]);
+        else if (arg == "--wait-timeout-ms") config.wait_timeout_ms = std::stoi(argv[++i]);
+    }
+
     std::cout << std::string(60, '*') << "\n\n";
-    std::cout << "> Группа КС-40: 30 студентов (требуется 15 для начала)\n";
-    std::cout << "> Группа КС-44: 24 студента (требуется 12 для начала)\n";
-    std::cout << "> Вместимость класса: 20 студентов\n\n";
+    std::cout << "> Группа КС-40: " << config.total_ks40 << " студентов (требуется " << config.need_ks40 << " для начала)\n";
+    std::cout << "> Группа КС-44: " << config.total_ks44 << " студентов (требуется " << config.need_ks44 << " для начала)\n";
+    std::cout << "> Вместимость класса: " << config.capacity << " студентов\n\n";
     std::cout << std::string(60, '*') << "\n\n";
 
-    ComputerRoom room;
+    ComputerRoom room(config);
+    std::unique_ptr<TraceRecorder> tracer;
+    if (!trace_path.empty()) {
+        tracer.reset(new TraceRecorder());
+        room.setTracer(tracer.get());
+    }
+    MetricsExporter exporter(room);
+    if (metrics_port >= 0) {
+        if (exporter.startTcp(metrics_port)) {
+            std::cout << "\t! Метрики доступны на http://127.0.0.1:" << exporter.port() << "/metrics\n";
+        }
+        else {
+            std::cout << "\t! Не удалось открыть порт метрик " << metrics_port << "\n";
+        }
+    }
+    WatchdogOptions watchdog_options;
+    watchdog_options.stall_ms = watchdog_s * 1000;
+    watchdog_options.report_stream = &std::cout;
+    watchdog_options.tracer = tracer.get();
+    if (tracer) watchdog_options.trace_path = trace_path + ".stall.json";
+    RoomWatchdog watchdog(room, watchdog_options);
+    if (watchdog_s > 0) watchdog.start();
     std::vector<std::thread> threads;
 
     // Создание потоков для группы КС-40
     std::cout << "\t! Запуск потоков для группы КС-40\n";
-    for (int i = 0; i < 30; ++i) {
+    for (int i = 0; i < config.total_ks40; ++i) {
         threads.emplace_back([&room, i]() {
             room.studentBehavior(1, i);
         });
@@ -38,7 +297,7 @@ int main() {
 
     // Создание потоков для группы КС-44
     std::cout << "\t! Запуск потоков для группы КС-44\n";
-    for (int i = 0; i < 24; ++i) {
+    for (int i = 0; i < config.total_ks44; ++i) {
         threads.emplace_back([&room, i]() {
             room.studentBehavior(2, i);
         });
@@ -55,6 +314,11 @@ int main() {
             std::cout << "\n! Достигнут таймаут ожидания (200 секунд).\n";
             break;
         }
+
+        if (watchdog.stallCount() > 0) {
+            std::cout << "\n! Класс завис, работа завершена досрочно.\n";
+            break;
+        }
         
         // Вывод прогресса каждые 5 секунд
         if (elapsed % 5 == 0 && elapsed > 0) {
@@ -66,6 +330,7 @@ int main() {
 
     // Остановка всех потоков
     std::cout << "\n\t! Завершение работы всех потоков\n\n";
+    watchdog.stop();
     room.stop();
 
     // Ожидание завершения всех потоков
@@ -74,6 +339,39 @@ int main() {
     }
 
     // Вывод статистики
+    RoomMetrics final_metrics = room.metrics();
     room.printStatistics();
+    std::cout << "Загрузка класса: " << final_metrics.utilisation * 100 << "% времени в занятиях ("
+              << final_metrics.session_time_ms / 1000.0 << " из " << final_metrics.uptime_ms / 1000.0 << " сек), занятий в час "
+              << final_metrics.sessions_per_hour;
+    if (config.prestage_next_session) std::cout << ", начато сразу после предыдущего " << final_metrics.prestaged_sessions
+                                                << " из " << final_metrics.sessions_started;
+    std::cout << "\n";
+    if (config.wait_list_limit > 0 || config.wait_timeout_ms > 0) {
+        std::cout << "Ограничение ожидания места: отклонено попыток " << final_metrics.seat_rejections
+                  << ", не дождались места " << final_metrics.seat_timeouts << "\n";
+    }
+
+    if (config.placement.numa_node >= 0) {
+        PlacementReport placement = room.placementReport();
+        std::cout << "Размещение: узел " << placement.node << " из " << placement.numa_nodes
+                  << (placement.numa_from_system ? "" : " (топология ОС недоступна)")
+                  << ", привязано потоков " << placement.pinned_threads
+                  << ", страниц состояния на узле " << placement.state_pages_local
+                  << ", на других узлах " << placement.state_pages_remote << "\n";
+        if (placement.counters_available) {
+            std::cout << "\tnumastat за время работы: локальных выделений " << placement.local_allocations
+                      << ", удаленных " << placement.remote_allocations << "\n";
+        }
+    }
+
+    if (tracer) {
+        if (tracer->writeChromeTrace(trace_path)) {
+            std::cout << "Временная шкала записана в " << trace_path << " (интервалов: " << tracer->eventCount() << ")\n";
+        }
+        else {
+            std::cout << "! Не удалось записать временную шкалу в " << trace_path << "\n";
+        }
+    }
     return 0;
 }
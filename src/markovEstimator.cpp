@@ -0,0 +1,281 @@
+#include "../include/markovEstimator.h"
+#include <algorithm>
+#include <cmath>
+
+double MarkovEstimate::percentileMs(double percentile) const {
+    double target = percentile / 100.0;
+    for (size_t t = 0; t < completion_cdf.size(); ++t) {
+        if (completion_cdf[t] >= target - 1e-12) return completion_ms[t];
+    }
+    return -1.0;
+}
+
+MarkovEstimator::MarkovEstimator(const RoomConfig& config)
+    : config(config) {}
+
+/**
+ * @brief Логарифм биномиального коэффициента
+ */
+static double logChoose(int n, int k) {
+    if (k < 0 || k > n) return -INFINITY;
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+/**
+ * @brief Вероятность, что группа завершена не позже n-го своего занятия, n = 0..MAX_SESSIONS
+ *
+ * Состояние - (a0, a1): кол-во студентов с 0 и 1 посещением. На занятии посещение получают k случайных студентов
+ * группы, из них x с 0 посещений и y с 1 посещением.
+ */
+std::vector<double> MarkovEstimator::groupCompletionCdf(int group_size) const {
+    const int n = group_size;
+    const int k = std::min(config.capacity, n);
+    const int width = n + 1;
+    auto index = [width](int a0, int a1) { return a0 * width + a1; };
+
+    std::vector<double> probability(static_cast<size_t>(width) * width, 0.0);
+    std::vector<double> next(probability.size(), 0.0);
+    probability[index(n, 0)] = 1.0;
+
+    std::vector<double> cdf(MAX_SESSIONS + 1, 0.0);
+    cdf[0] = (n == 0) ? 1.0 : 0.0;
+    if (n == 0 || k == 0) {
+        std::fill(cdf.begin(), cdf.end(), n == 0 ? 1.0 : 0.0);
+        return cdf;
+    }
+
+    const double log_total = logChoose(n, k);
+    for (int session = 1; session <= MAX_SESSIONS; ++session) {
+        std::fill(next.begin(), next.end(), 0.0);
+        for (int a0 = 0; a0 <= n; ++a0) {
+            for (int a1 = 0; a0 + a1 <= n; ++a1) {
+                double mass = probability[index(a0, a1)];
+                if (mass < 1e-15) continue;
+                int a2 = n - a0 - a1;
+                for (int x = 0; x <= std::min(k, a0); ++x) {
+                    for (int y = 0; y <= std::min(k - x, a1); ++y) {
+                        int z = k - x - y;
+                        if (z > a2) continue;
+                        double p = std::exp(logChoose(a0, x) + logChoose(a1, y) + logChoose(a2, z) - log_total);
+                        next[index(a0 - x, a1 - y + x)] += mass * p;
+                    }
+                }
+            }
+        }
+        probability.swap(next);
+        cdf[session] = probability[index(0, 0)];
+        if (cdf[session] > 1.0 - 1e-12) {
+            std::fill(cdf.begin() + session, cdf.end(), 1.0);
+            break;
+        }
+    }
+    return cdf;
+}
+
+/**
+ * @brief Гонка за класс: студенты из пулов входят в случайном порядке, пока не займут все места
+ *
+ * @param win_ks40 Вероятность, что КС-40 первой наберет порог
+ * @param win_ks44 Вероятность, что КС-44 первой наберет порог
+ * @param fail fail[i] - вероятность, что класс заполнился без занятия, и в нем i студентов КС-40
+ */
+void MarkovEstimator::race(int pool_ks40, int pool_ks44, double& win_ks40, double& win_ks44, std::vector<double>& fail) const {
+    win_ks40 = 0.0;
+    win_ks44 = 0.0;
+    const int need_ks40 = std::max(1, config.need_ks40);
+    const int need_ks44 = std::max(1, config.need_ks44);
+    fail.assign(need_ks40, 0.0);
+
+    // state[i] - вероятность, что из drawn вошедших i из КС-40, и никто еще не набрал порог
+    std::vector<double> state(need_ks40, 0.0);
+    std::vector<double> next(need_ks40, 0.0);
+    state[0] = 1.0;
+    for (int drawn = 0; drawn < config.capacity; ++drawn) {
+        std::fill(next.begin(), next.end(), 0.0);
+        for (int i = 0; i < need_ks40; ++i) {
+            int j = drawn - i;
+            if (j < 0 || state[i] == 0.0) continue;
+            int left_ks40 = pool_ks40 - i;
+            int left_ks44 = pool_ks44 - j;
+            if (left_ks40 + left_ks44 <= 0) {
+                // Все студенты пулов уже в классе, а порог не набран
+                fail[i] += state[i];
+                continue;
+            }
+            double p40 = static_cast<double>(left_ks40) / (left_ks40 + left_ks44);
+            if (i + 1 == need_ks40) win_ks40 += state[i] * p40;
+            else next[i + 1] += state[i] * p40;
+            if (j + 1 == need_ks44) win_ks44 += state[i] * (1.0 - p40);
+            else next[i] += state[i] * (1.0 - p40);
+        }
+        state.swap(next);
+    }
+    for (int i = 0; i < need_ks40; ++i) fail[i] += state[i];
+}
+
+/**
+ * @brief Цепь обновления заполненного класса без занятия
+ *
+ * Состояние - кол-во студентов КС-40 среди occupied студентов в классе. Каждые mean_wait / occupied мс
+ * случайный студент класса уходит по таймауту, и его место занимает случайный студент снаружи.
+ * Цепь - процесс рождения и гибели, поглощение - набор порога одной из групп, поэтому обе величины
+ * находятся прогонкой по трехдиагональной системе.
+ *
+ * @param win_ks40 win_ks40[i] - вероятность, что из состояния i занятие получит КС-40
+ * @param time_ms time_ms[i] - ожидаемое время до начала занятия из состояния i, мс
+ * @return false, если из какого-то состояния занятие недостижимо
+ */
+bool MarkovEstimator::refreshChain(std::vector<double>& win_ks40, std::vector<double>& time_ms) const {
+    const int occupied = std::min(config.capacity, config.total_ks40 + config.total_ks44);
+    const int need_ks40 = std::max(1, config.need_ks40);
+    const int need_ks44 = std::max(1, config.need_ks44);
+    const double step_ms = (config.min_wait_ms + config.max_wait_ms) / 2.0 / std::max(1, occupied);
+
+    win_ks40.assign(need_ks40, 0.0);
+    time_ms.assign(need_ks40, 0.0);
+    // Непоглощающие состояния: i < need_ks40 и occupied - i < need_ks44, причем i и occupied - i помещаются в группы
+    int low = std::max({ 0, occupied - need_ks44 + 1, occupied - config.total_ks44 });
+    int high = std::min({ need_ks40 - 1, config.total_ks40, occupied });
+    if (low > high) return true;
+
+    int size = high - low + 1;
+    std::vector<double> down(size), diag(size), up(size), rhs_win(size), rhs_time(size);
+    for (int k = 0; k < size; ++k) {
+        int i = low + k;
+        int j = occupied - i;
+        int out_ks40 = config.total_ks40 - i;
+        int out_ks44 = config.total_ks44 - j;
+        double p_down = 0.0, p_up = 0.0;
+        if (out_ks40 + out_ks44 > 0) {
+            p_down = static_cast<double>(i) / occupied * out_ks44 / (out_ks40 + out_ks44);
+            p_up = static_cast<double>(j) / occupied * out_ks40 / (out_ks40 + out_ks44);
+        }
+        diag[k] = p_down + p_up;
+        rhs_time[k] = step_ms;
+        rhs_win[k] = 0.0;
+        // Переход вниз: КС-44 прибавляет студента, выход за low - поглощение в пользу КС-44
+        if (k > 0) down[k] = -p_down;
+        // Переход вверх: выход за high - поглощение в пользу КС-40
+        if (k + 1 < size) up[k] = -p_up;
+        else rhs_win[k] += p_up;
+    }
+
+    // Прогонка
+    for (int k = 1; k < size; ++k) {
+        if (std::abs(diag[k - 1]) < 1e-300) return false;
+        double factor = down[k] / diag[k - 1];
+        diag[k] -= factor * up[k - 1];
+        rhs_win[k] -= factor * rhs_win[k - 1];
+        rhs_time[k] -= factor * rhs_time[k - 1];
+    }
+    for (int k = size - 1; k >= 0; --k) {
+        if (std::abs(diag[k]) < 1e-300) return false;
+        double next_win = (k + 1 < size) ? win_ks40[low + k + 1] : 0.0;
+        double next_time = (k + 1 < size) ? time_ms[low + k + 1] : 0.0;
+        win_ks40[low + k] = (rhs_win[k] - (k + 1 < size ? up[k] * next_win : 0.0)) / diag[k];
+        time_ms[low + k] = (rhs_time[k] - (k + 1 < size ? up[k] * next_time : 0.0)) / diag[k];
+    }
+    for (int i = 0; i < need_ks40; ++i) {
+        // Состояния вне цепи (класс не заполнен до occupied) приводятся к ближайшему
+        int k = std::min(std::max(i, low), high);
+        win_ks40[i] = win_ks40[k];
+        time_ms[i] = time_ms[k];
+    }
+    return true;
+}
+
+MarkovEstimate MarkovEstimator::estimate() const {
+    MarkovEstimate result;
+    const int size[3] = { 0, config.total_ks40, config.total_ks44 };
+    const int attend[3] = { 0, std::min(config.capacity, size[1]), std::min(config.capacity, size[2]) };
+
+    // Занятия возможны только если каждая группа может набрать свой порог
+    if (config.need_ks40 > attend[1] || config.need_ks44 > attend[2]) return result;
+    std::vector<double> refresh_win, refresh_ms;
+    if (!refreshChain(refresh_win, refresh_ms)) return result;
+    result.feasible = true;
+
+    // Гонка с заданными пулами, продолженная цепью обновления при неудаче
+    auto resolve = [&](int pool_ks40, int pool_ks44, double win[3], double& delay_ms) {
+        std::vector<double> fail;
+        race(pool_ks40, pool_ks44, win[1], win[2], fail);
+        delay_ms = 0.0;
+        for (size_t i = 0; i < fail.size(); ++i) {
+            win[1] += fail[i] * refresh_win[i];
+            win[2] += fail[i] * (1.0 - refresh_win[i]);
+            delay_ms += fail[i] * refresh_ms[i];
+        }
+    };
+
+    // Первое занятие: в гонке участвуют все студенты
+    double first[3] = {};
+    double start_ms = 0.0;
+    resolve(size[1], size[2], first, start_ms);
+
+    // Переходы цепи групп: после занятия g в гонке участвуют вся другая группа и не попавшие на занятие студенты g
+    double transition[3][3] = {};
+    double gap_ms[3] = {};
+    for (int g = 1; g <= 2; ++g) {
+        int pool_ks40 = (g == 1) ? size[1] - attend[1] : size[1];
+        int pool_ks44 = (g == 2) ? size[2] - attend[2] : size[2];
+        resolve(pool_ks40, pool_ks44, transition[g], gap_ms[g]);
+    }
+
+    // Стационарное распределение цепи групп - для средней паузы и доли смен группы
+    double to_ks44 = transition[1][2];
+    double to_ks40 = transition[2][1];
+    double share_ks40 = (to_ks40 + to_ks44 > 0) ? to_ks40 / (to_ks40 + to_ks44) : 0.5;
+    result.session_gap_ms = share_ks40 * gap_ms[1] + (1.0 - share_ks40) * gap_ms[2];
+    result.switch_probability = share_ks40 * to_ks44 + (1.0 - share_ks40) * to_ks40;
+
+    std::vector<double> done[3] = { {}, groupCompletionCdf(size[1]), groupCompletionCdf(size[2]) };
+
+    // dist[last][n1] - вероятность, что после t занятий последнее было у last, и КС-40 провела n1 из них
+    const int horizon = MAX_SESSIONS;
+    std::vector<std::vector<double>> dist(3, std::vector<double>(horizon + 1, 0.0));
+    std::vector<std::vector<double>> next(3, std::vector<double>(horizon + 1, 0.0));
+    dist[1][1] = first[1];
+    dist[2][0] = first[2];
+
+    result.completion_cdf.assign(1, (size[1] == 0 && size[2] == 0) ? 1.0 : 0.0);
+    result.completion_ms.assign(1, 0.0);
+    double previous_cdf = result.completion_cdf[0];
+    result.expected_sessions = 0.0;
+    result.expected_ms = 0.0;
+
+    for (int t = 1; t <= horizon; ++t) {
+        double cdf = 0.0;
+        for (int last = 1; last <= 2; ++last) {
+            for (int n1 = 0; n1 <= t; ++n1) {
+                double mass = dist[last][n1];
+                if (mass == 0.0) continue;
+                cdf += mass * done[1][n1] * done[2][t - n1];
+            }
+        }
+        result.completion_cdf.push_back(cdf);
+        result.completion_ms.push_back(start_ms);
+        result.expected_sessions += t * (cdf - previous_cdf);
+        result.expected_ms += start_ms * (cdf - previous_cdf);
+        previous_cdf = cdf;
+        // На горизонте следующего занятия уже не будет: строки dist рассчитаны на n1 <= horizon
+        if (cdf > 1.0 - 1e-9 || t == horizon) break;
+
+        // Следующее занятие начинается через session_ms и паузу после занятия группы last
+        double expected_gap = 0.0;
+        double total_mass = 0.0;
+        for (auto& row : next) std::fill(row.begin(), row.end(), 0.0);
+        for (int last = 1; last <= 2; ++last) {
+            for (int n1 = 0; n1 <= t; ++n1) {
+                double mass = dist[last][n1];
+                if (mass == 0.0) continue;
+                next[1][n1 + 1] += mass * transition[last][1];
+                next[2][n1] += mass * transition[last][2];
+                expected_gap += mass * gap_ms[last];
+                total_mass += mass;
+            }
+        }
+        dist.swap(next);
+        start_ms += config.session_ms + (total_mass > 0 ? expected_gap / total_mass : 0.0);
+    }
+    return result;
+}
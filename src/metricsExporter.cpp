@@ -0,0 +1,212 @@
+#include "../include/metricsExporter.h"
+#include <cstring>
+#include <sstream>
+#ifndef _WIN32 // Экспортер использует POSIX-сокеты, на Windows запуск возвращает false
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL // macOS и BSD: флага нет, SIGPIPE отключается на сокете клиента через SO_NOSIGPIPE
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+MetricsExporter::MetricsExporter(const ComputerRoom& room)
+    : room(room) {}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+int MetricsExporter::port() const {
+    return bound_port;
+}
+
+std::string MetricsExporter::render() const {
+    RoomMetrics metrics = room.metrics();
+    const LatencyHistogram& lock_wait = room.lockWaitHistogram();
+
+    std::ostringstream text;
+    text << "# HELP computer_room_occupancy Students currently in the room.\n"
+         << "# TYPE computer_room_occupancy gauge\n"
+         << "computer_room_occupancy " << metrics.occupancy << "\n"
+         << "# HELP computer_room_current_group Group holding the room (0 - none, 1 - KS-40, 2 - KS-44).\n"
+         << "# TYPE computer_room_current_group gauge\n"
+         << "computer_room_current_group " << metrics.current_group << "\n"
+         << "# HELP computer_room_in_session Whether a session is in progress.\n"
+         << "# TYPE computer_room_in_session gauge\n"
+         << "computer_room_in_session " << (metrics.in_session ? 1 : 0) << "\n"
+         << "# HELP computer_room_seat_waiters Students waiting for a seat.\n"
+         << "# TYPE computer_room_seat_waiters gauge\n"
+         << "computer_room_seat_waiters " << metrics.seat_waiters << "\n"
+         << "# HELP computer_room_utilisation_ratio Fraction of room uptime spent in sessions.\n"
+         << "# TYPE computer_room_utilisation_ratio gauge\n"
+         << "computer_room_utilisation_ratio " << metrics.utilisation << "\n"
+         << "# HELP computer_room_prestaged_sessions_total Sessions started back-to-back by a pre-staged group.\n"
+         << "# TYPE computer_room_prestaged_sessions_total counter\n"
+         << "computer_room_prestaged_sessions_total " << metrics.prestaged_sessions << "\n"
+         << "# HELP computer_room_seat_rejections_total Attempts turned away by a full seat wait list.\n"
+         << "# TYPE computer_room_seat_rejections_total counter\n"
+         << "computer_room_seat_rejections_total " << metrics.seat_rejections << "\n"
+         << "# HELP computer_room_seat_timeouts_total Attempts that gave up waiting for a seat.\n"
+         << "# TYPE computer_room_seat_timeouts_total counter\n"
+         << "computer_room_seat_timeouts_total " << metrics.seat_timeouts << "\n"
+         << "# HELP computer_room_sessions_started_total Sessions started.\n"
+         << "# TYPE computer_room_sessions_started_total counter\n"
+         << "computer_room_sessions_started_total " << metrics.sessions_started << "\n"
+         << "# HELP computer_room_students Students per group.\n"
+         << "# TYPE computer_room_students gauge\n"
+         << "computer_room_students{group=\"ks40\"} " << metrics.total_ks40 << "\n"
+         << "computer_room_students{group=\"ks44\"} " << metrics.total_ks44 << "\n"
+         << "# HELP computer_room_students_completed Students with all required visits per group.\n"
+         << "# TYPE computer_room_students_completed gauge\n"
+         << "computer_room_students_completed{group=\"ks40\"} " << metrics.completed_ks40 << "\n"
+         << "computer_room_students_completed{group=\"ks44\"} " << metrics.completed_ks44 << "\n"
+         << "# HELP computer_room_visits_credited_total Visits credited to students.\n"
+         << "# TYPE computer_room_visits_credited_total counter\n"
+         << "computer_room_visits_credited_total " << metrics.visits_credited << "\n"
+         << "# HELP computer_room_lock_acquisitions_total Room mutex acquisitions, including re-acquisitions after wakeups.\n"
+         << "# TYPE computer_room_lock_acquisitions_total counter\n"
+         << "computer_room_lock_acquisitions_total " << metrics.lock_acquisitions << "\n"
+         << "# HELP computer_room_lock_free_entries_total Entries that took a seat and presence without the room mutex.\n"
+         << "# TYPE computer_room_lock_free_entries_total counter\n"
+         << "computer_room_lock_free_entries_total " << metrics.lock_free_entries << "\n"
+         << "# HELP computer_room_lock_free_visits_total Visits that went from entry to session end without the room mutex.\n"
+         << "# TYPE computer_room_lock_free_visits_total counter\n"
+         << "computer_room_lock_free_visits_total " << metrics.lock_free_visits << "\n"
+         << "# HELP computer_room_wakeups_total Student wakeups on condition variables.\n"
+         << "# TYPE computer_room_wakeups_total counter\n"
+         << "computer_room_wakeups_total " << metrics.wakeups << "\n"
+         << "# HELP computer_room_lock_wait_seconds Time students wait to acquire the room mutex.\n"
+         << "# TYPE computer_room_lock_wait_seconds summary\n";
+    for (double quantile : { 0.5, 0.9, 0.99, 0.999 }) {
+        text << "computer_room_lock_wait_seconds{quantile=\"" << quantile << "\"} "
+             << lock_wait.percentile(quantile * 100.0) * 1e-9 << "\n";
+    }
+    text << "computer_room_lock_wait_seconds_sum " << lock_wait.sum() * 1e-9 << "\n"
+         << "computer_room_lock_wait_seconds_count " << lock_wait.count() << "\n";
+    return text.str();
+}
+
+#ifndef _WIN32
+
+bool MetricsExporter::startTcp(int port) {
+    if (running) return false;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    bound_port = ntohs(addr.sin_port);
+    return startListening(fd);
+}
+
+bool MetricsExporter::startUnix(const std::string& path) {
+    if (running) return false;
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    unix_path = path;
+    return startListening(fd);
+}
+
+bool MetricsExporter::startListening(int fd) {
+    if (listen(fd, 16) != 0) {
+        close(fd);
+        bound_port = 0;
+        if (!unix_path.empty()) unlink(unix_path.c_str());
+        unix_path.clear();
+        return false;
+    }
+    listen_fd = fd;
+    running = true;
+    worker = std::thread(&MetricsExporter::serveLoop, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!running.exchange(false)) return;
+    if (worker.joinable()) worker.join();
+    close(listen_fd);
+    listen_fd = -1;
+    bound_port = 0;
+    if (!unix_path.empty()) unlink(unix_path.c_str());
+    unix_path.clear();
+}
+
+/**
+ * @brief Цикл приема подключений; poll с таймаутом, чтобы stop() не ждал следующего клиента
+ */
+void MetricsExporter::serveLoop() {
+    while (running) {
+        pollfd listener{ listen_fd, POLLIN, 0 };
+        if (poll(&listener, 1, 100) <= 0) continue;
+        int client = accept(listen_fd, nullptr, nullptr);
+        if (client < 0) continue;
+#ifdef SO_NOSIGPIPE
+        int no_sigpipe = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+        serveClient(client);
+        close(client);
+    }
+}
+
+/**
+ * @brief Читает заголовки запроса (сам запрос не разбирается) и отвечает снимком метрик
+ */
+void MetricsExporter::serveClient(int client) const {
+    char buffer[1024];
+    std::string request;
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos && request.size() < 8192) {
+        pollfd peer{ client, POLLIN, 0 };
+        if (poll(&peer, 1, 1000) <= 0) return;
+        ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0) return;
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    std::string body = render();
+    std::string response = "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t written = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0) return;
+        sent += static_cast<size_t>(written);
+    }
+}
+
+#else
+
+bool MetricsExporter::startTcp(int) { return false; }
+bool MetricsExporter::startUnix(const std::string&) { return false; }
+bool MetricsExporter::startListening(int) { return false; }
+void MetricsExporter::stop() {}
+void MetricsExporter::serveLoop() {}
+void MetricsExporter::serveClient(int) const {}
+
+#endif
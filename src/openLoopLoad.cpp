@@ -0,0 +1,181 @@
+#include "../include/openLoopLoad.h"
+#include "../include/computerRoom.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+std::vector<int64_t> OpenLoopGenerator::arrivals(const LoadOptions& options) {
+    std::vector<int64_t> times;
+    const int64_t end_us = static_cast<int64_t>(options.duration_ms) * 1000;
+
+    if (options.process == ArrivalProcess::Trace) {
+        for (int ms : options.trace_ms) {
+            int64_t at = static_cast<int64_t>(ms) * 1000;
+            if (at >= 0 && at < end_us) times.push_back(at);
+        }
+        std::sort(times.begin(), times.end());
+        return times;
+    }
+    if (options.rate_per_s <= 0.0) return times;
+
+    std::mt19937_64 gen(options.seed);
+    int burst = (options.process == ArrivalProcess::Bursty) ? std::max(1, options.burst_size) : 1;
+    std::exponential_distribution<double> gap_s(options.rate_per_s / burst);
+    double at_s = 0.0;
+    while (true) {
+        at_s += gap_s(gen);
+        int64_t at = static_cast<int64_t>(at_s * 1e6);
+        if (at >= end_us) break;
+        for (int i = 0; i < burst; ++i) times.push_back(at);
+    }
+    return times;
+}
+
+bool OpenLoopGenerator::loadTrace(const std::string& path, std::vector<int>& trace_ms) {
+    std::ifstream file(path);
+    if (!file) return false;
+    trace_ms.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        try {
+            trace_ms.push_back(std::stoi(line));
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OpenLoopGenerator::run(const RoomConfig& config, const LoadOptions& options, LoadResult& result) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<int64_t> schedule = arrivals(options);
+    result.offered = static_cast<int>(schedule.size());
+    result.offered_rate = options.duration_ms > 0 ? result.offered * 1000.0 / options.duration_ms : 0.0;
+
+    RoomConfig room_config = config;
+    room_config.verbose = false;
+    ComputerRoom room(room_config);
+
+    // Прибытия, ожидающие свободного студента группы: запланированное время, мкс от начала.
+    // У каждой группы своя переменная условия, иначе notify_one может разбудить студента не той группы
+    std::mutex mtx;
+    std::condition_variable cv[3];
+    std::deque<int64_t> pending[3];
+    bool closed = false;
+    const Clock::time_point start = Clock::now();
+    auto sinceStart = [start]() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    };
+
+    auto student = [&](int group, int student_id) {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            cv[group].wait(lock, [&]() { return closed || !pending[group].empty(); });
+            if (pending[group].empty()) return;
+            int64_t intended_us = pending[group].front();
+            pending[group].pop_front();
+            lock.unlock();
+
+            AttemptOutcome outcome = room.visitOnce(group, student_id);
+            int64_t latency = std::max<int64_t>(0, sinceStart() - intended_us);
+
+            lock.lock();
+            if (outcome == AttemptOutcome::Stopped) {
+                result.unfinished++;
+                result.latency_us.record(static_cast<uint64_t>(latency));
+                continue;
+            }
+            result.completed++;
+            result.latency_us.record(static_cast<uint64_t>(latency));
+            if (outcome == AttemptOutcome::Attended) {
+                result.attended++;
+                result.attended_latency_us.record(static_cast<uint64_t>(latency));
+            }
+            else if (outcome == AttemptOutcome::TimedOut) result.timed_out++;
+            else if (outcome == AttemptOutcome::Rejected) result.rejected++;
+            else result.evicted++;
+        }
+    };
+
+    std::vector<std::thread> students;
+    for (int i = 0; i < config.total_ks40; ++i) students.emplace_back(student, 1, i);
+    for (int i = 0; i < config.total_ks44; ++i) students.emplace_back(student, 2, i);
+
+    // Генератор не ждет студентов: прибытие ставится в очередь в запланированный момент в любом случае
+    std::mt19937_64 gen(options.seed ^ 0x9E3779B97F4A7C15ULL);
+    std::uniform_int_distribution<int> pick(1, std::max(1, config.total_ks40 + config.total_ks44));
+    for (int64_t intended_us : schedule) {
+        std::this_thread::sleep_until(start + std::chrono::microseconds(intended_us));
+        int group = (pick(gen) <= config.total_ks40) ? 1 : 2;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            pending[group].push_back(intended_us);
+        }
+        cv[group].notify_one();
+    }
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(options.duration_ms));
+
+    // Даем начатым и ожидающим попыткам время завершиться
+    auto drain_deadline = Clock::now() + std::chrono::milliseconds(options.drain_ms);
+    while (Clock::now() < drain_deadline) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (result.completed + result.unfinished == result.offered) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        // Не начатые попытки учитываются с задержкой до конца прогона
+        int64_t now_us = sinceStart();
+        for (int group = 1; group <= 2; ++group) {
+            for (int64_t intended_us : pending[group]) {
+                result.unfinished++;
+                result.latency_us.record(static_cast<uint64_t>(std::max<int64_t>(0, now_us - intended_us)));
+            }
+            pending[group].clear();
+        }
+    }
+    result.elapsed_s = sinceStart() / 1e6;
+    room.stop();
+    cv[1].notify_all();
+    cv[2].notify_all();
+    for (auto& thread : students) thread.join();
+
+    RoomMetrics metrics = room.metrics();
+    result.sessions = metrics.sessions_started;
+    if (result.elapsed_s > 0) {
+        result.throughput = result.completed / result.elapsed_s;
+        result.visit_rate = metrics.visits_credited / result.elapsed_s;
+    }
+}
+
+std::vector<LoadPoint> OpenLoopGenerator::sweep(const RoomConfig& config, const LoadOptions& options, const std::vector<double>& rates) {
+    std::vector<LoadPoint> curve;
+    for (double rate : rates) {
+        LoadOptions point_options = options;
+        point_options.rate_per_s = rate;
+        LoadResult result;
+        run(config, point_options, result);
+
+        LoadPoint point;
+        point.rate_per_s = rate;
+        point.p50_us = result.latency_us.percentile(50.0);
+        point.p99_us = result.latency_us.percentile(99.0);
+        point.max_us = result.latency_us.max();
+        point.throughput = result.throughput;
+        point.visit_rate = result.visit_rate;
+        point.offered = result.offered;
+        point.unfinished = result.unfinished;
+        curve.push_back(point);
+    }
+    return curve;
+}
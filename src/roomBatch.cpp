@@ -0,0 +1,199 @@
+#include "../include/roomBatch.h"
+#include <chrono>
+#include <fstream>
+
+/**
+ * @brief Параметры класса для пакетного запуска: без вывода событий
+ */
+static RoomConfig quietConfig(RoomConfig config) {
+    config.verbose = false;
+    return config;
+}
+
+RoomBatchRunner::RoomBatchRunner(const RoomConfig& config)
+    : batch_room(quietConfig(config)),
+      total_students(config.total_ks40 + config.total_ks44) {
+    students.reserve(total_students);
+    for (int i = 0; i < config.total_ks40; ++i) students.emplace_back(&RoomBatchRunner::studentLoop, this, 1, i);
+    for (int i = 0; i < config.total_ks44; ++i) students.emplace_back(&RoomBatchRunner::studentLoop, this, 2, i);
+}
+
+RoomBatchRunner::~RoomBatchRunner() {
+    batch_room.stop();
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        closing = true;
+    }
+    start_cv.notify_all();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+}
+
+ComputerRoom& RoomBatchRunner::room() {
+    return batch_room;
+}
+
+/**
+ * @brief Поток студента пула: каждое новое поколение - один вызов studentBehavior до остановки класса
+ */
+void RoomBatchRunner::studentLoop(int group, int student_id) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pool_mtx);
+            start_cv.wait(lock, [&]() { return closing || generation != seen; });
+            if (closing) return;
+            seen = generation;
+        }
+        batch_room.studentBehavior(group, student_id);
+        {
+            std::lock_guard<std::mutex> lock(pool_mtx);
+            if (--running == 0) done_cv.notify_all();
+        }
+    }
+}
+
+BatchRunSummary RoomBatchRunner::runOnce(int timeout_ms) {
+    using Clock = std::chrono::steady_clock;
+    BatchRunSummary summary;
+    summary.run = ++runs_done;
+
+    auto reset_begin = Clock::now();
+    batch_room.reset();
+    auto start = Clock::now();
+    summary.reset_us = std::chrono::duration<double, std::micro>(start - reset_begin).count();
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        generation++;
+        running = total_students;
+    }
+    start_cv.notify_all();
+
+    // Завершение проверяется по атомарным счетчикам metrics, не захватывая мьютекс класса
+    auto deadline = start + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        RoomMetrics snapshot = batch_room.metrics();
+        if (snapshot.completed_ks40 + snapshot.completed_ks44 == total_students) {
+            summary.completed = true;
+            break;
+        }
+        if (Clock::now() >= deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    summary.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    RoomMetrics final_metrics = batch_room.metrics();
+    batch_room.stop();
+    {
+        std::unique_lock<std::mutex> lock(pool_mtx);
+        done_cv.wait(lock, [&]() { return running == 0; });
+    }
+
+    summary.sessions = final_metrics.sessions_started;
+    summary.prestaged_sessions = final_metrics.prestaged_sessions;
+    summary.visits = final_metrics.visits_credited;
+    summary.completed_ks40 = final_metrics.completed_ks40;
+    summary.completed_ks44 = final_metrics.completed_ks44;
+    summary.lock_acquisitions = final_metrics.lock_acquisitions;
+    summary.lock_free_visits = final_metrics.lock_free_visits;
+    summary.wakeups = final_metrics.wakeups;
+    summary.seat_rejections = final_metrics.seat_rejections;
+    summary.seat_timeouts = final_metrics.seat_timeouts;
+    summary.utilisation = final_metrics.utilisation;
+
+    completion_us.reset();
+    completion_us.merge(batch_room.studentLatency(1).time_to_completion_us);
+    completion_us.merge(batch_room.studentLatency(2).time_to_completion_us);
+    summary.completion_p50_ms = completion_us.percentile(50.0) / 1000;
+    summary.completion_p99_ms = completion_us.percentile(99.0) / 1000;
+    return summary;
+}
+
+int RoomBatchRunner::run(int runs, int timeout_ms, std::ostream& out) {
+    int completed = 0;
+    for (int i = 0; i < runs; ++i) {
+        BatchRunSummary summary = runOnce(timeout_ms);
+        if (summary.completed) completed++;
+        writeJson(out, summary);
+        out << '\n';
+    }
+    out.flush();
+    return completed;
+}
+
+void RoomBatchRunner::writeJson(std::ostream& out, const BatchRunSummary& summary) {
+    out << "{\"run\":" << summary.run
+        << ",\"completed\":" << (summary.completed ? "true" : "false")
+        << ",\"elapsed_ms\":" << summary.elapsed_ms
+        << ",\"reset_us\":" << summary.reset_us
+        << ",\"sessions\":" << summary.sessions
+        << ",\"prestaged_sessions\":" << summary.prestaged_sessions
+        << ",\"visits\":" << summary.visits
+        << ",\"completed_ks40\":" << summary.completed_ks40
+        << ",\"completed_ks44\":" << summary.completed_ks44
+        << ",\"lock_acquisitions\":" << summary.lock_acquisitions
+        << ",\"lock_free_visits\":" << summary.lock_free_visits
+        << ",\"wakeups\":" << summary.wakeups
+        << ",\"seat_rejections\":" << summary.seat_rejections
+        << ",\"seat_timeouts\":" << summary.seat_timeouts
+        << ",\"utilisation\":" << summary.utilisation
+        << ",\"completion_p50_ms\":" << summary.completion_p50_ms
+        << ",\"completion_p99_ms\":" << summary.completion_p99_ms << "}";
+}
+
+/**
+ * @brief Убирает пробелы и табуляции по краям строки
+ */
+static std::string trimmed(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return std::string();
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool loadRoomConfig(const std::string& path, RoomConfig& config) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        line = trimmed(line);
+        if (line.empty()) continue;
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) return false;
+        std::string key = trimmed(line.substr(0, equals));
+        std::string text = trimmed(line.substr(equals + 1));
+
+        int value = 0;
+        if (text == "true") value = 1;
+        else if (text != "false") {
+            try {
+                size_t parsed = 0;
+                value = std::stoi(text, &parsed);
+                if (parsed != text.size()) return false;
+            }
+            catch (const std::exception&) {
+                return false;
+            }
+        }
+
+        if (key == "capacity") config.capacity = value;
+        else if (key == "total_ks40") config.total_ks40 = value;
+        else if (key == "total_ks44") config.total_ks44 = value;
+        else if (key == "need_ks40") config.need_ks40 = value;
+        else if (key == "need_ks44") config.need_ks44 = value;
+        else if (key == "session_ms") config.session_ms = value;
+        else if (key == "min_wait_ms") config.min_wait_ms = value;
+        else if (key == "max_wait_ms") config.max_wait_ms = value;
+        else if (key == "retry_delay_ms") config.retry_delay_ms = value;
+        else if (key == "batched_admission") config.batched_admission = value != 0;
+        else if (key == "wait_list_limit") config.wait_list_limit = value;
+        else if (key == "wait_timeout_ms") config.wait_timeout_ms = value;
+        else if (key == "prestage_next_session") config.prestage_next_session = value != 0;
+        else if (key == "lock_free_entry") config.lock_free_entry = value != 0;
+        else return false;
+    }
+    return true;
+}
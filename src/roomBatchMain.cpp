@@ -0,0 +1,39 @@
+#include <iostream>
+#include <string>
+#include "computerRoom.h"
+#include "roomBatch.h"
+
+/**
+ * @brief Пакетный запуск симуляций без консольного вывода событий
+ *
+ * Класс и потоки студентов создаются один раз и переиспользуются всеми прогонами (см. RoomBatchRunner).
+ * На каждый прогон в stdout выводится одна строка JSON с итогами.
+ *
+ * @param argc Кол-во аргументов командной строки
+ * @param argv Аргументы: --config <файл> - параметры класса (см. loadRoomConfig, по умолчанию - вариант 20),
+ *             --runs <кол-во> - прогонов (по умолчанию 1),
+ *             --timeout-s <сек> - макс. длительность одного прогона (по умолчанию 200)
+ * @return 0 если все прогоны завершились до таймаута, 1 если нет или файл параметров не прочитан
+ */
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    RoomConfig config;
+    int runs = 1;
+    int timeout_s = 200;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--config") {
+            if (!loadRoomConfig(argv[++i], config)) {
+                std::cerr << "! Не удалось прочитать параметры класса из " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--runs") runs = std::stoi(argv[++i]);
+        else if (arg == "--timeout-s") timeout_s = std::stoi(argv[++i]);
+    }
+
+    RoomBatchRunner runner(config);
+    int completed = runner.run(runs, timeout_s * 1000, std::cout);
+    return completed == runs ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+#include "../include/roomEnsemble.h"
+#include <algorithm>
+#include <numeric>
+
+RoomEnsemble::RoomEnsemble(const RoomConfig& config)
+    : config(config) {
+    tick_ms = std::gcd(std::gcd(config.session_ms, config.retry_delay_ms), std::gcd(config.min_wait_ms, config.max_wait_ms));
+    if (tick_ms <= 0) tick_ms = 1;
+    session_ticks = config.session_ms / tick_ms;
+    min_wait_ticks = config.min_wait_ms / tick_ms;
+    max_wait_ticks = config.max_wait_ms / tick_ms;
+    retry_ticks = config.retry_delay_ms / tick_ms;
+
+    int total = config.total_ks40 + config.total_ks44;
+    group_of.resize(total);
+    phase.resize(total);
+    timer.resize(total);
+    visits.resize(total);
+    rng.resize(total);
+    for (int i = 0; i < total; ++i) group_of[i] = (i < config.total_ks40) ? 1 : 2;
+}
+
+int RoomEnsemble::tickMs() const {
+    return tick_ms;
+}
+
+/**
+ * @brief Выбор по маске полосы (-1 или 0) без ветвления
+ */
+static inline int32_t laneSelect(int32_t mask, int32_t if_set, int32_t if_clear) {
+    return (if_set & mask) | (if_clear & ~mask);
+}
+
+/**
+ * @brief Преподаватель завершает занятия в полосах ending: все оставшиеся выходят и уходят на паузу
+ */
+void RoomEnsemble::endSessions(int now, const int32_t* ending) {
+    const int total = static_cast<int>(phase.size());
+    const int32_t backoff_until = now + retry_ticks;
+    for (int i = 0; i < total; ++i) {
+        int32_t* p = phase[i].v;
+        int32_t* t = timer[i].v;
+        for (int l = 0; l < LANES; ++l) {
+            int32_t leave = -(ending[l] & ((p[l] == IN_ROOM) | (p[l] == ATTENDING)));
+            p[l] = laneSelect(leave, BACKOFF, p[l]);
+            t[l] = laneSelect(leave, backoff_until, t[l]);
+        }
+    }
+    for (int l = 0; l < LANES; ++l) {
+        int32_t keep = ending[l] - 1;
+        occupancy.v[l] &= keep;
+        present[1].v[l] &= keep;
+        present[2].v[l] &= keep;
+        session_group.v[l] &= keep;
+    }
+}
+
+/**
+ * @brief Начинает занятие группы в полосах starting: выгоняет студентов другой группы и засчитывает посещения
+ *
+ * Занятие в такте начинает студент, которого сейчас обходит модель, поэтому группа одна для всех полос.
+ */
+void RoomEnsemble::startSessions(int group, int now, const int32_t* starting) {
+    const int total = static_cast<int>(phase.size());
+    const int32_t backoff_until = now + retry_ticks;
+    for (int l = 0; l < LANES; ++l) {
+        session_group.v[l] = laneSelect(-starting[l], group, session_group.v[l]);
+        session_end.v[l] = laneSelect(-starting[l], now + session_ticks, session_end.v[l]);
+        sessions.v[l] += starting[l];
+    }
+    for (int i = 0; i < total; ++i) {
+        int32_t* p = phase[i].v;
+        if (group_of[i] != group) {
+            int32_t* t = timer[i].v;
+            int32_t* other_present = present[group_of[i]].v;
+            for (int l = 0; l < LANES; ++l) {
+                int32_t evict = starting[l] & (p[l] == IN_ROOM);
+                p[l] = laneSelect(-evict, BACKOFF, p[l]);
+                t[l] = laneSelect(-evict, backoff_until, t[l]);
+                other_present[l] -= evict;
+                occupancy.v[l] -= evict;
+            }
+        }
+        else {
+            int32_t* v = visits[i].v;
+            for (int l = 0; l < LANES; ++l) {
+                int32_t attend = starting[l] & (p[l] == IN_ROOM);
+                p[l] = laneSelect(-attend, ATTENDING, p[l]);
+                v[l] += attend;
+                lagging.v[l] -= attend & (v[l] == RoomSimulator::REQUIRED_VISITS);
+            }
+        }
+    }
+}
+
+void RoomEnsemble::runLanes(const uint64_t* seeds, int cutoff_ms, SimResult* results) {
+    const int total = static_cast<int>(phase.size());
+    const int need[3] = { 0, config.need_ks40, config.need_ks44 };
+    const uint64_t wait_range = static_cast<uint64_t>(max_wait_ticks - min_wait_ticks + 1);
+    // Для draw < 2^32 частное (draw * wait_magic) >> 32 больше точного не более чем на 1
+    const uint64_t wait_magic = ((uint64_t(1) << 32) + wait_range - 1) / wait_range;
+    const int cutoff_ticks = cutoff_ms / tick_ms;
+
+    for (int i = 0; i < total; ++i) {
+        for (int l = 0; l < LANES; ++l) {
+            phase[i].v[l] = READY;
+            timer[i].v[l] = 0;
+            visits[i].v[l] = 0;
+            rng[i].v[l] = RoomSimulator::seedStudent(seeds[l], i);
+        }
+    }
+    for (int l = 0; l < LANES; ++l) {
+        occupancy.v[l] = 0;
+        present[1].v[l] = present[2].v[l] = 0;
+        session_group.v[l] = 0;
+        session_end.v[l] = 0;
+        lagging.v[l] = total;
+        sessions.v[l] = 0;
+        results[l] = SimResult();
+    }
+
+    int remaining = LANES;
+    int32_t mask[LANES];
+    for (int now = 0; now <= cutoff_ticks && remaining > 0; ++now) {
+        int any = 0;
+        for (int l = 0; l < LANES; ++l) {
+            mask[l] = (session_group.v[l] != 0) & (now >= session_end.v[l]);
+            any |= mask[l];
+        }
+        if (any) endSessions(now, mask);
+
+        // Порядок обхода тот же, что в RoomSimulator::run, и одинаков во всех полосах
+        int i = now % total;
+        for (int k = 0; k < total; ++k, i = (i + 1 == total) ? 0 : i + 1) {
+            const int group = group_of[i];
+
+            // Полосы копируются в локальные массивы, а условия записаны масками без ветвлений: после развертки
+            // цикла по полосам компилятор собирает одинаковые операции восьми полос в векторные
+            LaneInts p = phase[i];
+            LaneInts t = timer[i];
+
+            // Пауза закончилась - студент снова решает прийти. Студенты на паузе и на занятии в такте ничего
+            // не делают, и если так во всех полосах, студент пропускается, как continue в скалярной модели
+            int32_t ready_any = 0;
+            int32_t active_any = 0;
+            for (int l = 0; l < LANES; ++l) {
+                int32_t resume = -((p.v[l] == BACKOFF) & (now >= t.v[l]));
+                p.v[l] = laneSelect(resume, READY, p.v[l]);
+                ready_any |= p.v[l] == READY;
+                active_any |= (p.v[l] != BACKOFF) & (p.v[l] != ATTENDING);
+            }
+            if (!active_any) continue;
+
+            if (ready_any) {
+                // Решил прийти: время ожидания начала занятия из генератора студента (тот же xorshift64*, что у модели).
+                // Остаток считается умножением на обратное число с одной поправкой: целое деление не векторизуется
+                LaneRandoms r = rng[i];
+                for (int l = 0; l < LANES; ++l) {
+                    uint64_t state = r.v[l];
+                    uint64_t next = state ^ (state >> 12);
+                    next ^= next << 25;
+                    next ^= next >> 27;
+                    uint64_t draw = (next * 0x2545F4914F6CDD1DULL) >> 32;
+                    int64_t rest = static_cast<int64_t>(draw - ((draw * wait_magic) >> 32) * wait_range);
+                    rest += static_cast<int64_t>(wait_range) & -static_cast<int64_t>(rest < 0);
+                    int32_t ready = -(p.v[l] == READY);
+                    uint64_t ready_wide = static_cast<uint64_t>(static_cast<int64_t>(ready));
+                    r.v[l] = (next & ready_wide) | (state & ~ready_wide);
+                    t.v[l] = laneSelect(ready, now + min_wait_ticks + static_cast<int32_t>(rest), t.v[l]);
+                    p.v[l] = laneSelect(ready, BLOCKED, p.v[l]);
+                }
+                rng[i] = r;
+            }
+
+            LaneInts v = visits[i];
+            LaneInts occupied = occupancy;
+            LaneInts own_present = present[group];
+            LaneInts behind = lagging;
+            const LaneInts current = session_group;
+            const int32_t capacity = config.capacity;
+            const int32_t group_need = need[group];
+            const int32_t backoff_until = now + retry_ticks;
+            int32_t starts_any = 0;
+            for (int l = 0; l < LANES; ++l) {
+                // Вход, если есть место и нет занятия другой группы
+                int32_t group_now = current.v[l];
+                int32_t enter = (p.v[l] == BLOCKED) & (occupied.v[l] < capacity) & ((group_now == 0) | (group_now == group));
+                occupied.v[l] += enter;
+                own_present.v[l] += enter;
+                int32_t attend = enter & (group_now == group);
+                v.v[l] += attend;
+                behind.v[l] -= attend & (v.v[l] == RoomSimulator::REQUIRED_VISITS);
+                p.v[l] = laneSelect(-enter, laneSelect(-attend, ATTENDING, IN_ROOM), p.v[l]);
+
+                // Набралось студентов для начала занятия: посещения засчитает startSessions
+                int32_t starts = enter & (group_now == 0) & (own_present.v[l] >= group_need);
+                mask[l] = starts;
+                starts_any |= starts;
+
+                // Не дождался начала занятия и вышел
+                int32_t leave = (p.v[l] == IN_ROOM) & (starts ^ 1) & (now >= t.v[l]);
+                p.v[l] = laneSelect(-leave, BACKOFF, p.v[l]);
+                t.v[l] = laneSelect(-leave, backoff_until, t.v[l]);
+                occupied.v[l] -= leave;
+                own_present.v[l] -= leave;
+            }
+            phase[i] = p;
+            timer[i] = t;
+            visits[i] = v;
+            occupancy = occupied;
+            present[group] = own_present;
+            lagging = behind;
+            if (starts_any) startSessions(group, now, mask);
+        }
+
+        for (int l = 0; l < LANES; ++l) {
+            if (results[l].completed || lagging.v[l] != 0) continue;
+            results[l].completed = true;
+            results[l].completion_ms = now * tick_ms;
+            results[l].sessions = sessions.v[l];
+            remaining--;
+        }
+    }
+
+    for (int l = 0; l < LANES; ++l) {
+        if (results[l].completed) continue;
+        results[l].completion_ms = cutoff_ms;
+        results[l].sessions = sessions.v[l];
+    }
+}
+
+std::vector<SimResult> RoomEnsemble::run(const std::vector<uint64_t>& seeds, int cutoff_ms) {
+    std::vector<SimResult> results(seeds.size());
+    uint64_t lane_seeds[LANES];
+    SimResult lane_results[LANES];
+    for (size_t begin = 0; begin < seeds.size(); begin += LANES) {
+        size_t count = std::min(seeds.size() - begin, static_cast<size_t>(LANES));
+        // Неполный последний пакет дополняется повторами последнего зерна, их результаты отбрасываются
+        for (size_t l = 0; l < static_cast<size_t>(LANES); ++l) lane_seeds[l] = seeds[begin + std::min(l, count - 1)];
+        runLanes(lane_seeds, cutoff_ms, lane_results);
+        std::copy(lane_results, lane_results + count, results.begin() + begin);
+    }
+    return results;
+}
@@ -0,0 +1,177 @@
+#include "../include/roomEvents.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+static_assert(offsetof(RoomEvent, seq) == 0, "drainCoalesced читает seq из первого слова события");
+
+EventSubscription::EventSubscription(size_t capacity, OverflowPolicy policy)
+    : overflow_policy(policy) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    cells.reset(new Cell[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+OverflowPolicy EventSubscription::policy() const {
+    return overflow_policy;
+}
+
+size_t EventSubscription::capacity() const {
+    return mask + 1;
+}
+
+uint64_t EventSubscription::dropped() const {
+    return dropped_count.load(std::memory_order_relaxed);
+}
+
+uint64_t EventSubscription::coalesced() const {
+    return coalesced_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Записывает событие в ячейку tail, если потребители ее уже освободили
+ */
+bool EventSubscription::tryPush(const RoomEvent& event) {
+    Cell& cell = cells[tail & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != tail) return false;
+    cell.event = event;
+    cell.sequence.store(tail + 1, std::memory_order_release);
+    tail++;
+    return true;
+}
+
+void EventSubscription::coalesce(const RoomEvent& event) {
+    CoalesceSlot& slot = slots[static_cast<int>(event.kind) * 3 + event.group];
+    uint64_t words[EVENT_WORDS] = {};
+    std::memcpy(words, &event, sizeof(RoomEvent));
+
+    uint32_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t w = 0; w < EVENT_WORDS; ++w) slot.latest[w].store(words[w], std::memory_order_relaxed);
+    slot.version.store(version + 2, std::memory_order_release);
+    slot.pending.fetch_add(1, std::memory_order_release);
+    coalesced_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Потребители забрали все объединенные события
+ */
+bool EventSubscription::coalescedDrained() const {
+    for (const CoalesceSlot& slot : slots) {
+        if (slot.pending.load(std::memory_order_acquire) > 0) return false;
+    }
+    return true;
+}
+
+void EventSubscription::publish(const RoomEvent& event) {
+    // В режиме объединения новые события не обгоняют еще не забранные объединенные
+    if (coalescing.load(std::memory_order_relaxed)) {
+        if (!coalescedDrained() || !tryPush(event)) {
+            coalesce(event);
+            return;
+        }
+        coalescing.store(false, std::memory_order_release);
+        return;
+    }
+    if (tryPush(event)) return;
+
+    if (overflow_policy == OverflowPolicy::Drop) {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    coalescing.store(true, std::memory_order_release);
+    coalesce(event);
+}
+
+/**
+ * @brief Забирает объединенные события в порядке seq
+ *
+ * Если все не помещаются, забираются ячейки с меньшими seq: seq оставшихся ячеек только растет, поэтому
+ * следующий drain не отдаст событие старее уже отданных.
+ */
+size_t EventSubscription::drainCoalesced(RoomEvent* events, size_t max_events) {
+    std::pair<uint64_t, int> order[SLOTS]; // (seq последнего события, ячейка)
+    int candidates = 0;
+    for (int i = 0; i < SLOTS; ++i) {
+        if (slots[i].pending.load(std::memory_order_acquire) == 0) continue;
+        order[candidates++] = { slots[i].latest[0].load(std::memory_order_relaxed), i }; // seq - первое слово события
+    }
+    std::sort(order, order + candidates);
+
+    size_t taken = 0;
+    for (int c = 0; c < candidates && taken < max_events; ++c) {
+        CoalesceSlot& slot = slots[order[c].second];
+        // Событие, записанное между exchange и чтением, придет сейчас и еще раз со своим count: сумма count не меняется
+        uint32_t pending = slot.pending.exchange(0, std::memory_order_acquire);
+        if (pending == 0) continue;
+
+        uint64_t words[EVENT_WORDS];
+        uint32_t before, after;
+        do {
+            before = slot.version.load(std::memory_order_acquire);
+            for (size_t w = 0; w < EVENT_WORDS; ++w) words[w] = slot.latest[w].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.version.load(std::memory_order_relaxed);
+        } while (before != after || (before & 1));
+        RoomEvent& latest = events[taken++];
+        std::memcpy(&latest, words, sizeof(RoomEvent));
+        latest.count = pending;
+    }
+    std::sort(events, events + taken, [](const RoomEvent& a, const RoomEvent& b) { return a.seq < b.seq; });
+    return taken;
+}
+
+size_t EventSubscription::drain(RoomEvent* events, size_t max_events) {
+    if (max_events == 0) return 0;
+
+    uint64_t position = head.load(std::memory_order_relaxed);
+    size_t ready = 0;
+    while (true) {
+        // Сколько ячеек подряд от position уже записано производителем
+        ready = 0;
+        while (ready < max_events && ready <= mask
+               && cells[(position + ready) & mask].sequence.load(std::memory_order_acquire) == position + ready + 1) {
+            ready++;
+        }
+        if (ready == 0) break;
+        if (head.compare_exchange_weak(position, position + ready, std::memory_order_relaxed)) break;
+    }
+
+    for (size_t i = 0; i < ready; ++i) {
+        Cell& cell = cells[(position + i) & mask];
+        events[i] = cell.event;
+        cell.sequence.store(position + i + mask + 1, std::memory_order_release);
+    }
+    if (ready == max_events || !coalescing.load(std::memory_order_acquire)) return ready;
+
+    // Объединенные события новее забранных из очереди: пачка остается упорядоченной по seq
+    size_t merged = drainCoalesced(events + ready, max_events - ready);
+    std::inplace_merge(events, events + ready, events + ready + merged,
+                       [](const RoomEvent& a, const RoomEvent& b) { return a.seq < b.seq; });
+    return ready + merged;
+}
+
+size_t EventSubscription::drain(std::vector<RoomEvent>& events, size_t max_events) {
+    size_t offset = events.size();
+    events.resize(offset + max_events);
+    size_t taken = drain(events.data() + offset, max_events);
+    events.resize(offset + taken);
+    return taken;
+}
+
+std::shared_ptr<EventSubscription> RoomEventHub::subscribe(size_t capacity, OverflowPolicy policy) {
+    subscriptions.push_back(std::make_shared<EventSubscription>(capacity, policy));
+    return subscriptions.back();
+}
+
+void RoomEventHub::unsubscribe(const std::shared_ptr<EventSubscription>& subscription) {
+    subscriptions.erase(std::remove(subscriptions.begin(), subscriptions.end(), subscription), subscriptions.end());
+}
+
+void RoomEventHub::publish(RoomEvent event) {
+    event.seq = next_seq++;
+    for (const auto& subscription : subscriptions) subscription->publish(event);
+}
@@ -0,0 +1,164 @@
+#include "../include/roomPlacement.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#ifdef __linux__ // Привязка и политики памяти - системные вызовы Linux, на других ОС - запасной вариант без NUMA
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+// Константы из linux/mempolicy.h, чтобы не зависеть от libnuma
+static const int MPOL_PREFERRED_MODE = 1;
+static const int MPOL_F_NODE_FLAG = 1;
+static const int MPOL_F_ADDR_FLAG = 2;
+static const unsigned long MAX_NODES = 1024;
+static const size_t MASK_WORDS = MAX_NODES / (8 * sizeof(unsigned long));
+#endif
+
+/**
+ * @brief Разбирает список процессоров вида "0-3,8,10-11"
+ */
+static std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        catch (const std::exception&) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+NumaTopology NumaTopology::detect() {
+    NumaTopology topology;
+#ifdef __linux__
+    for (int node = 0;; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) break;
+        std::string text;
+        std::getline(file, text);
+        topology.node_cpus.push_back(parseCpuList(text));
+    }
+    topology.from_system = !topology.node_cpus.empty();
+#endif
+    if (topology.node_cpus.empty()) {
+        unsigned int count = std::thread::hardware_concurrency();
+        std::vector<int> cpus;
+        for (unsigned int cpu = 0; cpu < (count ? count : 1); ++cpu) cpus.push_back(static_cast<int>(cpu));
+        topology.node_cpus.push_back(cpus);
+    }
+    return topology;
+}
+
+int NumaTopology::nodeCount() const {
+    return static_cast<int>(node_cpus.size());
+}
+
+const std::vector<int>& NumaTopology::cpusOf(int node) const {
+    static const std::vector<int> none;
+    if (node < 0 || node >= nodeCount()) return none;
+    return node_cpus[node];
+}
+
+int NumaTopology::nodeOfCpu(int cpu) const {
+    for (int node = 0; node < nodeCount(); ++node) {
+        for (int candidate : node_cpus[node]) {
+            if (candidate == cpu) return node;
+        }
+    }
+    return -1;
+}
+
+RoomPlacement NumaTopology::placementForRoom(int room_index) const {
+    RoomPlacement placement;
+    placement.numa_node = room_index % nodeCount();
+    placement.cpus = node_cpus[placement.numa_node];
+    return placement;
+}
+
+bool NumaTopology::fromSystem() const {
+    return from_system;
+}
+
+#ifdef __linux__
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+int pageNode(const void* address) {
+    // get_mempolicy с MPOL_F_NODE | MPOL_F_ADDR возвращает узел страницы по адресу
+    int node = -1;
+    long result = syscall(SYS_get_mempolicy, &node, nullptr, 0UL, const_cast<void*>(address),
+                          static_cast<unsigned long>(MPOL_F_NODE_FLAG | MPOL_F_ADDR_FLAG));
+    return result == 0 ? node : -1;
+}
+
+NumaCounters readNumaCounters() {
+    NumaCounters counters;
+    for (int node = 0;; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/numastat");
+        if (!file) break;
+        counters.available = true;
+        std::string name;
+        long long value;
+        while (file >> name >> value) {
+            if (name == "local_node") counters.local_node += value;
+            else if (name == "other_node") counters.other_node += value;
+        }
+    }
+    return counters;
+}
+
+MemoryPolicyScope::MemoryPolicyScope(int node)
+    : old_mask(MASK_WORDS, 0) {
+    if (node < 0 || static_cast<unsigned long>(node) >= MAX_NODES) return;
+    if (syscall(SYS_get_mempolicy, &old_mode, old_mask.data(), MAX_NODES, nullptr, 0UL) != 0) return;
+
+    std::vector<unsigned long> mask(MASK_WORDS, 0);
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED_MODE, mask.data(), MAX_NODES) != 0) return;
+    active = true;
+    was_applied = true;
+}
+
+void MemoryPolicyScope::restore() {
+    if (!active) return;
+    syscall(SYS_set_mempolicy, old_mode, old_mode == 0 ? nullptr : old_mask.data(), MAX_NODES);
+    active = false;
+}
+
+#else
+
+bool pinCurrentThread(const std::vector<int>&) { return false; }
+int pageNode(const void*) { return -1; }
+NumaCounters readNumaCounters() { return NumaCounters(); }
+MemoryPolicyScope::MemoryPolicyScope(int) {}
+void MemoryPolicyScope::restore() {}
+
+#endif
+
+MemoryPolicyScope::~MemoryPolicyScope() {
+    restore();
+}
+
+bool MemoryPolicyScope::applied() const {
+    return was_applied;
+}
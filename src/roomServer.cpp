@@ -0,0 +1,727 @@
+#include "../include/roomServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#ifdef __linux__ // epoll, eventfd и memfd - системные вызовы Linux, на других ОС сервер и клиент не запускаются
+#include <cerrno>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Состояние одного соединения, живет в цикле событий
+ */
+struct RoomServer::Connection {
+    int fd = -1;
+    uint64_t serial = 0;
+    uint32_t events = 0; // Подписка epoll
+    size_t partial_bytes = 0; // Начало неполного кадра в partial
+    char partial[sizeof(RoomRequest)];
+    std::string out; // Ответы, еще не отправленные в сокет
+    std::vector<int> held; // Студенты (индексы как в visiting), вошедшие через TryEnter и не вышедшие
+    int passed_fd = -1; // Дескриптор памяти колец, пришедший с AttachRing
+    SharedRings* rings = nullptr;
+    std::vector<RoomReply> backlog; // Ответы, не поместившиеся в заполненное кольцо
+    bool ring_dirty = false; // В кольцо добавлены ответы, клиенту нужен Doorbell
+};
+
+static const size_t READ_FRAMES = 8192; // Кадров за один recvmsg
+static const size_t MAX_PENDING_OUT = 1 << 20; // Пока столько ответов не отправлено, запросы соединения не читаются
+
+/**
+ * @brief Исход попытки как результат запроса Visit
+ */
+static RoomStatus statusOf(AttemptOutcome outcome) {
+    switch (outcome) {
+    case AttemptOutcome::Attended: return RoomStatus::Attended;
+    case AttemptOutcome::TimedOut: return RoomStatus::TimedOut;
+    case AttemptOutcome::Evicted: return RoomStatus::Evicted;
+    case AttemptOutcome::Rejected: return RoomStatus::Rejected;
+    default: return RoomStatus::Stopped;
+    }
+}
+
+RoomServer::RoomServer(ComputerRoom& room, int visit_workers)
+    : room(room), workers_wanted(visit_workers) {
+    RoomMetrics metrics = room.metrics();
+    total_ks40 = metrics.total_ks40;
+    total_ks44 = metrics.total_ks44;
+    visiting.assign(total_ks40 + total_ks44, false);
+}
+
+RoomServer::~RoomServer() {
+    stop();
+}
+
+int RoomServer::connections() const {
+    return open_connections.load();
+}
+
+long long RoomServer::requestsServed() const {
+    return served.load();
+}
+
+int RoomServer::studentIndex(int group, int student_id) const {
+    if (group == 1 && student_id >= 0 && student_id < total_ks40) return student_id;
+    if (group == 2 && student_id >= 0 && student_id < total_ks44) return total_ks40 + student_id;
+    return -1;
+}
+
+RoomReply RoomServer::replyTo(const RoomRequest& request, RoomStatus status) const {
+    RoomReply reply;
+    reply.tag = request.tag;
+    reply.op = request.op;
+    reply.status = static_cast<uint8_t>(status);
+    reply.occupancy = static_cast<uint8_t>(std::min(room.currentOccupancy(), 255));
+    reply.group = static_cast<uint8_t>(room.currentGroup());
+    return reply;
+}
+
+#ifdef __linux__
+
+bool RoomServer::start(const std::string& path) {
+    if (running) return false;
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event listener{};
+    listener.events = EPOLLIN;
+    listener.data.fd = fd;
+    epoll_event wake{};
+    wake.events = EPOLLIN;
+    wake.data.fd = wake_fd;
+    if (epoll_fd < 0 || wake_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &listener) != 0
+        || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &wake) != 0) {
+        if (epoll_fd >= 0) close(epoll_fd);
+        if (wake_fd >= 0) close(wake_fd);
+        epoll_fd = wake_fd = -1;
+        close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+    listen_fd = fd;
+    socket_path = path;
+    read_buffer.resize(READ_FRAMES);
+
+    jobs_closed = false;
+    int count = workers_wanted > 0 ? workers_wanted : std::max(1, total_ks40 + total_ks44);
+    for (int i = 0; i < count; ++i) workers.emplace_back(&RoomServer::visitWorker, this);
+    running = true;
+    loop = std::thread(&RoomServer::eventLoop, this);
+    return true;
+}
+
+void RoomServer::stop() {
+    if (!running.exchange(false)) return;
+    uint64_t one = 1;
+    (void)!write(wake_fd, &one, sizeof(one));
+    if (loop.joinable()) loop.join();
+
+    // Не начатые попытки отбрасываются, начатые досиживаются
+    {
+        std::lock_guard<std::mutex> lock(jobs_mtx);
+        jobs_closed = true;
+        jobs.clear();
+    }
+    jobs_cv.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+    completions.clear();
+    std::fill(visiting.begin(), visiting.end(), false);
+
+    close(epoll_fd);
+    close(wake_fd);
+    close(listen_fd);
+    epoll_fd = wake_fd = listen_fd = -1;
+    unlink(socket_path.c_str());
+    socket_path.clear();
+}
+
+/**
+ * @brief Цикл событий: прием соединений, пакеты запросов, ответы пула; таймаут epoll - для проверки stop()
+ */
+void RoomServer::eventLoop() {
+    epoll_event events[256];
+    while (running) {
+        int ready = epoll_wait(epoll_fd, events, 256, 100);
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                acceptClients();
+                continue;
+            }
+            if (fd == wake_fd) {
+                uint64_t count = 0;
+                (void)!read(wake_fd, &count, sizeof(count));
+                deliverCompletions();
+                continue;
+            }
+            if (fd < 0 || static_cast<size_t>(fd) >= clients.size() || !clients[fd]) continue;
+            Connection& connection = *clients[fd];
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !readClient(connection)) continue;
+            if (events[i].events & EPOLLOUT) flushClient(connection);
+        }
+    }
+    for (size_t fd = 0; fd < clients.size(); ++fd) {
+        if (clients[fd]) closeClient(static_cast<int>(fd));
+    }
+}
+
+void RoomServer::acceptClients() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        if (static_cast<size_t>(fd) >= clients.size()) clients.resize(fd + 1);
+        clients[fd].reset(new Connection());
+        clients[fd]->fd = fd;
+        clients[fd]->serial = next_serial++;
+        clients[fd]->events = EPOLLIN;
+        open_connections++;
+    }
+}
+
+/**
+ * @brief Читает все доступные кадры соединения и обрабатывает их пакетом, ответы отправляются одной записью
+ *
+ * @return false, если соединение закрыто
+ */
+bool RoomServer::readClient(Connection& connection) {
+    char* buffer = reinterpret_cast<char*>(read_buffer.data());
+    const size_t capacity = read_buffer.size() * sizeof(RoomRequest);
+    while (true) {
+        // Начало неполного кадра из прошлого чтения ставится перед новыми байтами
+        size_t carried = connection.partial_bytes;
+        std::memcpy(buffer, connection.partial, carried);
+
+        char control[CMSG_SPACE(sizeof(int))];
+        iovec io{ buffer + carried, capacity - carried };
+        msghdr message{};
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        ssize_t received = recvmsg(connection.fd, &message, MSG_CMSG_CLOEXEC);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) break;
+        if (received <= 0) {
+            closeClient(connection.fd);
+            return false;
+        }
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) continue;
+            int passed = -1;
+            std::memcpy(&passed, CMSG_DATA(header), sizeof(passed));
+            if (connection.passed_fd >= 0) close(connection.passed_fd);
+            connection.passed_fd = passed;
+        }
+
+        size_t total = carried + static_cast<size_t>(received);
+        size_t count = total / sizeof(RoomRequest);
+        connection.partial_bytes = total % sizeof(RoomRequest);
+        std::memcpy(connection.partial, buffer + count * sizeof(RoomRequest), connection.partial_bytes);
+        handleFrames(connection, read_buffer.data(), count);
+        if (total < capacity) break;
+    }
+    return flushClient(connection);
+}
+
+void RoomServer::handleFrames(Connection& connection, const RoomRequest* frames, size_t count) {
+    long long requests = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (frames[i].op != static_cast<uint8_t>(RoomOp::Doorbell)) requests++;
+        handleRequest(connection, frames[i]);
+    }
+    served += requests;
+}
+
+void RoomServer::handleRequest(Connection& connection, const RoomRequest& request) {
+    switch (static_cast<RoomOp>(request.op)) {
+    case RoomOp::Status:
+        sendReply(connection, replyTo(request, RoomStatus::Ok));
+        return;
+    case RoomOp::TryEnter: {
+        int student = studentIndex(request.group, request.student_id);
+        if (student < 0) break;
+        if (visiting[student]) {
+            sendReply(connection, replyTo(request, RoomStatus::Busy));
+            return;
+        }
+        if (!room.enterStudent(request.group, request.student_id)) {
+            sendReply(connection, replyTo(request, RoomStatus::Refused));
+            return;
+        }
+        visiting[student] = true;
+        connection.held.push_back(student);
+        sendReply(connection, replyTo(request, RoomStatus::Ok));
+        return;
+    }
+    case RoomOp::Leave: {
+        int student = studentIndex(request.group, request.student_id);
+        auto held = std::find(connection.held.begin(), connection.held.end(), student);
+        if (student < 0 || held == connection.held.end()) break;
+        connection.held.erase(held);
+        visiting[student] = false;
+        bool left = room.leaveStudent(request.group, request.student_id);
+        sendReply(connection, replyTo(request, left ? RoomStatus::Ok : RoomStatus::Evicted));
+        return;
+    }
+    case RoomOp::Visit: {
+        int student = studentIndex(request.group, request.student_id);
+        if (student < 0) break;
+        if (visiting[student]) {
+            sendReply(connection, replyTo(request, RoomStatus::Busy));
+            return;
+        }
+        visiting[student] = true;
+        {
+            std::lock_guard<std::mutex> lock(jobs_mtx);
+            jobs.push_back(VisitJob{ connection.fd, connection.serial, request });
+        }
+        jobs_cv.notify_one();
+        return;
+    }
+    case RoomOp::AttachRing:
+        attachRing(connection, request);
+        return;
+    case RoomOp::Doorbell:
+        drainRing(connection);
+        return;
+    }
+    sendReply(connection, replyTo(request, RoomStatus::BadRequest));
+}
+
+/**
+ * @brief Отображает память колец, переданную клиентом; ответ на AttachRing еще идет через сокет
+ */
+void RoomServer::attachRing(Connection& connection, const RoomRequest& request) {
+    int memory = connection.passed_fd;
+    connection.passed_fd = -1;
+    struct stat info {};
+    void* mapped = MAP_FAILED;
+    // Проверка размера: обращение за концом файла дало бы SIGBUS
+    if (!connection.rings && memory >= 0 && fstat(memory, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(SharedRings))) {
+        mapped = mmap(nullptr, sizeof(SharedRings), PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0);
+    }
+    if (memory >= 0) close(memory);
+    if (mapped == MAP_FAILED) {
+        sendReply(connection, replyTo(request, RoomStatus::BadRequest));
+        return;
+    }
+    sendReply(connection, replyTo(request, RoomStatus::Ok));
+    connection.rings = static_cast<SharedRings*>(mapped);
+}
+
+/**
+ * @brief Обрабатывает все запросы из кольца; пока ответы ждут места в кольце ответов, запросы не читаются
+ */
+void RoomServer::drainRing(Connection& connection) {
+    if (!connection.rings) return;
+    SharedRing<RoomReply>& replies = connection.rings->replies;
+    size_t moved = replies.push(connection.backlog.data(), connection.backlog.size());
+    connection.backlog.erase(connection.backlog.begin(), connection.backlog.begin() + moved);
+    if (moved > 0) connection.ring_dirty = true;
+
+    RoomRequest frames[256];
+    while (connection.backlog.empty()) {
+        size_t count = connection.rings->requests.pop(frames, 256);
+        if (count == 0) break;
+        for (size_t i = 0; i < count; ++i) {
+            RoomOp op = static_cast<RoomOp>(frames[i].op);
+            if (op == RoomOp::Doorbell || op == RoomOp::AttachRing) sendReply(connection, replyTo(frames[i], RoomStatus::BadRequest));
+            else handleRequest(connection, frames[i]);
+        }
+        served += static_cast<long long>(count);
+    }
+}
+
+void RoomServer::sendReply(Connection& connection, const RoomReply& reply) {
+    if (!connection.rings) {
+        connection.out.append(reinterpret_cast<const char*>(&reply), sizeof(reply));
+        return;
+    }
+    if (connection.backlog.empty() && connection.rings->replies.push(&reply, 1) == 1) connection.ring_dirty = true;
+    else connection.backlog.push_back(reply);
+}
+
+/**
+ * @brief Отправляет накопленные ответы (и Doorbell для колец) и обновляет подписку epoll
+ *
+ * @return false, если соединение закрыто
+ */
+bool RoomServer::flushClient(Connection& connection) {
+    if (connection.ring_dirty) {
+        RoomReply bell;
+        bell.op = static_cast<uint8_t>(RoomOp::Doorbell);
+        connection.out.append(reinterpret_cast<const char*>(&bell), sizeof(bell));
+        connection.ring_dirty = false;
+    }
+    size_t sent = 0;
+    while (sent < connection.out.size()) {
+        ssize_t written = send(connection.fd, connection.out.data() + sent, connection.out.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) break;
+        if (written <= 0) {
+            closeClient(connection.fd);
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    connection.out.erase(0, sent);
+
+    uint32_t events = (connection.out.size() < MAX_PENDING_OUT ? EPOLLIN : 0u) | (connection.out.empty() ? 0u : EPOLLOUT);
+    if (events != connection.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = connection.fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = events;
+    }
+    return true;
+}
+
+/**
+ * @brief Закрывает соединение и выводит студентов, вошедших через него
+ */
+void RoomServer::closeClient(int fd) {
+    Connection& connection = *clients[fd];
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    for (int student : connection.held) {
+        visiting[student] = false;
+        if (student < total_ks40) room.leaveStudent(1, student);
+        else room.leaveStudent(2, student - total_ks40);
+    }
+    if (connection.passed_fd >= 0) close(connection.passed_fd);
+    if (connection.rings) munmap(connection.rings, sizeof(SharedRings));
+    clients[fd].reset();
+    open_connections--;
+}
+
+/**
+ * @brief Передает ответы Visit из пула их соединениям (если соединение еще открыто)
+ */
+void RoomServer::deliverCompletions() {
+    std::vector<Completion> done;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mtx);
+        done.swap(completions);
+    }
+    auto open = [this](const Completion& completion) {
+        return static_cast<size_t>(completion.fd) < clients.size() && clients[completion.fd]
+            && clients[completion.fd]->serial == completion.serial;
+    };
+    for (const Completion& completion : done) {
+        visiting[completion.student] = false;
+        if (open(completion)) sendReply(*clients[completion.fd], completion.reply);
+    }
+    for (const Completion& completion : done) {
+        if (open(completion)) flushClient(*clients[completion.fd]);
+    }
+}
+
+void RoomServer::visitWorker() {
+    while (true) {
+        VisitJob job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mtx);
+            jobs_cv.wait(lock, [this]() { return jobs_closed || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        AttemptOutcome outcome = room.visitOnce(job.request.group, job.request.student_id);
+        Completion completion{ job.fd, job.serial, studentIndex(job.request.group, job.request.student_id),
+                               replyTo(job.request, statusOf(outcome)) };
+        {
+            std::lock_guard<std::mutex> lock(jobs_mtx);
+            completions.push_back(completion);
+        }
+        uint64_t one = 1;
+        (void)!write(wake_fd, &one, sizeof(one));
+    }
+}
+
+RoomClient::~RoomClient() {
+    close();
+}
+
+int RoomClient::fd() const {
+    return socket_fd;
+}
+
+bool RoomClient::ringAttached() const {
+    return rings != nullptr;
+}
+
+bool RoomClient::connect(const std::string& path) {
+    close();
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    socket_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socket_fd < 0) return false;
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (::connect(socket_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void RoomClient::close() {
+    if (rings) munmap(rings, sizeof(SharedRings));
+    rings = nullptr;
+    if (socket_fd >= 0) ::close(socket_fd);
+    socket_fd = -1;
+    pending.clear();
+}
+
+bool RoomClient::sendFrames(const void* data, size_t bytes) {
+    const char* at = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t written = ::send(socket_fd, at, bytes, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        at += written;
+        bytes -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool RoomClient::send(const RoomRequest* requests, size_t count) {
+    if (socket_fd < 0) return false;
+    if (!rings) return sendFrames(requests, count * sizeof(RoomRequest));
+
+    RoomRequest bell;
+    bell.op = static_cast<uint8_t>(RoomOp::Doorbell);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    size_t done = 0;
+    while (true) {
+        done += rings->requests.push(requests + done, count - done);
+        if (!sendFrames(&bell, sizeof(bell))) return false;
+        if (done == count) return true;
+        // Кольцо запросов заполнено: сервер освободит его, обработав кадры по звонку
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+}
+
+size_t RoomClient::receive(RoomReply* replies, size_t count, int timeout_ms) {
+    if (socket_fd < 0) return 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    RoomRequest bell;
+    bell.op = static_cast<uint8_t>(RoomOp::Doorbell);
+    size_t got = 0;
+    while (true) {
+        if (rings) {
+            // Из заполненного кольца сервер дальше не пишет: освободив место, нужно позвонить
+            bool was_full = rings->replies.size() == SharedRing<RoomReply>::SLOTS;
+            got += rings->replies.pop(replies + got, count - got);
+            if (was_full && !sendFrames(&bell, sizeof(bell))) return got;
+        }
+        else {
+            size_t take = std::min(pending.size() / sizeof(RoomReply), count - got);
+            std::memcpy(replies + got, pending.data(), take * sizeof(RoomReply));
+            pending.erase(pending.begin(), pending.begin() + take * sizeof(RoomReply));
+            got += take;
+        }
+        if (got == count) return got;
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        pollfd peer{ socket_fd, POLLIN, 0 };
+        if (poll(&peer, 1, static_cast<int>(std::max<long long>(0, left))) <= 0) return got;
+        char buffer[4096];
+        ssize_t received = recv(socket_fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) return got;
+        // После подключения колец сокет несет только кадры Doorbell
+        if (!rings) pending.insert(pending.end(), buffer, buffer + received);
+    }
+}
+
+bool RoomClient::attachRing() {
+    if (socket_fd < 0 || rings) return false;
+    int memory = memfd_create("computer_room_rings", MFD_CLOEXEC);
+    if (memory < 0) return false;
+    void* mapped = MAP_FAILED;
+    if (ftruncate(memory, sizeof(SharedRings)) == 0) {
+        mapped = mmap(nullptr, sizeof(SharedRings), PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0);
+    }
+    if (mapped == MAP_FAILED) {
+        ::close(memory);
+        return false;
+    }
+
+    // Дескриптор памяти передается вместе с кадром AttachRing
+    RoomRequest request;
+    request.op = static_cast<uint8_t>(RoomOp::AttachRing);
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    iovec io{ &request, sizeof(request) };
+    msghdr message{};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &memory, sizeof(int));
+    bool sent = sendmsg(socket_fd, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(request));
+    ::close(memory);
+
+    RoomReply reply;
+    if (!sent || receive(&reply, 1, 1000) != 1 || reply.op != request.op || reply.status != static_cast<uint8_t>(RoomStatus::Ok)) {
+        munmap(mapped, sizeof(SharedRings));
+        return false;
+    }
+    rings = static_cast<SharedRings*>(mapped);
+    return true;
+}
+
+void ServerBench::run(const std::string& path, const BenchOptions& options, BenchResult& result) {
+    using Clock = std::chrono::steady_clock;
+    const int depth = std::max(1, std::min(options.depth, 256));
+
+    std::vector<std::unique_ptr<RoomClient>> clients;
+    for (int i = 0; i < options.connections; ++i) {
+        std::unique_ptr<RoomClient> client(new RoomClient());
+        if (!client->connect(path)) break;
+        if (options.ring && !client->attachRing()) break;
+        clients.push_back(std::move(client));
+    }
+    result.connected = static_cast<int>(clients.size());
+    if (clients.empty()) return;
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) return;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, clients[i]->fd(), &event);
+    }
+
+    // У каждого соединения depth ячеек: ячейка - тег запроса, хранит время отправки
+    std::vector<Clock::time_point> sent_at(clients.size() * depth);
+    std::vector<RoomRequest> batch(depth);
+    long long outstanding = 0;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::milliseconds(options.duration_ms);
+    // Ячейка соединения всегда работает с одним студентом: Leave после входа выводит того, кто вошел
+    const int students = std::max(1, options.students);
+    auto studentOf = [&](size_t i, int slot) {
+        return static_cast<uint16_t>((i / 2 * depth + slot) % students);
+    };
+    for (size_t i = 0; i < clients.size(); ++i) {
+        for (int slot = 0; slot < depth; ++slot) {
+            batch[slot] = RoomRequest();
+            batch[slot].tag = static_cast<uint32_t>(slot);
+            batch[slot].op = static_cast<uint8_t>(options.op);
+            batch[slot].group = static_cast<uint8_t>(1 + i % 2);
+            batch[slot].student_id = studentOf(i, slot);
+            sent_at[i * depth + slot] = Clock::now();
+        }
+        if (clients[i]->send(batch.data(), depth)) outstanding += depth;
+    }
+
+    epoll_event events[256];
+    std::vector<RoomReply> replies(depth);
+    Clock::time_point last_reply = start;
+    while (outstanding > 0) {
+        Clock::time_point now = Clock::now();
+        if (now > end + std::chrono::milliseconds(options.drain_ms)) break; // Ответы, не пришедшие за drain_ms после конца, не ждем
+        int ready = epoll_wait(epoll_fd, events, 256, 10);
+        for (int e = 0; e < ready; ++e) {
+            size_t i = events[e].data.u32;
+            size_t got = clients[i]->receive(replies.data(), depth, 0);
+            now = Clock::now();
+            size_t next = 0;
+            for (size_t r = 0; r < got; ++r) {
+                const RoomReply& reply = replies[r];
+                int slot = static_cast<int>(reply.tag % depth);
+                uint64_t latency = static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - sent_at[i * depth + slot]).count());
+                result.latency_us.record(latency);
+                result.requests++;
+                if (reply.status < 9) result.by_status[reply.status]++;
+                if (reply.op == static_cast<uint8_t>(RoomOp::Visit) && reply.status != static_cast<uint8_t>(RoomStatus::Busy)) {
+                    result.attempt_us.record(latency);
+                }
+                outstanding--;
+                if (now >= end) continue;
+
+                // Вошедший студент сразу выходит следующим запросом той же ячейки
+                RoomOp op = options.op;
+                if (reply.op == static_cast<uint8_t>(RoomOp::TryEnter) && reply.status == static_cast<uint8_t>(RoomStatus::Ok)) op = RoomOp::Leave;
+                batch[next] = RoomRequest();
+                batch[next].tag = static_cast<uint32_t>(slot);
+                batch[next].op = static_cast<uint8_t>(op);
+                batch[next].group = static_cast<uint8_t>(1 + i % 2);
+                batch[next].student_id = studentOf(i, slot);
+                sent_at[i * depth + slot] = now;
+                next++;
+            }
+            if (got > 0) last_reply = now;
+            if (next > 0 && clients[i]->send(batch.data(), next)) outstanding += static_cast<long long>(next);
+        }
+    }
+    close(epoll_fd);
+    result.unanswered = outstanding;
+
+    result.elapsed_s = std::chrono::duration<double>(std::max(last_reply, start) - start).count();
+    if (result.elapsed_s > 0) result.requests_per_s = result.requests / result.elapsed_s;
+}
+
+#else
+
+bool RoomServer::start(const std::string&) { return false; }
+void RoomServer::stop() {}
+void RoomServer::eventLoop() {}
+void RoomServer::acceptClients() {}
+bool RoomServer::readClient(Connection&) { return false; }
+void RoomServer::handleFrames(Connection&, const RoomRequest*, size_t) {}
+void RoomServer::handleRequest(Connection&, const RoomRequest&) {}
+void RoomServer::attachRing(Connection&, const RoomRequest&) {}
+void RoomServer::drainRing(Connection&) {}
+void RoomServer::sendReply(Connection&, const RoomReply&) {}
+bool RoomServer::flushClient(Connection&) { return false; }
+void RoomServer::closeClient(int) {}
+void RoomServer::deliverCompletions() {}
+void RoomServer::visitWorker() {}
+
+RoomClient::~RoomClient() {}
+int RoomClient::fd() const { return socket_fd; }
+bool RoomClient::ringAttached() const { return false; }
+bool RoomClient::connect(const std::string&) { return false; }
+void RoomClient::close() {}
+bool RoomClient::sendFrames(const void*, size_t) { return false; }
+bool RoomClient::send(const RoomRequest*, size_t) { return false; }
+size_t RoomClient::receive(RoomReply*, size_t, int) { return 0; }
+bool RoomClient::attachRing() { return false; }
+
+void ServerBench::run(const std::string&, const BenchOptions&, BenchResult&) {}
+
+#endif
@@ -0,0 +1,150 @@
+#include "../include/roomSimulator.h"
+#include <numeric>
+
+RoomSimulator::RoomSimulator(const RoomConfig& config)
+    : config(config) {
+    tick_ms = std::gcd(std::gcd(config.session_ms, config.retry_delay_ms), std::gcd(config.min_wait_ms, config.max_wait_ms));
+    if (tick_ms <= 0) tick_ms = 1;
+    session_ticks = config.session_ms / tick_ms;
+    min_wait_ticks = config.min_wait_ms / tick_ms;
+    max_wait_ticks = config.max_wait_ms / tick_ms;
+    retry_ticks = config.retry_delay_ms / tick_ms;
+
+    int total = config.total_ks40 + config.total_ks44;
+    phase.resize(total);
+    group_of.resize(total);
+    timer.resize(total);
+    visits.resize(total);
+    rng.resize(total);
+    for (int i = 0; i < total; ++i) group_of[i] = (i < config.total_ks40) ? 1 : 2;
+}
+
+int RoomSimulator::tickMs() const {
+    return tick_ms;
+}
+
+uint64_t RoomSimulator::nextRandom(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Перемешивает зерно и номер студента (splitmix64), чтобы генераторы студентов были независимы
+ */
+uint64_t RoomSimulator::seedStudent(uint64_t seed, int student) {
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(student + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * @brief Начинает занятие группы: выгоняет студентов другой группы и засчитывает посещения присутствующим
+ */
+void RoomSimulator::startSession(int group, int now, int& session_group, int& session_end, int present[3], int& occupancy, int& lagging) {
+    session_group = group;
+    session_end = now + session_ticks;
+    int total = static_cast<int>(phase.size());
+    for (int i = 0; i < total; ++i) {
+        if (phase[i] != IN_ROOM) continue;
+        if (group_of[i] != group) {
+            phase[i] = BACKOFF;
+            timer[i] = now + retry_ticks;
+            present[group_of[i]]--;
+            occupancy--;
+        }
+        else {
+            phase[i] = ATTENDING;
+            if (++visits[i] == REQUIRED_VISITS) lagging--;
+        }
+    }
+}
+
+SimResult RoomSimulator::run(uint64_t seed, int cutoff_ms) {
+    const int total = static_cast<int>(phase.size());
+    const int need[3] = { 0, config.need_ks40, config.need_ks44 };
+    const int wait_range = max_wait_ticks - min_wait_ticks + 1;
+    const int cutoff_ticks = cutoff_ms / tick_ms;
+
+    for (int i = 0; i < total; ++i) {
+        phase[i] = READY;
+        timer[i] = 0;
+        visits[i] = 0;
+        rng[i] = seedStudent(seed, i);
+    }
+
+    SimResult result;
+    int occupancy = 0;
+    int present[3] = { 0, 0, 0 };
+    int session_group = 0;
+    int session_end = 0;
+    int lagging = total;
+
+    for (int now = 0; now <= cutoff_ticks; ++now) {
+        // Преподаватель завершает занятие: все оставшиеся выходят и уходят на паузу
+        if (session_group != 0 && now >= session_end) {
+            for (int i = 0; i < total; ++i) {
+                if (phase[i] == IN_ROOM || phase[i] == ATTENDING) {
+                    phase[i] = BACKOFF;
+                    timer[i] = now + retry_ticks;
+                }
+            }
+            occupancy = 0;
+            present[1] = present[2] = 0;
+            session_group = 0;
+        }
+
+        // Порядок обхода студентов сдвигается каждый такт, чтобы никто не имел постоянного преимущества
+        int start = now % total;
+        for (int k = 0; k < total; ++k) {
+            int i = (start + k) % total;
+            int group = group_of[i];
+
+            if (phase[i] == BACKOFF) {
+                if (now < timer[i]) continue;
+                phase[i] = READY;
+            }
+            if (phase[i] == READY) {
+                // Студент решает прийти и ждет начала занятия не дольше S
+                int wait = min_wait_ticks + static_cast<int>((nextRandom(rng[i]) >> 32) % static_cast<uint64_t>(wait_range));
+                timer[i] = now + wait;
+                phase[i] = BLOCKED;
+            }
+            if (phase[i] == BLOCKED) {
+                if (occupancy >= config.capacity || (session_group != 0 && session_group != group)) continue;
+                occupancy++;
+                present[group]++;
+                if (session_group == group) {
+                    phase[i] = ATTENDING;
+                    if (++visits[i] == REQUIRED_VISITS) lagging--;
+                    continue;
+                }
+                phase[i] = IN_ROOM;
+                if (session_group == 0 && present[group] >= need[group]) {
+                    startSession(group, now, session_group, session_end, present, occupancy, lagging);
+                    result.sessions++;
+                    continue;
+                }
+            }
+            if (phase[i] == IN_ROOM && now >= timer[i]) {
+                // Не дождался начала занятия и вышел
+                phase[i] = BACKOFF;
+                timer[i] = now + retry_ticks;
+                occupancy--;
+                present[group]--;
+            }
+        }
+
+        if (lagging == 0) {
+            result.completed = true;
+            result.completion_ms = now * tick_ms;
+            return result;
+        }
+    }
+
+    result.completion_ms = cutoff_ms;
+    return result;
+}
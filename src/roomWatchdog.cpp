@@ -0,0 +1,142 @@
+#include "../include/roomWatchdog.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+RoomWatchdog::RoomWatchdog(const ComputerRoom& room, const WatchdogOptions& options)
+    : room(room), options(options) {}
+
+RoomWatchdog::~RoomWatchdog() {
+    stop();
+}
+
+void RoomWatchdog::start() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (running) return;
+    running = true;
+    worker = std::thread(&RoomWatchdog::watchLoop, this);
+}
+
+void RoomWatchdog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        running = false;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+int RoomWatchdog::stallCount() const {
+    return stalls.load();
+}
+
+std::string RoomWatchdog::lastReport() const {
+    std::lock_guard<std::mutex> lock(report_mtx);
+    return last_report;
+}
+
+const char* RoomWatchdog::waitName(StudentWaitKind kind) {
+    switch (kind) {
+    case StudentWaitKind::NotStarted: return "не запущен";
+    case StudentWaitKind::Running: return "выполняется";
+    case StudentWaitKind::WaitSeat: return "ждет места (cv)";
+    case StudentWaitKind::WaitAdmission: return "ждет впуска из очереди (admit_cv)";
+    case StudentWaitKind::WaitSessionStart: return "в классе ждет начала занятия (cv, wait_until)";
+    case StudentWaitKind::Attending: return "на занятии, ждет окончания (cv)";
+    case StudentWaitKind::Backoff: return "пауза перед следующей попыткой";
+    case StudentWaitKind::Finished: return "завершен";
+    }
+    return "?";
+}
+
+std::string RoomWatchdog::report(long long stalled_ms) const {
+    RoomMetrics metrics = room.metrics();
+
+    struct Blocked {
+        int group;
+        int id;
+        StudentWait wait;
+    };
+    std::vector<Blocked> blocked;
+    int by_kind[8] = {};
+    for (int group = 1; group <= 2; ++group) {
+        int total = (group == 1) ? metrics.total_ks40 : metrics.total_ks44;
+        for (int id = 0; id < total; ++id) {
+            StudentWait wait = room.studentWait(group, id);
+            by_kind[static_cast<int>(wait.kind)]++;
+            if (wait.kind != StudentWaitKind::Finished && wait.kind != StudentWaitKind::NotStarted) {
+                blocked.push_back({ group, id, wait });
+            }
+        }
+    }
+    std::sort(blocked.begin(), blocked.end(), [](const Blocked& a, const Blocked& b) {
+        return a.wait.waited_ms > b.wait.waited_ms;
+    });
+
+    std::ostringstream text;
+    text << "! Нет прогресса " << stalled_ms / 1000.0 << " сек: посещений " << metrics.visits_credited
+         << ", занятий " << metrics.sessions_started << "\n";
+    text << "\tВ классе: " << metrics.occupancy << ", группа: "
+         << (metrics.current_group == 1 ? "КС-40" : metrics.current_group == 2 ? "КС-44" : "нет")
+         << ", занятие " << (metrics.in_session ? "идет" : "не идет")
+         << ", ждут места: " << metrics.seat_waiters << "\n";
+    text << "\tЗавершили: КС-40 " << metrics.completed_ks40 << "/" << metrics.total_ks40
+         << ", КС-44 " << metrics.completed_ks44 << "/" << metrics.total_ks44 << "\n";
+    text << "\tСтуденты по ожиданиям:\n";
+    for (int kind = 0; kind < 8; ++kind) {
+        if (by_kind[kind] > 0) text << "\t\t" << waitName(static_cast<StudentWaitKind>(kind)) << ": " << by_kind[kind] << "\n";
+    }
+    text << "\tДольше всех ждут:\n";
+    int listed = std::min(static_cast<int>(blocked.size()), options.report_limit);
+    for (int i = 0; i < listed; ++i) {
+        text << "\t\t" << (blocked[i].group == 1 ? "КС-40" : "КС-44") << " студент " << blocked[i].id << ": "
+             << waitName(blocked[i].wait.kind) << ", " << blocked[i].wait.waited_ms / 1000.0 << " сек\n";
+    }
+    return text.str();
+}
+
+void RoomWatchdog::watchLoop() {
+    auto last_progress = std::chrono::steady_clock::now();
+    RoomMetrics metrics = room.metrics();
+    long long last_visits = metrics.visits_credited;
+    int last_sessions = metrics.sessions_started;
+    bool reported = false;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    while (running) {
+        cv.wait_for(lock, std::chrono::milliseconds(options.poll_ms));
+        if (!running) break;
+
+        auto now = std::chrono::steady_clock::now();
+        metrics = room.metrics();
+        if (metrics.visits_credited != last_visits || metrics.sessions_started != last_sessions) {
+            last_visits = metrics.visits_credited;
+            last_sessions = metrics.sessions_started;
+            last_progress = now;
+            reported = false;
+            continue;
+        }
+
+        long long stalled_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_progress).count();
+        if (reported || stalled_ms < options.stall_ms) continue;
+        reported = true;
+
+        // Отчет формируется без мьютекса сторожа, чтобы stop() не ждал печати
+        lock.unlock();
+        std::string text = report(stalled_ms);
+        if (options.report_stream) *options.report_stream << text << std::flush;
+        if (options.tracer && !options.trace_path.empty()) {
+            if (options.tracer->writeChromeTrace(options.trace_path) && options.report_stream) {
+                *options.report_stream << "\tВременная шкала записана в " << options.trace_path << "\n" << std::flush;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> report_lock(report_mtx);
+            last_report = text;
+        }
+        stalls++;
+        if (options.on_stall) options.on_stall(text);
+        lock.lock();
+    }
+}
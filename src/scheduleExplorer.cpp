@@ -0,0 +1,660 @@
+#include "../include/scheduleExplorer.h"
+#include "../include/roomSimulator.h"
+#include <algorithm>
+#include <thread>
+
+std::atomic<ScheduleExplorer*> ScheduleExplorer::active{nullptr};
+thread_local int ScheduleExplorer::self_index = -1;
+
+// ---------------------------------------------------------------------------
+// Примитивы roomSync.h: под активным стендом операции текущего потока проходят через планировщик,
+// после конца расписания и вне стенда - через обычные std::mutex и std::condition_variable
+// ---------------------------------------------------------------------------
+
+ScheduledClock::time_point ScheduledClock::now() {
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    return explorer ? explorer->now() : std::chrono::steady_clock::now();
+}
+
+void ScheduledMutex::lock() {
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    if (explorer && explorer->controls()) explorer->acquire(*this);
+    native.lock();
+}
+
+void ScheduledMutex::unlock() {
+    native.unlock();
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    if (explorer && explorer->controls()) explorer->release(*this);
+}
+
+bool ScheduledMutex::try_lock() {
+    // Класс не пробует захватить мьютекс без ожидания, поэтому try_lock не точка переключения
+    return native.try_lock();
+}
+
+void ScheduledCondition::notify_one() {
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    if (explorer && explorer->controls()) explorer->notify(*this, false);
+    native.notify_one();
+}
+
+void ScheduledCondition::notify_all() {
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    if (explorer && explorer->controls()) explorer->notify(*this, true);
+    native.notify_all();
+}
+
+void ScheduledCondition::wait(std::unique_lock<ScheduledMutex>& lock) {
+    ScheduledMutex& mutex = *lock.mutex();
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    if (explorer && explorer->controls()) {
+        mutex.native.unlock();
+        explorer->wait(*this, mutex, false, ScheduledClock::time_point());
+        mutex.native.lock();
+        return;
+    }
+    std::unique_lock<std::mutex> inner(mutex.native, std::adopt_lock);
+    native.wait(inner);
+    inner.release();
+}
+
+std::cv_status ScheduledCondition::wait_until(std::unique_lock<ScheduledMutex>& lock, ScheduledClock::time_point deadline) {
+    ScheduledMutex& mutex = *lock.mutex();
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    if (explorer && explorer->controls()) {
+        mutex.native.unlock();
+        bool timed_out = explorer->wait(*this, mutex, true, deadline);
+        mutex.native.lock();
+        return timed_out ? std::cv_status::timeout : std::cv_status::no_timeout;
+    }
+    std::unique_lock<std::mutex> inner(mutex.native, std::adopt_lock);
+    std::cv_status status = native.wait_until(inner, deadline);
+    inner.release();
+    return status;
+}
+
+void roomSchedulePoint() {
+    ScheduleExplorer* explorer = ScheduleExplorer::active.load();
+    if (explorer && explorer->controls()) explorer->schedulePoint();
+}
+
+// ---------------------------------------------------------------------------
+// Планировщик
+// ---------------------------------------------------------------------------
+
+ScheduleExplorer::ScheduleExplorer(const RoomConfig& config, const ScheduleOptions& options)
+    : config(config),
+      options(options),
+      total(config.total_ks40 + config.total_ks44),
+      teacher(config.total_ks40 + config.total_ks44),
+      clock(config.total_ks40 + config.total_ks44 + 1),
+      threads(config.total_ks40 + config.total_ks44 + 1),
+      clock_base(std::chrono::steady_clock::now()) {
+    this->config.verbose = false;
+    this->config.max_wait_ms = config.min_wait_ms;
+    enabled.reserve(total + 2);
+}
+
+ScheduleExplorer::~ScheduleExplorer() = default;
+
+int ScheduleExplorer::clockChoice() const {
+    return clock;
+}
+
+bool ScheduleExplorer::controls() const {
+    return !free_run.load();
+}
+
+ScheduledClock::time_point ScheduleExplorer::now() const {
+    return clock_base + std::chrono::nanoseconds(clock_offset_ns.load());
+}
+
+/**
+ * @brief Отдает управление: выбирает следующий шаг и ждет, пока планировщик снова выберет этот поток
+ */
+void ScheduleExplorer::yieldLocked(std::unique_lock<std::mutex>& guard, int self) {
+    int next = decideLocked();
+    grantLocked(next);
+    if (next != self) waitTurnLocked(guard, self);
+}
+
+void ScheduleExplorer::waitTurnLocked(std::unique_lock<std::mutex>& guard, int self) {
+    while (granted != self && !free_run.load()) threads[self].turn.wait(guard);
+}
+
+/**
+ * @brief Передает управление потоку next; -1 - расписание закончено
+ */
+void ScheduleExplorer::grantLocked(int next) {
+    granted = next;
+    if (next < 0) {
+        done = true;
+        run_cv.notify_all();
+        return;
+    }
+    ThreadSlot& thread = threads[next];
+    if (thread.state == ThreadState::Lock) {
+        thread.mutex->owner = next;
+        thread.state = ThreadState::Ready;
+    }
+    thread.turn.notify_one();
+}
+
+/**
+ * @brief Потоки, которые могут сделать шаг, в порядке индексов; часы - если кто-то ждет срока
+ */
+void ScheduleExplorer::collectEnabledLocked() {
+    enabled.clear();
+    bool timed = false;
+    for (int i = 0; i <= teacher; ++i) {
+        const ThreadSlot& thread = threads[i];
+        switch (thread.state) {
+        case ThreadState::Ready:
+            enabled.push_back(i);
+            break;
+        case ThreadState::Lock:
+            if (thread.mutex->owner < 0) enabled.push_back(i);
+            break;
+        case ThreadState::Wait:
+            timed = timed || thread.timed;
+            break;
+        case ThreadState::Finished:
+            break;
+        }
+    }
+    if (timed) enabled.push_back(clock);
+}
+
+/**
+ * @brief Следующий шаг расписания: проверяет инварианты, выбирает поток или продвигает время
+ *
+ * @return Поток, которому передать управление, или -1, если расписание закончено
+ */
+int ScheduleExplorer::decideLocked() {
+    while (true) {
+        if (!checkInvariantsLocked()) return -1;
+
+        bool students_done = true;
+        for (int i = 0; i < total; ++i) students_done = students_done && threads[i].state == ThreadState::Finished;
+        if (students_done) {
+            result.finished = true;
+            return -1;
+        }
+
+        collectEnabledLocked();
+        if (enabled.empty()) {
+            for (int i = 0; i < total; ++i) {
+                if (threads[i].state != ThreadState::Finished) {
+                    result.violation = "ни один поток не может продолжить, студент " + std::to_string(i) + " ждет вечно";
+                    break;
+                }
+            }
+            return -1;
+        }
+        if (static_cast<int>(result.choices.size()) >= options.max_steps) return -1;
+        if (mode == Mode::Replay && result.choices.size() == replay_choices->size()) return -1;
+
+        int choice = chooseLocked();
+        if (choice < 0) return -1;
+        result.choices.push_back(choice);
+        previous = choice;
+        if (choice != clock) return choice;
+        advanceClockLocked();
+    }
+}
+
+int ScheduleExplorer::chooseLocked() {
+    if (mode == Mode::Random) return enabled[(RoomSimulator::nextRandom(rng) >> 32) % enabled.size()];
+
+    if (mode == Mode::Replay) {
+        int choice = (*replay_choices)[result.choices.size()];
+        if (std::find(enabled.begin(), enabled.end(), choice) == enabled.end()) {
+            result.violation = "поток " + std::to_string(choice) + " не может сделать шаг " + std::to_string(result.choices.size());
+            return -1;
+        }
+        return choice;
+    }
+
+    // Перебор: префикс проигрывается со стека, на новых шагах строится список вариантов
+    size_t depth = result.choices.size();
+    bool previous_enabled = std::find(enabled.begin(), enabled.end(), previous) != enabled.end();
+    if (depth == stack->size()) {
+        Frame frame;
+        // Продолжение предыдущего потока бесплатно, переключение с него - вытеснение
+        if (previous_enabled) frame.options.push_back(previous);
+        if (!previous_enabled || preemptions < preemption_bound) {
+            for (int thread : enabled) {
+                if (thread != previous) frame.options.push_back(thread);
+            }
+        }
+        stack->push_back(std::move(frame));
+    }
+    const Frame& frame = (*stack)[depth];
+    int choice = frame.options[frame.next];
+    if (previous_enabled && choice != previous) preemptions++;
+    return choice;
+}
+
+/**
+ * @brief Продвигает время до ближайшего срока; все ожидания с наступившим сроком заканчиваются таймаутом
+ */
+void ScheduleExplorer::advanceClockLocked() {
+    bool found = false;
+    ScheduledClock::time_point nearest;
+    for (int i = 0; i <= teacher; ++i) {
+        const ThreadSlot& thread = threads[i];
+        if (thread.state != ThreadState::Wait || !thread.timed) continue;
+        if (!found || thread.deadline < nearest) nearest = thread.deadline;
+        found = true;
+    }
+    if (!found) return;
+    if (nearest > now()) clock_offset_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(nearest - clock_base).count();
+    for (int i = 0; i <= teacher; ++i) {
+        ThreadSlot& thread = threads[i];
+        if (thread.state != ThreadState::Wait || !thread.timed || thread.deadline > nearest) continue;
+        thread.state = ThreadState::Lock;
+        thread.timed_out = true;
+    }
+}
+
+/**
+ * @brief Проверяет инварианты класса; состояние под мьютексом проверяется, только когда мьютекс свободен
+ */
+bool ScheduleExplorer::checkInvariantsLocked() {
+    if (!result.violation.empty()) return false;
+
+    uint64_t state = room->seat_state.load();
+    int occupancy = static_cast<int>(state & ComputerRoom::OCCUPANCY_MASK);
+    if (occupancy > room->CAPACITY) {
+        result.violation = "занято мест: " + std::to_string(occupancy) + " при вместимости " + std::to_string(room->CAPACITY);
+        return false;
+    }
+    if (room->mtx.holder() >= 0) return true;
+
+    // Вошедший без мьютекса студент учтен в счетчике присутствия раньше, чем поставил флаг, и до этого числится в ENTERING
+    int present_ks40 = room->presentCount(1);
+    int present_ks44 = room->presentCount(2);
+    int entering = static_cast<int>((state >> ComputerRoom::ENTERING_SHIFT) & ComputerRoom::ENTERING_MASK);
+    int flagged_ks40 = static_cast<int>(std::count(room->in_room_ks40.begin(), room->in_room_ks40.end(), true));
+    int flagged_ks44 = static_cast<int>(std::count(room->in_room_ks44.begin(), room->in_room_ks44.end(), true));
+    if (flagged_ks40 > present_ks40 || flagged_ks44 > present_ks44
+        || present_ks40 - flagged_ks40 + present_ks44 - flagged_ks44 > entering) {
+        result.violation = "счетчики присутствия (" + std::to_string(present_ks40) + ", " + std::to_string(present_ks44)
+            + ") не совпадают с флагами (" + std::to_string(flagged_ks40) + ", " + std::to_string(flagged_ks44) + ") при "
+            + std::to_string(entering) + " входящих без мьютекса";
+        return false;
+    }
+    if (present_ks40 + present_ks44 > occupancy) {
+        result.violation = "в классе " + std::to_string(present_ks40 + present_ks44) + " студентов при "
+            + std::to_string(occupancy) + " занятых местах";
+        return false;
+    }
+    // Подготовленная группа существует только во время занятия: занятие, завершившееся при подготовке, в той же
+    // критической секции либо начинает следующее, либо сбрасывает выбор
+    if (room->staged_group < 0 || room->staged_group > 2 || (room->staged_group != 0 && !room->PRESTAGE)
+        || (room->staged_group != 0 && !(state & ComputerRoom::SESSION_BIT))) {
+        result.violation = "подготовлена группа " + std::to_string(room->staged_group) + " "
+            + ((state & ComputerRoom::SESSION_BIT) ? "при выключенной подготовке" : "вне занятия");
+        return false;
+    }
+    int prestaged = room->prestaged_sessions.load();
+    if (prestaged > room->sessions_started.load()) {
+        result.violation = "занятий подготовленной группы " + std::to_string(prestaged) + " больше, чем начавшихся";
+        return false;
+    }
+    if (state & ComputerRoom::SESSION_BIT) {
+        int group = static_cast<int>((state & ComputerRoom::GROUP_MASK) >> ComputerRoom::GROUP_SHIFT);
+        int others = (group == 1) ? present_ks44 : present_ks40;
+        if (entering > 0) {
+            // startClassLocked отпускает мьютекс, только дождавшись флагов всех вошедших до начала занятия
+            result.violation = "во время занятия группы " + std::to_string(group) + " " + std::to_string(entering)
+                + " студентов входят без мьютекса";
+            return false;
+        }
+        if (others > 0) {
+            result.violation = "во время занятия группы " + std::to_string(group) + " в классе " + std::to_string(others)
+                + " студентов другой группы";
+            return false;
+        }
+    }
+
+    if (!checkSeatQueuesLocked()) return false;
+
+    // Каждая критическая секция заканчивается освобождением мьютекса, поэтому здесь видно каждое засчитанное посещение
+    int session = room->sessions_started.load();
+    for (int i = 0; i < total; ++i) {
+        int visits = (i < config.total_ks40) ? room->visits_ks40[i] : room->visits_ks44[i - config.total_ks40];
+        if (visits == visits_seen[i]) continue;
+        if (visits != visits_seen[i] + 1 || credited_session[i] == session) {
+            result.violation = "студенту " + std::to_string(i) + " посещение засчитано дважды за занятие " + std::to_string(session);
+            return false;
+        }
+        visits_seen[i] = visits;
+        credited_session[i] = session;
+    }
+    return true;
+}
+
+void ScheduleExplorer::schedulePoint() {
+    std::unique_lock<std::mutex> guard(schedule_mtx);
+    int self = self_index;
+    if (free_run.load() || self < 0) return;
+    threads[self].state = ThreadState::Ready;
+    yieldLocked(guard, self);
+}
+
+void ScheduleExplorer::acquire(ScheduledMutex& mutex) {
+    std::unique_lock<std::mutex> guard(schedule_mtx);
+    if (free_run.load()) return;
+    int self = self_index;
+    if (self < 0) {
+        // Поток преподавателя запускается конструктором класса и подключается при первом захвате мьютекса
+        if (threads[teacher].mutex != nullptr) return;
+        self_index = self = teacher;
+        threads[teacher].state = ThreadState::Lock;
+        threads[teacher].mutex = &mutex;
+        attached++;
+        run_cv.notify_all();
+        waitTurnLocked(guard, self);
+        return;
+    }
+    threads[self].state = ThreadState::Lock;
+    threads[self].mutex = &mutex;
+    yieldLocked(guard, self);
+}
+
+void ScheduleExplorer::release(ScheduledMutex& mutex) {
+    std::unique_lock<std::mutex> guard(schedule_mtx);
+    int self = self_index;
+    if (free_run.load() || self < 0) return;
+    mutex.owner = -1;
+    threads[self].state = ThreadState::Ready;
+    yieldLocked(guard, self);
+}
+
+/**
+ * @brief Ожидание на условной переменной: мьютекс уже отпущен, поток ждет уведомления или срока, затем мьютекса
+ *
+ * @return true, если ожидание закончилось по сроку
+ */
+bool ScheduleExplorer::wait(ScheduledCondition& condition, ScheduledMutex& mutex, bool timed, ScheduledClock::time_point deadline) {
+    std::unique_lock<std::mutex> guard(schedule_mtx);
+    int self = self_index;
+    if (free_run.load() || self < 0) return false;
+    if (!checkAttendingLocked(condition, self)) {
+        // Поток остается ждать, расписание заканчивается на нарушении
+        grantLocked(-1);
+        waitTurnLocked(guard, self);
+        return false;
+    }
+    ThreadSlot& thread = threads[self];
+    mutex.owner = -1;
+    thread.mutex = &mutex;
+    thread.condition = &condition;
+    thread.timed = timed;
+    thread.deadline = deadline;
+    thread.timed_out = timed && deadline <= now();
+    thread.state = thread.timed_out ? ThreadState::Lock : ThreadState::Wait;
+    yieldLocked(guard, self);
+    if (thread.timed_out && !free_run.load() && self < total) {
+        // Срок ожидания впуска истек, но класс впустил студента раньше, чем тот снова получил мьютекс
+        bool ks40 = self < config.total_ks40;
+        int id = ks40 ? self : self - config.total_ks40;
+        if (&condition == &(ks40 ? room->admit_cv_ks40 : room->admit_cv_ks44)[id] && (ks40 ? room->admitted_ks40 : room->admitted_ks44)[id] > 0) {
+            result.raced_timeouts++;
+        }
+    }
+    return thread.timed_out;
+}
+
+/**
+ * @brief Проверяет очереди ожидания места, вызывается, когда мьютекс класса свободен
+ *
+ * Счетчики seat_queue_* не превышают WAIT_LIST_LIMIT и совпадают с числом студентов группы, ждущих места;
+ * seat_waiters - студенты в очередях впуска и на условной переменной класса. Ушедший по WAIT_TIMEOUT_MS
+ * студент сам выходит из очереди, а впущенный - уже вынут классом, поэтому в очереди только ждущие впуска
+ * студенты своей группы, без повторов, не в классе и без неполученных решений о впуске.
+ */
+bool ScheduleExplorer::checkSeatQueuesLocked() {
+    int waiting_seat = 0;
+    for (int group = 1; group <= 2; ++group) {
+        bool ks40 = group == 1;
+        int size = ks40 ? config.total_ks40 : config.total_ks44;
+        int first = ks40 ? 0 : config.total_ks40;
+        int queue = ks40 ? room->seat_queue_ks40 : room->seat_queue_ks44;
+        const std::vector<std::atomic<uint64_t>>& wait_state = ks40 ? room->wait_state_ks40 : room->wait_state_ks44;
+        const std::vector<int>& admitted = ks40 ? room->admitted_ks40 : room->admitted_ks44;
+        const std::vector<std::atomic<bool>>& in_room = ks40 ? room->in_room_ks40 : room->in_room_ks44;
+
+        int queued = 0;
+        for (int id = 0; id < size; ++id) {
+            StudentWaitKind kind = static_cast<StudentWaitKind>(wait_state[id].load() & 0xFF);
+            if (kind == StudentWaitKind::WaitSeat) waiting_seat++;
+            if (kind == StudentWaitKind::WaitSeat || kind == StudentWaitKind::WaitAdmission) queued++;
+        }
+        if (queue < 0 || (room->WAIT_LIST_LIMIT > 0 && queue > room->WAIT_LIST_LIMIT) || queue != queued) {
+            result.violation = "ожидающих места группы " + std::to_string(group) + " учтено " + std::to_string(queue)
+                + ", ждут " + std::to_string(queued) + " при ограничении " + std::to_string(room->WAIT_LIST_LIMIT);
+            return false;
+        }
+
+        const ComputerRoom::WaitList& list = ks40 ? room->wait_list_ks40 : room->wait_list_ks44;
+        int capacity = static_cast<int>(list.ids.size());
+        std::vector<bool> listed(size, false);
+        for (int i = 0; i < list.size; ++i) {
+            int id = list.ids[(list.head + i) % capacity];
+            long long ticket = list.tickets[(list.head + i) % capacity];
+            std::string where = "в очереди группы " + std::to_string(group) + " студент " + std::to_string(id);
+            if (id < 0 || id >= size || listed[id]) {
+                result.violation = where + " чужой или записан дважды";
+                return false;
+            }
+            listed[id] = true;
+            if (static_cast<StudentWaitKind>(wait_state[id].load() & 0xFF) != StudentWaitKind::WaitAdmission
+                || admitted[id] > 0 || in_room[id]) {
+                result.violation = where + " (поток " + std::to_string(first + id) + ") уже не ждет впуска";
+                return false;
+            }
+            if (i > 0 && ticket <= list.tickets[(list.head + i - 1) % capacity]) {
+                result.violation = where + " нарушает порядок постановки";
+                return false;
+            }
+        }
+    }
+
+    int listed = room->wait_list_ks40.size + room->wait_list_ks44.size;
+    if (room->seat_waiters.load() != listed + waiting_seat) {
+        result.violation = "seat_waiters = " + std::to_string(room->seat_waiters.load()) + ", в очередях впуска "
+            + std::to_string(listed) + ", на условной переменной " + std::to_string(waiting_seat);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Студент, ждущий конца занятия, должен быть в классе: при подготовке следующее занятие его группы начинается
+ * в той же критической секции, в которой закончилось текущее, и выведенный студент не должен просидеть и его
+ */
+bool ScheduleExplorer::checkAttendingLocked(const ScheduledCondition& condition, int self) {
+    if (!room->PRESTAGE || self >= total || &condition != &room->cv) return true;
+    bool ks40 = self < config.total_ks40;
+    int id = ks40 ? self : self - config.total_ks40;
+    uint64_t wait_state = (ks40 ? room->wait_state_ks40[id] : room->wait_state_ks44[id]).load();
+    if (static_cast<StudentWaitKind>(wait_state & 0xFF) != StudentWaitKind::Attending) return true;
+    if (ks40 ? room->in_room_ks40[id] : room->in_room_ks44[id]) return true;
+    result.violation = "студент " + std::to_string(self) + " ждет конца занятия " + std::to_string(room->sessions_started.load())
+        + " вне класса";
+    return false;
+}
+
+/**
+ * @brief Будит ожидающих: notify_one - поток с меньшим индексом, notify_all - всех
+ */
+void ScheduleExplorer::notify(ScheduledCondition& condition, bool all) {
+    std::lock_guard<std::mutex> guard(schedule_mtx);
+    if (free_run.load()) return;
+    if (++notifications == options.lose_notification) return;
+    for (int i = 0; i <= teacher; ++i) {
+        ThreadSlot& thread = threads[i];
+        if (thread.state != ThreadState::Wait || thread.condition != &condition) continue;
+        thread.state = ThreadState::Lock;
+        thread.timed_out = false;
+        if (!all) break;
+    }
+}
+
+void ScheduleExplorer::studentThread(int index) {
+    {
+        std::unique_lock<std::mutex> guard(schedule_mtx);
+        self_index = index;
+        attached++;
+        run_cv.notify_all();
+        waitTurnLocked(guard, index);
+    }
+
+    int group = (index < config.total_ks40) ? 1 : 2;
+    int student_id = (group == 1) ? index : index - config.total_ks40;
+    int attended = 0;
+    for (int attempt = 0; attempt < options.max_attempts && attended < 2; ++attempt) {
+        AttemptOutcome outcome = room->visitOnce(group, student_id);
+        if (outcome == AttemptOutcome::Stopped) break;
+        if (outcome == AttemptOutcome::Attended) attended++;
+    }
+
+    std::unique_lock<std::mutex> guard(schedule_mtx);
+    threads[index].state = ThreadState::Finished;
+    if (!free_run.load() && granted == index) grantLocked(decideLocked());
+    self_index = -1;
+}
+
+/**
+ * @brief Одно расписание: класс и потоки создаются заново, выборы делает chooseLocked в текущем режиме
+ *
+ * Когда расписание закончено, примитивы переключаются в обычный режим, класс останавливается и разрушается.
+ */
+ScheduleResult ScheduleExplorer::execute() {
+    result = ScheduleResult();
+    for (ThreadSlot& thread : threads) {
+        thread.state = ThreadState::Ready;
+        thread.mutex = nullptr;
+        thread.condition = nullptr;
+        thread.timed = false;
+        thread.timed_out = false;
+    }
+    attached = 0;
+    done = false;
+    granted = -1;
+    previous = -1;
+    notifications = 0;
+    preemptions = 0;
+    free_run = false;
+    clock_offset_ns = 0;
+    credited_session.assign(total, -1);
+    visits_seen.assign(total, 0);
+
+    active = this;
+    std::unique_ptr<ComputerRoom> owned(new ComputerRoom(config));
+    room = owned.get();
+    std::vector<std::thread> students;
+    students.reserve(total);
+    for (int i = 0; i < total; ++i) students.emplace_back(&ScheduleExplorer::studentThread, this, i);
+
+    {
+        std::unique_lock<std::mutex> guard(schedule_mtx);
+        run_cv.wait(guard, [this] { return attached == total + 1; });
+        grantLocked(decideLocked());
+        run_cv.wait(guard, [this] { return done; });
+        free_run = true;
+        for (ThreadSlot& thread : threads) thread.turn.notify_all();
+    }
+
+    result.sessions = owned->sessionsStarted();
+    result.prestaged_sessions = owned->prestaged_sessions.load();
+    result.seat_timeouts = owned->seat_timeouts.load();
+    result.seat_rejections = owned->seat_rejections.load();
+    result.lock_free_entries = owned->lock_free_entries.load();
+    result.lock_free_visits = owned->lock_free_visits.load();
+    owned->stop();
+    for (std::thread& student : students) student.join();
+    owned.reset();
+    room = nullptr;
+    active = nullptr;
+
+    result.ok = result.violation.empty();
+    result.steps = static_cast<int>(result.choices.size());
+    return result;
+}
+
+ScheduleResult ScheduleExplorer::runRandom(uint64_t seed) {
+    mode = Mode::Random;
+    rng = RoomSimulator::seedStudent(seed, 0);
+    ScheduleResult run = execute();
+    run.seed = seed;
+    return run;
+}
+
+ScheduleResult ScheduleExplorer::replay(const std::vector<int>& choices) {
+    mode = Mode::Replay;
+    replay_choices = &choices;
+    ScheduleResult run = execute();
+    replay_choices = nullptr;
+    return run;
+}
+
+ExploreStats ScheduleExplorer::exploreRandom(uint64_t first_seed, long long count) {
+    ExploreStats stats;
+    for (long long i = 0; i < count; ++i) {
+        ScheduleResult run = runRandom(first_seed + static_cast<uint64_t>(i));
+        stats.schedules++;
+        if (run.finished) stats.finished++;
+        stats.sessions += run.sessions;
+        stats.prestaged_sessions += run.prestaged_sessions;
+        stats.seat_timeouts += run.seat_timeouts;
+        stats.seat_rejections += run.seat_rejections;
+        stats.raced_timeouts += run.raced_timeouts;
+        stats.lock_free_entries += run.lock_free_entries;
+        stats.lock_free_visits += run.lock_free_visits;
+        if (!run.ok) {
+            stats.failure = run;
+            return stats;
+        }
+    }
+    return stats;
+}
+
+ExploreStats ScheduleExplorer::exploreExhaustive(int bound, long long max_schedules) {
+    std::vector<Frame> frames;
+    mode = Mode::Exhaustive;
+    stack = &frames;
+    preemption_bound = bound;
+    ExploreStats stats;
+
+    while (stats.schedules < max_schedules) {
+        ScheduleResult run = execute();
+        stats.schedules++;
+        if (run.finished) stats.finished++;
+        stats.sessions += run.sessions;
+        stats.prestaged_sessions += run.prestaged_sessions;
+        stats.seat_timeouts += run.seat_timeouts;
+        stats.seat_rejections += run.seat_rejections;
+        stats.raced_timeouts += run.raced_timeouts;
+        stats.lock_free_entries += run.lock_free_entries;
+        stats.lock_free_visits += run.lock_free_visits;
+        if (!run.ok) {
+            stats.failure = run;
+            break;
+        }
+
+        // Следующее расписание: последний шаг, у которого остались непроверенные варианты
+        frames.resize(run.choices.size());
+        while (!frames.empty() && frames.back().next + 1 >= frames.back().options.size()) frames.pop_back();
+        if (frames.empty()) {
+            stats.complete = true;
+            break;
+        }
+        frames.back().next++;
+    }
+    stack = nullptr;
+    return stats;
+}
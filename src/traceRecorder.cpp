@@ -0,0 +1,92 @@
+#include "../include/traceRecorder.h"
+#include <fstream>
+
+TraceRecorder::TraceRecorder(std::size_t max_events)
+    : origin(Clock::now()),
+      events(max_events),
+      ready(max_events) {
+}
+
+/**
+ * @brief Резервирует ячейку буфера атомарным счетчиком и заполняет ее, не блокируя других студентов
+ */
+void TraceRecorder::record(Span span, int group, int student_id, Clock::time_point begin, Clock::time_point end) {
+    std::size_t index = next_event.fetch_add(1, std::memory_order_relaxed);
+    if (index >= events.size()) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Event& event = events[index];
+    event.begin = begin;
+    event.end = end;
+    event.student_id = student_id;
+    event.group = static_cast<int8_t>(group);
+    event.span = span;
+    ready[index].store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Имя интервала на временной шкале
+ */
+static const char* spanName(TraceRecorder::Span span) {
+    switch (span) {
+    case TraceRecorder::Span::WaitSeat: return "wait_seat";
+    case TraceRecorder::Span::WaitSession: return "wait_session";
+    case TraceRecorder::Span::Attend: return "attend";
+    case TraceRecorder::Span::Evicted: return "evicted";
+    case TraceRecorder::Span::Backoff: return "backoff";
+    case TraceRecorder::Span::LockWait: return "lock_wait";
+    case TraceRecorder::Span::Session: return "session";
+    case TraceRecorder::Span::StartClassLocked: return "start_class_locked";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Записывает интервалы как события "X" (complete): процесс - группа, поток - студент
+ *
+ * Занятия и удержание мьютекса в startClassLocked выводятся в отдельном процессе "Класс".
+ */
+void TraceRecorder::writeChromeTrace(std::ostream& os) const {
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Класс\"}},\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"КС-40\"}},\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"КС-44\"}},\n";
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Занятия\"}},\n";
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"Мьютекс\"}}";
+
+    std::size_t count = eventCount();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!ready[i].load(std::memory_order_acquire)) continue;
+        const Event& event = events[i];
+        auto ts = std::chrono::duration_cast<std::chrono::microseconds>(event.begin - origin).count();
+        auto dur = std::chrono::duration_cast<std::chrono::microseconds>(event.end - event.begin).count();
+        bool room_span = event.span == Span::Session || event.span == Span::StartClassLocked;
+        int pid = room_span ? 0 : event.group;
+        int tid = room_span ? (event.span == Span::Session ? 0 : 1) : event.student_id;
+
+        os << ",\n{\"name\":\"" << spanName(event.span) << "\",\"cat\":\"" << (room_span ? "room" : "student")
+           << "\",\"ph\":\"X\",\"ts\":" << ts << ",\"dur\":" << dur << ",\"pid\":" << pid << ",\"tid\":" << tid;
+        if (room_span) {
+            os << ",\"args\":{\"group\":" << static_cast<int>(event.group) << ",\"session\":" << event.student_id << "}";
+        }
+        os << "}";
+    }
+    os << "\n]}\n";
+}
+
+bool TraceRecorder::writeChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) return false;
+    writeChromeTrace(file);
+    return static_cast<bool>(file);
+}
+
+std::size_t TraceRecorder::eventCount() const {
+    std::size_t count = next_event.load(std::memory_order_acquire);
+    return count < events.size() ? count : events.size();
+}
+
+std::size_t TraceRecorder::droppedCount() const {
+    return dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,79 @@
+#include "../include/visitIndex.h"
+#include <algorithm>
+
+VisitIndex::VisitIndex(int students, int required)
+    : required_visits(std::max(1, required)),
+      heads(required_visits + 1, -1),
+      counts(required_visits + 1, 0),
+      next_ids(students, -1),
+      prev_ids(students, -1),
+      buckets(students, 0) {
+    // Студенты связываются в корзину 0 по порядку идентификаторов
+    for (int i = 0; i < students; ++i) {
+        prev_ids[i] = i - 1;
+        next_ids[i] = (i + 1 < students) ? i + 1 : -1;
+    }
+    heads[0] = students > 0 ? 0 : -1;
+    counts[0] = students;
+}
+
+void VisitIndex::unlink(int student_id) {
+    int bucket = buckets[student_id];
+    int prev = prev_ids[student_id];
+    int next = next_ids[student_id];
+    if (prev >= 0) next_ids[prev] = next;
+    else heads[bucket] = next;
+    if (next >= 0) prev_ids[next] = prev;
+    counts[bucket]--;
+}
+
+void VisitIndex::pushFront(int bucket, int student_id) {
+    int head = heads[bucket];
+    prev_ids[student_id] = -1;
+    next_ids[student_id] = head;
+    if (head >= 0) prev_ids[head] = student_id;
+    heads[bucket] = student_id;
+    buckets[student_id] = bucket;
+    counts[bucket]++;
+}
+
+void VisitIndex::setVisits(int student_id, int visits) {
+    int bucket = std::min(std::max(visits, 0), required_visits);
+    if (buckets[student_id] == bucket) return;
+    unlink(student_id);
+    pushFront(bucket, student_id);
+}
+
+int VisitIndex::bucketOf(int student_id) const {
+    return buckets[student_id];
+}
+
+int VisitIndex::count(int visits) const {
+    if (visits < 0) return 0;
+    return counts[std::min(visits, required_visits)];
+}
+
+int VisitIndex::lagging() const {
+    return students() - counts[required_visits];
+}
+
+bool VisitIndex::allCompleted() const {
+    return counts[required_visits] == students();
+}
+
+int VisitIndex::first(int visits) const {
+    if (visits < 0) return -1;
+    return heads[std::min(visits, required_visits)];
+}
+
+int VisitIndex::next(int student_id) const {
+    return next_ids[student_id];
+}
+
+int VisitIndex::students() const {
+    return static_cast<int>(buckets.size());
+}
+
+int VisitIndex::required() const {
+    return required_visits;
+}
@@ -0,0 +1,91 @@
+﻿#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <iostream>
+#include <locale>
+#include <clocale>
+#include "../include/computerRoom.h"
+
+// Счетчик выделений памяти через глобальный operator new
+static std::atomic<long long> allocation_count{ 0 };
+
+void* operator new(std::size_t size) {
+    allocation_count++;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+class AllocationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::locale::global(std::locale("en_US.UTF-8"));
+        std::wcout.imbue(std::locale("en_US.UTF-8"));
+    }
+
+    // Ожидает, пока класс проведет нужное кол-во занятий, не выделяя память в тестовом потоке
+    static bool waitForSessions(ComputerRoom& room, int sessions, std::chrono::seconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (room.sessionsStarted() < sessions) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Тест 1: После прогрева цикл вход/ожидание/выход/занятие не выделяет память
+ *
+ * Проводим 1000 занятий с укороченными интервалами и проверяем счетчик выделений памяти
+ */
+TEST_F(AllocationTest, NoAllocationsAfterWarmUp) {
+    const int WARM_UP_SESSIONS = 20;
+    const int MEASURED_SESSIONS = 1000;
+
+    RoomConfig config;
+    config.session_ms = 2;
+    config.min_wait_ms = 2;
+    config.max_wait_ms = 4;
+    config.retry_delay_ms = 1;
+    config.verbose = false;
+
+    ComputerRoom room(config);
+    std::vector<std::thread> students;
+    students.reserve(config.total_ks40 + config.total_ks44);
+    for (int i = 0; i < config.total_ks40; ++i) {
+        students.emplace_back([&room, i]() {
+            room.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < config.total_ks44; ++i) {
+        students.emplace_back([&room, i]() {
+            room.studentBehavior(2, i);
+            });
+    }
+
+    bool warmed_up = waitForSessions(room, WARM_UP_SESSIONS, std::chrono::seconds(60));
+    long long before = allocation_count.load();
+    bool finished = warmed_up && waitForSessions(room, WARM_UP_SESSIONS + MEASURED_SESSIONS, std::chrono::seconds(300));
+    long long after = allocation_count.load();
+
+    room.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+
+    ASSERT_TRUE(finished) << "Проведено занятий: " << room.sessionsStarted();
+    EXPECT_EQ(after - before, 0) << "Выделений памяти за " << MEASURED_SESSIONS << " занятий";
+}
@@ -1,9 +1,70 @@
 ﻿#include <gtest/gtest.h>
 #include <thread>
 #include <chrono>
+#include <vector>
+#include <iostream>
+#include <algorithm>
 #include <locale>
 #include <clocale>
 #include "../include/computerRoom.h"
+#include "../include/metricsExporter.h"
+#include "../include/roomWatchdog.h"
+#include "../include/openLoopLoad.h"
+#include "../include/roomServer.h"
+#include "../include/roomBatch.h"
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+/**
+ * @brief Отправляет GET /metrics в подключенный сокет и возвращает весь ответ
+ */
+static std::string scrape(int fd) {
+    const char request[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(fd, request, sizeof(request) - 1, 0);
+    std::string response;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, static_cast<size_t>(received));
+    close(fd);
+    return response;
+}
+
+static std::string scrapeTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return "";
+    }
+    return scrape(fd);
+}
+
+static std::string scrapeUnix(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return "";
+    }
+    return scrape(fd);
+}
+#endif
 
 class IntegrationTest : public ::testing::Test {
 protected:
@@ -143,3 +204,887 @@ TEST_F(IntegrationTest, StudentsGetEvictedWhenOtherGroupStartsClass) {
 
     SUCCEED();
 }
+
+/**
+ * @brief Тест 6: Пакетный впуск будит каждого ожидающего места студента ровно один раз
+ *
+ * Класс на одно место, занятие не начнется никогда. Первый студент занимает место, остальные встают ждать и
+ * по истечении ожидания входят по одному. Без пакетного впуска каждое освобождение будит всех ждущих, и
+ * кол-во пробуждений зависит от планировщика; с пакетным впуском класс будит только впущенного студента.
+ */
+TEST_F(IntegrationTest, BatchedAdmissionWakesEachWaiterOnce) {
+    const int students_count = 8;
+    auto run = [&](bool batched) {
+        RoomConfig config;
+        config.capacity = 1;
+        config.need_ks40 = 2;
+        config.min_wait_ms = 200;
+        config.max_wait_ms = 200;
+        config.batched_admission = batched;
+        config.verbose = false;
+        ComputerRoom room(config);
+        std::vector<std::thread> students;
+        for (int i = 0; i < students_count; ++i) {
+            students.emplace_back([&room, i]() {
+                room.visitOnce(1, i);
+                });
+        }
+        for (auto& student : students) {
+            if (student.joinable()) student.join();
+        }
+        EXPECT_EQ(room.currentOccupancy(), 0);
+        return room.metrics();
+    };
+
+    RoomMetrics today = run(false);
+    RoomMetrics batched = run(true);
+    std::cout << "Пробуждений: без пакетного впуска " << today.wakeups << ", с пакетным впуском " << batched.wakeups
+              << "; захватов мьютекса: " << today.lock_acquisitions << " и " << batched.lock_acquisitions << std::endl;
+
+    EXPECT_EQ(batched.wakeups, students_count - 1);
+    EXPECT_GE(today.wakeups, batched.wakeups);
+    EXPECT_LE(batched.lock_acquisitions, today.lock_acquisitions);
+}
+
+/**
+ * @brief Тест 7: Временная шкала содержит ожидания студентов, посещения и занятия
+ */
+TEST_F(IntegrationTest, TracerRecordsStudentAndSessionSpans) {
+    RoomConfig config;
+    config.session_ms = 200;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+
+    ComputerRoom traced_room(config);
+    TraceRecorder tracer;
+    traced_room.setTracer(&tracer);
+
+    std::vector<std::thread> students;
+    for (int i = 0; i < 30; ++i) {
+        students.emplace_back([&traced_room, i]() {
+            traced_room.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < 24; ++i) {
+        students.emplace_back([&traced_room, i]() {
+            traced_room.studentBehavior(2, i);
+            });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    traced_room.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+
+    std::ostringstream json;
+    tracer.writeChromeTrace(json);
+    std::string text = json.str();
+
+    EXPECT_GT(traced_room.sessionsStarted(), 0);
+    EXPECT_GT(tracer.eventCount(), 0u);
+    EXPECT_NE(text.find("\"name\":\"wait_session\""), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"attend\""), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"lock_wait\""), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"session\""), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"start_class_locked\""), std::string::npos);
+    EXPECT_EQ(text.substr(text.size() - 4), "\n]}\n");
+}
+
+#ifndef _WIN32
+/**
+ * @brief Тест 8: Экспортер отдает метрики по TCP и Unix-сокету во время работы студентов
+ */
+TEST_F(IntegrationTest, MetricsExporterServesLiveCounters) {
+    RoomConfig config;
+    config.session_ms = 200;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+
+    ComputerRoom live_room(config);
+    MetricsExporter tcp_exporter(live_room);
+    MetricsExporter unix_exporter(live_room);
+    ASSERT_TRUE(tcp_exporter.startTcp(0));
+    ASSERT_GT(tcp_exporter.port(), 0);
+    std::string socket_path = "/tmp/computer_room_metrics_" + std::to_string(getpid()) + ".sock";
+    ASSERT_TRUE(unix_exporter.startUnix(socket_path));
+
+    std::vector<std::thread> students;
+    for (int i = 0; i < 30; ++i) {
+        students.emplace_back([&live_room, i]() {
+            live_room.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < 24; ++i) {
+        students.emplace_back([&live_room, i]() {
+            live_room.studentBehavior(2, i);
+            });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    std::string tcp_response = scrapeTcp(tcp_exporter.port());
+    std::string unix_response = scrapeUnix(socket_path);
+
+    live_room.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+    tcp_exporter.stop();
+    unix_exporter.stop();
+
+    EXPECT_EQ(tcp_response.rfind("HTTP/1.1 200 OK", 0), 0u);
+    EXPECT_NE(tcp_response.find("computer_room_occupancy "), std::string::npos);
+    EXPECT_NE(tcp_response.find("computer_room_students_completed{group=\"ks40\"}"), std::string::npos);
+    EXPECT_NE(tcp_response.find("computer_room_lock_wait_seconds{quantile=\"0.99\"}"), std::string::npos);
+    EXPECT_NE(tcp_response.find("computer_room_wakeups_total "), std::string::npos);
+    EXPECT_EQ(tcp_response.find("computer_room_sessions_started_total 0\n"), std::string::npos);
+    EXPECT_EQ(unix_response.rfind("HTTP/1.1 200 OK", 0), 0u);
+    EXPECT_NE(unix_response.find("computer_room_current_group "), std::string::npos);
+
+    RoomMetrics metrics = live_room.metrics();
+    EXPECT_EQ(metrics.sessions_started, live_room.sessionsStarted());
+    EXPECT_GT(metrics.visits_credited, 0);
+    EXPECT_GT(live_room.lockWaitHistogram().count(), 0u);
+    EXPECT_NE(access(socket_path.c_str(), F_OK), 0);
+}
+#endif
+
+#ifndef _WIN32
+/**
+ * @brief Тест 9: Контрольная точка во время занятия восстанавливается в новом классе, повторная точка пишет только изменения
+ */
+TEST_F(IntegrationTest, CheckpointRestoresCountersAndRunningSession) {
+    RoomConfig config;
+    config.session_ms = 1500;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+    std::string first_path = "/tmp/computer_room_checkpoint_" + std::to_string(getpid()) + "_1.bin";
+    std::string second_path = "/tmp/computer_room_checkpoint_" + std::to_string(getpid()) + "_2.bin";
+    std::string session_path = "/tmp/computer_room_checkpoint_" + std::to_string(getpid()) + "_session.bin";
+
+    ComputerRoom original(config);
+    std::vector<std::thread> students;
+    for (int i = 0; i < 30; ++i) {
+        students.emplace_back([&original, i]() {
+            original.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < 24; ++i) {
+        students.emplace_back([&original, i]() {
+            original.studentBehavior(2, i);
+            });
+    }
+
+    // Точка снимается во время работы студентов, как только идет занятие
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!original.classInSession() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_TRUE(original.checkpoint(first_path));
+    EXPECT_EQ(original.lastCheckpointRecords(), 54u);
+    {
+        std::ifstream source(first_path, std::ios::binary);
+        std::ofstream copy(session_path, std::ios::binary);
+        copy << source.rdbuf();
+    }
+    original.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+
+    CheckpointFile saved;
+    ASSERT_TRUE(saved.openReadOnly(first_path));
+    ASSERT_EQ(saved.header().in_session, 1);
+    int saved_group = saved.header().group;
+    long long saved_sessions = saved.header().sessions_started;
+    long long saved_visits = saved.header().visits_credited;
+    saved.close();
+
+    // После остановки изменений почти нет: повторная точка переписывает только изменившихся студентов
+    ASSERT_TRUE(original.checkpoint(first_path));
+    EXPECT_LT(original.lastCheckpointRecords(), 54u);
+    ASSERT_TRUE(original.checkpoint(first_path));
+    EXPECT_EQ(original.lastCheckpointRecords(), 0u);
+
+    ASSERT_TRUE(saved.openReadOnly(first_path));
+    long long saved_lock_acquisitions = saved.header().lock_acquisitions;
+    saved.close();
+
+    ComputerRoom restored(config);
+    ASSERT_TRUE(restored.restore(first_path));
+    RoomMetrics before = original.metrics();
+    RoomMetrics after = restored.metrics();
+    EXPECT_EQ(after.lock_acquisitions, saved_lock_acquisitions);
+    EXPECT_EQ(after.sessions_started, before.sessions_started);
+    EXPECT_EQ(after.visits_credited, before.visits_credited);
+    EXPECT_EQ(after.completed_ks40, before.completed_ks40);
+    EXPECT_EQ(after.completed_ks44, before.completed_ks44);
+    EXPECT_GE(after.sessions_started, saved_sessions);
+    EXPECT_GE(after.visits_credited, saved_visits);
+    EXPECT_EQ(restored.allStudentsCompleted(), original.allStudentsCompleted());
+
+    // Посещения студентов совпадают запись в запись
+    ASSERT_TRUE(restored.checkpoint(second_path));
+    CheckpointFile first;
+    CheckpointFile second;
+    ASSERT_TRUE(first.openReadOnly(first_path));
+    ASSERT_TRUE(second.openReadOnly(second_path));
+    for (int i = 0; i < 54; ++i) EXPECT_EQ(first.record(i).visits, second.record(i).visits) << "студент " << i;
+    first.close();
+    second.close();
+
+    // Занятие из точки, снятой во время занятия, продолжается, и преподаватель завершает его за оставшееся время
+    ComputerRoom resumed(config);
+    ASSERT_TRUE(resumed.restore(session_path));
+    EXPECT_TRUE(resumed.classInSession());
+    EXPECT_EQ(resumed.currentGroup(), saved_group);
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.session_ms + 500));
+    EXPECT_FALSE(resumed.classInSession());
+
+    // Файл с другими размерами групп не восстанавливается
+    RoomConfig other = config;
+    other.total_ks40 = 10;
+    ComputerRoom mismatched(other);
+    EXPECT_FALSE(mismatched.restore(first_path));
+
+    std::remove(first_path.c_str());
+    std::remove(second_path.c_str());
+    std::remove(session_path.c_str());
+}
+#endif
+
+/**
+ * @brief Тест 10: Сторожевой поток сообщает о зависании за секунды и перечисляет ждущих студентов
+ */
+TEST_F(IntegrationTest, WatchdogReportsStalledRoom) {
+    // Порог начала занятия больше вместимости: занятие не начнется никогда, студенты ходят по кругу ожиданий
+    RoomConfig config;
+    config.need_ks40 = 25;
+    config.need_ks44 = 25;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+
+    ComputerRoom stalled_room(config);
+    WatchdogOptions options;
+    options.poll_ms = 50;
+    options.stall_ms = 500;
+    RoomWatchdog watchdog(stalled_room, options);
+    watchdog.start();
+
+    std::vector<std::thread> students;
+    for (int i = 0; i < 30; ++i) {
+        students.emplace_back([&stalled_room, i]() {
+            stalled_room.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < 24; ++i) {
+        students.emplace_back([&stalled_room, i]() {
+            stalled_room.studentBehavior(2, i);
+            });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    while (watchdog.stallCount() == 0 && std::chrono::steady_clock::now() - begin < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    auto detected_after = std::chrono::steady_clock::now() - begin;
+
+    watchdog.stop();
+    stalled_room.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+
+    ASSERT_EQ(watchdog.stallCount(), 1);
+    EXPECT_LT(detected_after, std::chrono::seconds(2));
+    std::string text = watchdog.lastReport();
+    EXPECT_NE(text.find("Нет прогресса"), std::string::npos);
+    EXPECT_NE(text.find("занятие не идет"), std::string::npos);
+    EXPECT_NE(text.find("студент"), std::string::npos);
+    EXPECT_EQ(stalled_room.studentWait(1, 0).kind, StudentWaitKind::Finished);
+}
+
+/**
+ * @brief Тест 11: Подписчики получают согласованный поток событий класса, отстающий подписчик не тормозит студентов
+ */
+TEST_F(IntegrationTest, EventSubscribersSeeConsistentStream) {
+    RoomConfig config;
+    config.session_ms = 300;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+
+    ComputerRoom observed(config);
+    auto full = observed.subscribe(1 << 16, OverflowPolicy::Drop);
+    auto lagging = observed.subscribe(16, OverflowPolicy::Coalesce); // Не читается до конца работы
+
+    std::atomic<bool> running{ true };
+    std::vector<RoomEvent> events;
+    std::thread consumer([&]() {
+        while (true) {
+            bool last = !running.load();
+            if (full->drain(events, 256) == 0) {
+                if (last) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+    });
+
+    std::vector<std::thread> students;
+    for (int i = 0; i < 30; ++i) {
+        students.emplace_back([&observed, i]() {
+            observed.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < 24; ++i) {
+        students.emplace_back([&observed, i]() {
+            observed.studentBehavior(2, i);
+            });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (!observed.allStudentsCompleted() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    observed.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+    running = false;
+    consumer.join();
+
+    RoomMetrics metrics = observed.metrics();
+    EXPECT_EQ(full->dropped(), 0u);
+    ASSERT_FALSE(events.empty());
+
+    long long visits = 0, completed = 0, sessions = 0;
+    std::vector<int> inside(2 * 30, 0);
+    bool in_room_ok = true;
+    for (size_t i = 0; i < events.size(); ++i) {
+        const RoomEvent& event = events[i];
+        EXPECT_EQ(event.seq, i);
+        int index = (event.group - 1) * 30 + event.student_id;
+        switch (event.kind) {
+        case RoomEventKind::Entered: inside[index]++; break;
+        case RoomEventKind::Left:
+        case RoomEventKind::Evicted: inside[index]--; break;
+        case RoomEventKind::VisitCredited: visits++; break;
+        case RoomEventKind::Completed: completed++; break;
+        case RoomEventKind::SessionStarted: sessions++; break;
+        case RoomEventKind::SessionEnded: break;
+        }
+        if (event.kind <= RoomEventKind::Evicted && (inside[index] < 0 || inside[index] > 1)) in_room_ok = false;
+    }
+    EXPECT_TRUE(in_room_ok);
+    EXPECT_EQ(visits, metrics.visits_credited);
+    EXPECT_EQ(completed, metrics.completed_ks40 + metrics.completed_ks44);
+    EXPECT_EQ(sessions, metrics.sessions_started);
+
+    // Отстающий подписчик получает очередь и объединенные события, вместе - все события
+    std::vector<RoomEvent> late;
+    while (lagging->drain(late, 64) > 0) {}
+    uint64_t late_total = 0;
+    uint64_t newest = 0;
+    for (const RoomEvent& event : late) {
+        late_total += event.count;
+        newest = std::max(newest, event.seq);
+    }
+    EXPECT_EQ(late_total, events.size());
+    EXPECT_GT(lagging->coalesced(), 0u);
+    EXPECT_EQ(newest + 1, events.size());
+    std::cout << "Событий: " << events.size() << ", у отстающего подписчика: " << late.size() << std::endl;
+}
+
+/**
+ * @brief Тест 12: Потоки класса привязываются к процессорам узла, состояние лежит на узле, неизвестный узел - без привязки
+ */
+TEST_F(IntegrationTest, PlacementPinsWorkersAndReportsStatePages) {
+    NumaTopology topology = NumaTopology::detect();
+    ASSERT_GE(topology.nodeCount(), 1);
+    EXPECT_EQ(topology.placementForRoom(topology.nodeCount()).numa_node, 0);
+
+    RoomConfig config;
+    config.session_ms = 300;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+    config.placement = topology.placementForRoom(0);
+
+    ComputerRoom placed(config);
+    std::vector<std::thread> students;
+    for (int i = 0; i < 30; ++i) {
+        students.emplace_back([&placed, i]() {
+            placed.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < 24; ++i) {
+        students.emplace_back([&placed, i]() {
+            placed.studentBehavior(2, i);
+            });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    placed.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+
+    PlacementReport report = placed.placementReport();
+    std::cout << "Узлов: " << report.numa_nodes << ", привязано потоков: " << report.pinned_threads
+              << ", страниц на узле: " << report.state_pages_local << ", на других: " << report.state_pages_remote
+              << ", неизвестно: " << report.state_pages_unknown << std::endl;
+    EXPECT_EQ(report.node, 0);
+    EXPECT_EQ(report.cpus, topology.cpusOf(0));
+#ifdef __linux__
+    EXPECT_EQ(report.pinned_threads, 30 + 24 + 1); // Студенты и преподаватель
+    if (topology.fromSystem()) {
+        EXPECT_TRUE(report.memory_policy_applied);
+        EXPECT_GT(report.state_pages_local, 0);
+    }
+    if (topology.nodeCount() == 1) {
+        EXPECT_EQ(report.state_pages_remote, 0);
+    }
+#endif
+
+    // Узла нет: класс работает без привязки
+    RoomConfig missing = config;
+    missing.placement.numa_node = 1000;
+    missing.placement.cpus.clear();
+    ComputerRoom unplaced(missing);
+    PlacementReport fallback = unplaced.placementReport();
+    EXPECT_FALSE(fallback.memory_policy_applied);
+    EXPECT_TRUE(fallback.cpus.empty());
+    EXPECT_EQ(fallback.pinned_threads, 0);
+}
+
+/**
+ * @brief Тест 13: Открытая нагрузка - задержка от запланированного прибытия и учет незавершенных попыток
+ *
+ * Прибытия задаются генератором (пуассоновский поток, пачки, трасса), а не числом студентов. Задержка считается
+ * от запланированного времени прибытия, поэтому при перегрузке растет время ожидания в очереди группы, а попытки,
+ * не завершенные к концу прогона, учитываются отдельно.
+ */
+TEST_F(IntegrationTest, OpenLoopLatencyGrowsUnderSaturation) {
+    RoomConfig config;
+    config.session_ms = 300;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+
+    LoadOptions options;
+    options.rate_per_s = 50.0;
+    options.duration_ms = 2000;
+    std::vector<int64_t> poisson = OpenLoopGenerator::arrivals(options);
+    EXPECT_NEAR(static_cast<double>(poisson.size()), 100.0, 40.0);
+    EXPECT_TRUE(std::is_sorted(poisson.begin(), poisson.end()));
+
+    LoadOptions bursty = options;
+    bursty.process = ArrivalProcess::Bursty;
+    bursty.burst_size = 10;
+    std::vector<int64_t> bursts = OpenLoopGenerator::arrivals(bursty);
+    ASSERT_FALSE(bursts.empty());
+    EXPECT_EQ(bursts.size() % 10, 0u);
+    EXPECT_EQ(bursts[0], bursts[9]);
+
+    LoadOptions trace = options;
+    trace.process = ArrivalProcess::Trace;
+    trace.trace_ms = {500, 10, 3000, 10};
+    EXPECT_EQ(OpenLoopGenerator::arrivals(trace), (std::vector<int64_t>{10000, 10000, 500000}));
+
+    // Низкая частота: все попытки учтены
+    LoadOptions light = options;
+    light.rate_per_s = 10.0;
+    light.duration_ms = 1000;
+    light.drain_ms = 2000;
+    LoadResult low;
+    OpenLoopGenerator::run(config, light, low);
+    EXPECT_EQ(low.completed + low.unfinished, low.offered);
+    EXPECT_EQ(low.attended + low.timed_out + low.evicted, low.completed);
+    EXPECT_EQ(low.latency_us.count(), static_cast<uint64_t>(low.offered));
+
+    // Перегрузка: каждый студент занят, прибытия ждут в очереди группы, и хвост задержки растет
+    LoadOptions heavy = light;
+    heavy.rate_per_s = 400.0;
+    heavy.drain_ms = 300;
+    LoadResult high;
+    OpenLoopGenerator::run(config, heavy, high);
+    std::cout << "Низкая нагрузка: p99 " << low.latency_us.percentile(99.0) / 1000.0 << " мс, " << low.throughput
+              << "/с; перегрузка: p99 " << high.latency_us.percentile(99.0) / 1000.0 << " мс, " << high.throughput
+              << "/с, не завершено " << high.unfinished << " из " << high.offered << std::endl;
+    EXPECT_EQ(high.completed + high.unfinished, high.offered);
+    EXPECT_EQ(high.latency_us.count(), static_cast<uint64_t>(high.offered));
+    EXPECT_GT(high.unfinished, 0);
+    EXPECT_GT(high.latency_us.percentile(99.0), low.latency_us.percentile(99.0));
+    EXPECT_LT(high.throughput, high.offered_rate);
+}
+
+/**
+ * @brief Тест 14: Подготовка следующего занятия - занятия идут подряд, и класс почти не простаивает
+ *
+ * Один и тот же класс работает без подготовки и с prestage_next_session. С подготовкой группа следующего занятия
+ * выбирается по очередям заранее, и загрузка класса выше 90%; без пакетного впуска очередей нет, и подготовка
+ * не срабатывает.
+ */
+TEST_F(IntegrationTest, PrestagedSessionsStartBackToBack) {
+    RoomConfig config;
+    config.session_ms = 300;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+
+    auto runFor = [](const RoomConfig& room_config, int duration_ms) {
+        ComputerRoom room(room_config);
+        std::vector<std::thread> students;
+        for (int i = 0; i < room_config.total_ks40; ++i) {
+            students.emplace_back([&room, i]() {
+                room.studentBehavior(1, i);
+                });
+        }
+        for (int i = 0; i < room_config.total_ks44; ++i) {
+            students.emplace_back([&room, i]() {
+                room.studentBehavior(2, i);
+                });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+        RoomMetrics metrics = room.metrics();
+        room.stop();
+        for (auto& student : students) {
+            if (student.joinable()) student.join();
+        }
+        return metrics;
+    };
+
+    RoomMetrics today = runFor(config, 3000);
+    RoomConfig prestage_config = config;
+    prestage_config.prestage_next_session = true;
+    RoomMetrics prestaged = runFor(prestage_config, 3000);
+
+    std::cout << "Без подготовки: загрузка " << today.utilisation * 100 << "%, занятий в час " << today.sessions_per_hour
+              << "; с подготовкой: загрузка " << prestaged.utilisation * 100 << "%, занятий в час " << prestaged.sessions_per_hour
+              << " (подряд " << prestaged.prestaged_sessions << " из " << prestaged.sessions_started << ")" << std::endl;
+
+    EXPECT_EQ(today.prestaged_sessions, 0);
+    EXPECT_GT(prestaged.prestaged_sessions, 0);
+    EXPECT_LE(prestaged.prestaged_sessions, prestaged.sessions_started);
+    for (const RoomMetrics& metrics : { today, prestaged }) {
+        EXPECT_GT(metrics.utilisation, 0.0);
+        EXPECT_LE(metrics.utilisation, 1.0);
+        EXPECT_LE(metrics.session_time_ms, metrics.uptime_ms);
+        EXPECT_NEAR(metrics.sessions_per_hour, metrics.sessions_started * 3600000.0 / metrics.uptime_ms, metrics.sessions_per_hour * 0.05);
+    }
+    // Без подготовки загрузка зависит от того, наберет ли смешанная очередь порог, поэтому сравнение с допуском
+    EXPECT_GT(prestaged.utilisation, 0.9);
+    EXPECT_GE(prestaged.utilisation, today.utilisation - 0.02);
+
+    // Без пакетного впуска очередей нет, и подготовка отключается
+    RoomConfig unbatched = prestage_config;
+    unbatched.batched_admission = false;
+    EXPECT_EQ(runFor(unbatched, 1000).prestaged_sessions, 0);
+}
+
+#ifdef __linux__
+/**
+ * @brief Тест 15: Сервер класса отвечает на пакеты кадров через сокет и кольца, Visit выполняется в пуле, нагрузочный клиент держит 1000 соединений
+ *
+ * Быстрые операции отвечают в порядке запросов, TryEnter и Leave - вход и выход студента, поэтому вошедшего через
+ * сервер студента выгоняет занятие другой группы. Кадров в кольце больше, чем слотов, и сервер ждет, пока клиент
+ * освободит кольцо ответов. Закрытое соединение выводит своих студентов.
+ */
+TEST_F(IntegrationTest, RoomServerServesPipelinedFramesOverSocketAndRing) {
+    RoomConfig config;
+    config.session_ms = 200;
+    config.min_wait_ms = 100;
+    config.max_wait_ms = 200;
+    config.retry_delay_ms = 50;
+    config.verbose = false;
+
+    ComputerRoom served_room(config);
+    RoomServer server(served_room, 4);
+    std::string socket_path = "/tmp/computer_room_server_" + std::to_string(getpid()) + ".sock";
+    ASSERT_TRUE(server.start(socket_path));
+
+    auto request = [](uint32_t tag, RoomOp op, int group, int student_id) {
+        RoomRequest frame;
+        frame.tag = tag;
+        frame.op = static_cast<uint8_t>(op);
+        frame.group = static_cast<uint8_t>(group);
+        frame.student_id = static_cast<uint16_t>(student_id);
+        return frame;
+    };
+    auto status = [](const RoomReply& reply) {
+        return static_cast<RoomStatus>(reply.status);
+    };
+
+    // Пакет быстрых запросов одной записью: ответы в порядке запросов
+    RoomClient client;
+    ASSERT_TRUE(client.connect(socket_path));
+    std::vector<RoomRequest> batch = {
+        request(1, RoomOp::Status, 0, 0), request(2, RoomOp::TryEnter, 1, 0), request(3, RoomOp::TryEnter, 1, 0),
+        request(4, RoomOp::Leave, 1, 0), request(5, RoomOp::Leave, 1, 0), request(6, RoomOp::Leave, 0, 0),
+        request(7, static_cast<RoomOp>(99), 0, 0), request(8, RoomOp::Visit, 1, 999)
+    };
+    ASSERT_TRUE(client.send(batch.data(), batch.size()));
+    std::vector<RoomReply> replies(batch.size());
+    ASSERT_EQ(client.receive(replies.data(), replies.size(), 2000), batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) EXPECT_EQ(replies[i].tag, batch[i].tag);
+    EXPECT_EQ(status(replies[0]), RoomStatus::Ok);
+    EXPECT_EQ(replies[0].occupancy, 0);
+    EXPECT_EQ(status(replies[1]), RoomStatus::Ok);
+    EXPECT_EQ(status(replies[2]), RoomStatus::Busy); // Студент уже в классе
+    EXPECT_EQ(replies[2].occupancy, 1);
+    EXPECT_EQ(status(replies[3]), RoomStatus::Ok);
+    EXPECT_EQ(status(replies[4]), RoomStatus::BadRequest); // Студент уже вышел
+    EXPECT_EQ(status(replies[5]), RoomStatus::BadRequest);
+    EXPECT_EQ(status(replies[6]), RoomStatus::BadRequest);
+    EXPECT_EQ(status(replies[7]), RoomStatus::BadRequest);
+    EXPECT_EQ(served_room.currentOccupancy(), 0);
+
+    // Попытка одного студента: вторая одновременная отклоняется, первая ждет порога и уходит по таймауту
+    batch = { request(10, RoomOp::Visit, 1, 0), request(11, RoomOp::Visit, 1, 0) };
+    ASSERT_TRUE(client.send(batch.data(), batch.size()));
+    ASSERT_EQ(client.receive(replies.data(), 2, 3000), 2u);
+    EXPECT_EQ(replies[0].tag, 11u);
+    EXPECT_EQ(status(replies[0]), RoomStatus::Busy);
+    EXPECT_EQ(replies[1].tag, 10u);
+    EXPECT_EQ(status(replies[1]), RoomStatus::TimedOut);
+
+    // Кольца: запросов больше, чем слотов, - сервер ждет, пока клиент освободит кольцо ответов
+    RoomClient ring_client;
+    ASSERT_TRUE(ring_client.connect(socket_path));
+    ASSERT_TRUE(ring_client.attachRing());
+    EXPECT_TRUE(ring_client.ringAttached());
+    const size_t ring_requests = SharedRing<RoomRequest>::SLOTS + 1000;
+    batch.clear();
+    for (size_t i = 0; i < ring_requests; ++i) {
+        batch.push_back(request(static_cast<uint32_t>(100 + i), (i % 2 == 0) ? RoomOp::TryEnter : RoomOp::Leave, 2, 0));
+    }
+    ASSERT_TRUE(ring_client.send(batch.data(), batch.size()));
+    replies.resize(ring_requests);
+    ASSERT_EQ(ring_client.receive(replies.data(), ring_requests, 5000), ring_requests);
+    for (size_t i = 0; i < ring_requests; ++i) {
+        ASSERT_EQ(replies[i].tag, batch[i].tag);
+        ASSERT_EQ(status(replies[i]), RoomStatus::Ok);
+    }
+    EXPECT_EQ(server.connections(), 2);
+
+    // Студенты, не вышедшие сами, выводятся при закрытии соединения
+    batch = { request(1, RoomOp::TryEnter, 2, 0) };
+    ASSERT_TRUE(ring_client.send(batch.data(), 1));
+    ASSERT_EQ(ring_client.receive(replies.data(), 1, 1000), 1u);
+    EXPECT_EQ(served_room.currentOccupancy(), 1);
+    ring_client.close();
+    client.close();
+    for (int i = 0; i < 100 && server.connections() > 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(server.connections(), 0);
+    EXPECT_EQ(served_room.currentOccupancy(), 0);
+
+    // Вошедший через TryEnter студент в классе как любой другой: начало занятия другой группы его выгоняет
+    RoomClient seat_client;
+    ASSERT_TRUE(seat_client.connect(socket_path));
+    batch = { request(20, RoomOp::TryEnter, 2, 5) };
+    for (int i = 0; i < config.need_ks40; ++i) batch.push_back(request(static_cast<uint32_t>(21 + i), RoomOp::TryEnter, 1, i));
+    batch.push_back(request(50, RoomOp::Leave, 2, 5));
+    ASSERT_TRUE(seat_client.send(batch.data(), batch.size()));
+    replies.resize(batch.size());
+    ASSERT_EQ(seat_client.receive(replies.data(), batch.size(), 2000), batch.size());
+    for (size_t i = 0; i + 1 < batch.size(); ++i) EXPECT_EQ(status(replies[i]), RoomStatus::Ok) << i;
+    EXPECT_EQ(replies[config.need_ks40].group, 1);
+    EXPECT_EQ(status(replies.back()), RoomStatus::Evicted);
+    EXPECT_EQ(served_room.sessionsStarted(), 1);
+    EXPECT_EQ(served_room.metrics().visits_credited, config.need_ks40);
+    EXPECT_EQ(served_room.studentsWithVisits(2, 0), config.total_ks44);
+    seat_client.close();
+
+    // Клиент и сервер в одном процессе: на 1000 соединений нужно больше 2000 дескрипторов
+    const int bench_connections = 1000;
+    rlimit files {};
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &files), 0);
+    if (files.rlim_cur < 2 * bench_connections + 100) {
+        files.rlim_cur = std::min<rlim_t>(files.rlim_max, 2 * bench_connections + 100);
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+    ASSERT_GE(files.rlim_cur, static_cast<rlim_t>(2 * bench_connections + 100)) << "мало дескрипторов для нагрузочного клиента";
+
+    BenchOptions options;
+    options.connections = bench_connections;
+    options.depth = 2;
+    options.duration_ms = 300;
+    BenchResult result;
+    ServerBench::run(socket_path, options, result);
+    options.connections = 4;
+    options.ring = true;
+    BenchResult ring_result;
+    ServerBench::run(socket_path, options, ring_result);
+
+    // Попытки студентов через сервер: ожидание не дольше 200 мс и занятие 200 мс укладываются в drain_ms
+    options.connections = 8;
+    options.ring = false;
+    options.op = RoomOp::Visit;
+    options.duration_ms = 600;
+    BenchResult visit_result;
+    ServerBench::run(socket_path, options, visit_result);
+    std::cout << "Сокеты: " << result.connected << " соединений, " << result.requests_per_s << " запросов/с, p99 "
+              << result.latency_us.percentile(99.0) << " мкс; кольца: " << ring_result.requests_per_s << " запросов/с; попыток Visit: "
+              << visit_result.attempt_us.count() << ", p99 " << visit_result.attempt_us.percentile(99.0) / 1000.0 << " мс" << std::endl;
+
+    EXPECT_EQ(result.connected, bench_connections);
+    EXPECT_GT(result.requests, 2 * bench_connections);
+    EXPECT_EQ(static_cast<long long>(result.latency_us.count()), result.requests);
+    EXPECT_EQ(ring_result.connected, 4);
+    EXPECT_GT(ring_result.requests, 8);
+    EXPECT_EQ(visit_result.connected, 8);
+    EXPECT_GT(visit_result.attempt_us.count(), 0u);
+    EXPECT_EQ(visit_result.unanswered, 0);
+    EXPECT_EQ(static_cast<long long>(visit_result.attempt_us.count()), visit_result.requests - visit_result.by_status[static_cast<int>(RoomStatus::Busy)]);
+
+    served_room.stop();
+    server.stop();
+    EXPECT_GT(server.requestsServed(), static_cast<long long>(ring_requests));
+    EXPECT_NE(access(socket_path.c_str(), F_OK), 0);
+}
+#endif
+
+/**
+ * @brief Тест 16: Пакетный запуск переиспользует класс и потоки студентов, reset возвращает класс в начальное состояние
+ *
+ * Три прогона идут на одном классе и одном пуле потоков, каждый пишет строку JSON. После reset метрики и
+ * состояние студентов нулевые, а следующий прогон идет как на новом классе. Там же проверяются одиночная попытка
+ * visitOnce и чтение параметров из файла.
+ */
+TEST_F(IntegrationTest, BatchRunnerReusesRoomAcrossResets) {
+    RoomConfig config;
+    config.session_ms = 100;
+    config.min_wait_ms = 50;
+    config.max_wait_ms = 100;
+    config.retry_delay_ms = 20;
+    config.placement.cpus = {0};
+
+    RoomBatchRunner runner(config);
+    std::ostringstream out;
+    EXPECT_EQ(runner.run(3, 30000, out), 3);
+#ifdef __linux__
+    // Потоки пула привязываются один раз: счетчик - разные потоки, а не вызовы за все прогоны
+    EXPECT_EQ(runner.room().placementReport().pinned_threads, config.total_ks40 + config.total_ks44 + 1);
+#endif
+
+    std::istringstream lines(out.str());
+    std::string line;
+    int run = 0;
+    while (std::getline(lines, line)) {
+        run++;
+        EXPECT_EQ(line.rfind("{\"run\":" + std::to_string(run) + ",\"completed\":true", 0), 0u) << line;
+        EXPECT_EQ(line.back(), '}');
+    }
+    EXPECT_EQ(run, 3);
+
+    // После прогона класс остановлен с итогами прогона, reset возвращает его к начальному состоянию
+    ComputerRoom& reused = runner.room();
+    EXPECT_TRUE(reused.allStudentsCompleted());
+    reused.reset();
+    RoomMetrics metrics = reused.metrics();
+    EXPECT_EQ(metrics.occupancy, 0);
+    EXPECT_FALSE(metrics.in_session);
+    EXPECT_EQ(metrics.sessions_started, 0);
+    EXPECT_EQ(metrics.visits_credited, 0);
+    EXPECT_EQ(metrics.completed_ks40 + metrics.completed_ks44, 0);
+    EXPECT_EQ(metrics.lock_acquisitions, 0);
+    EXPECT_LT(metrics.uptime_ms, 1000);
+    EXPECT_FALSE(reused.allStudentsCompleted());
+    EXPECT_EQ(reused.studentsWithVisits(1, 0), config.total_ks40);
+    EXPECT_EQ(reused.studentsWithVisits(2, 0), config.total_ks44);
+    EXPECT_EQ(reused.studentWait(2, 0).kind, StudentWaitKind::NotStarted);
+    EXPECT_EQ(reused.studentLatency(1).time_to_completion_us.count(), 0u);
+    EXPECT_EQ(reused.lockWaitHistogram().count(), 0u);
+
+    // Сброшенный класс работает как новый, преподаватель после stop не завершился
+    BatchRunSummary summary = runner.runOnce(30000);
+    EXPECT_EQ(summary.run, 4);
+    EXPECT_TRUE(summary.completed);
+    EXPECT_GE(summary.sessions, 4);
+    EXPECT_EQ(summary.completed_ks40, config.total_ks40);
+    EXPECT_EQ(summary.completed_ks44, config.total_ks44);
+    EXPECT_GE(summary.visits, 2LL * (config.total_ks40 + config.total_ks44));
+    EXPECT_GT(summary.completion_p99_ms, 0u);
+
+    // Одна попытка затрагивает одного студента, reset сбрасывает только его
+    RoomConfig single_config = config;
+    single_config.verbose = false;
+    ComputerRoom single(single_config);
+    EXPECT_EQ(single.visitOnce(1, 3), AttemptOutcome::TimedOut);
+    EXPECT_EQ(single.currentOccupancy(), 0);
+    single.stop();
+    single.reset();
+    EXPECT_EQ(single.studentWait(1, 3).kind, StudentWaitKind::NotStarted);
+    EXPECT_EQ(single.lockAcquisitions(), 0);
+    EXPECT_EQ(single.visitOnce(1, 3), AttemptOutcome::TimedOut);
+
+    // Параметры для пакетного запуска из файла
+    std::string config_path = "computer_room_batch_test.conf";
+    {
+        std::ofstream file(config_path);
+        file << "# класс на 10 мест\ncapacity = 10\nneed_ks40 = 8\nsession_ms=250\nprestage_next_session = true\n";
+    }
+    RoomConfig loaded;
+    EXPECT_TRUE(loadRoomConfig(config_path, loaded));
+    EXPECT_EQ(loaded.capacity, 10);
+    EXPECT_EQ(loaded.need_ks40, 8);
+    EXPECT_EQ(loaded.need_ks44, RoomConfig().need_ks44);
+    EXPECT_EQ(loaded.session_ms, 250);
+    EXPECT_TRUE(loaded.prestage_next_session);
+    {
+        std::ofstream file(config_path);
+        file << "capacity = many\n";
+    }
+    EXPECT_FALSE(loadRoomConfig(config_path, loaded));
+    std::remove(config_path.c_str());
+    EXPECT_FALSE(loadRoomConfig(config_path, loaded));
+}
+
+/**
+ * @brief Тест 17: Студенты studentBehavior входят в свободный класс и проходят посещения без мьютекса класса
+ *
+ * Пакетный запуск не выводит события, поэтому вход без мьютекса включен; с lock_free_entry = false все входы
+ * идут через мьютекс. Кол-во захватов мьютекса зависит от планировщика и только выводится.
+ */
+TEST_F(IntegrationTest, LockFreeEntryOnStudentBehaviorPath) {
+    RoomConfig config;
+    config.session_ms = 100;
+    config.min_wait_ms = 50;
+    config.max_wait_ms = 100;
+    config.retry_delay_ms = 20;
+
+    RoomBatchRunner runner(config);
+    BatchRunSummary lock_free = runner.runOnce(30000);
+    RoomMetrics metrics = runner.room().metrics();
+    EXPECT_TRUE(lock_free.completed);
+    EXPECT_GT(metrics.lock_free_entries, 0);
+    EXPECT_GT(lock_free.lock_free_visits, 0);
+    EXPECT_LE(lock_free.lock_free_visits, metrics.lock_free_entries);
+
+    config.lock_free_entry = false;
+    RoomBatchRunner locked_runner(config);
+    BatchRunSummary locked = locked_runner.runOnce(30000);
+    EXPECT_TRUE(locked.completed);
+    EXPECT_EQ(locked_runner.room().metrics().lock_free_entries, 0);
+    EXPECT_EQ(locked.lock_free_visits, 0);
+
+    std::cout << "Захватов мьютекса: без мьютекса при входе " << lock_free.lock_acquisitions << " (посещений без мьютекса "
+              << lock_free.lock_free_visits << "), только через мьютекс " << locked.lock_acquisitions << std::endl;
+
+    // Вывод событий требует мьютекса при каждом входе
+    RoomConfig verbose_config = config;
+    verbose_config.lock_free_entry = true;
+    verbose_config.verbose = true;
+    ComputerRoom verbose_room(verbose_config);
+    EXPECT_EQ(verbose_room.visitOnce(1, 0), AttemptOutcome::TimedOut);
+    EXPECT_EQ(verbose_room.metrics().lock_free_entries, 0);
+}
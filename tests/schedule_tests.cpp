@@ -0,0 +1,214 @@
+﻿#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <locale>
+#include <clocale>
+#include "../include/scheduleExplorer.h"
+
+class ScheduleTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::locale::global(std::locale("en_US.UTF-8"));
+        std::wcout.imbue(std::locale("en_US.UTF-8"));
+    }
+
+    /**
+     * @brief Маленький класс: конкуренция за места и смена групп возникают за несколько шагов
+     */
+    static RoomConfig smallRoom(bool batched) {
+        RoomConfig config;
+        config.capacity = 3;
+        config.total_ks40 = 3;
+        config.total_ks44 = 2;
+        config.need_ks40 = 2;
+        config.need_ks44 = 2;
+        config.session_ms = 100;
+        config.min_wait_ms = 150;
+        config.batched_admission = batched;
+        config.verbose = false;
+        return config;
+    }
+
+    /**
+     * @brief Самый маленький класс для полного перебора: по студенту в группе, занятие начинает один студент
+     */
+    static RoomConfig tinyRoom() {
+        RoomConfig config = smallRoom(true);
+        config.capacity = 2;
+        config.total_ks40 = 1;
+        config.total_ks44 = 1;
+        config.need_ks40 = 1;
+        config.need_ks44 = 1;
+        return config;
+    }
+};
+
+/**
+ * @brief Тест 1: Случайные расписания настоящего класса с пакетным впуском не нарушают инварианты
+ */
+TEST_F(ScheduleTest, RandomSchedulesKeepInvariants) {
+    ScheduleExplorer explorer(smallRoom(true));
+
+    auto begin = std::chrono::steady_clock::now();
+    ExploreStats stats = explorer.exploreRandom(1, 1000);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "Случайных расписаний: " << stats.schedules << ", в секунду: " << stats.schedules / seconds
+              << ", завершились: " << stats.finished << ", занятий: " << stats.sessions << std::endl;
+
+    EXPECT_TRUE(stats.failure.ok) << "зерно " << stats.failure.seed << ": " << stats.failure.violation;
+    EXPECT_EQ(stats.schedules, 1000);
+    EXPECT_GT(stats.sessions, 0);
+}
+
+/**
+ * @brief Тест 2: Случайные расписания без пакетного впуска не нарушают инварианты
+ */
+TEST_F(ScheduleTest, RandomSchedulesWithoutBatchedAdmission) {
+    ScheduleExplorer explorer(smallRoom(false));
+    ExploreStats stats = explorer.exploreRandom(1, 1000);
+    EXPECT_TRUE(stats.failure.ok) << "зерно " << stats.failure.seed << ": " << stats.failure.violation;
+    EXPECT_GT(stats.sessions, 0);
+}
+
+/**
+ * @brief Тест 3: Полный перебор расписаний с ограничением на вытеснения завершается без нарушений
+ */
+TEST_F(ScheduleTest, ExhaustiveSchedulesWithPreemptionBound) {
+    ScheduleOptions options;
+    options.max_attempts = 1;
+    ScheduleExplorer explorer(tinyRoom(), options);
+
+    ExploreStats stats = explorer.exploreExhaustive(1, 1000000);
+    std::cout << "Расписаний при 1 вытеснении: " << stats.schedules << (stats.complete ? " (все)" : "") << std::endl;
+
+    EXPECT_TRUE(stats.failure.ok) << stats.failure.violation;
+    EXPECT_TRUE(stats.complete);
+}
+
+/**
+ * @brief Тест 4: Стенд находит потерянное уведомление и воспроизводит расписание по зерну и по выборам
+ */
+TEST_F(ScheduleTest, LostNotificationIsFoundAndReproducible) {
+    ScheduleOptions options;
+    options.lose_notification = 1;
+    ScheduleExplorer explorer(smallRoom(true), options);
+
+    ExploreStats stats = explorer.exploreRandom(1, 1000);
+    ASSERT_FALSE(stats.failure.ok) << "нарушение не найдено за " << stats.schedules << " расписаний";
+    std::cout << "Нарушение (зерно " << stats.failure.seed << ", шагов " << stats.failure.steps << "): "
+              << stats.failure.violation << std::endl;
+
+    ScheduleResult again = explorer.runRandom(stats.failure.seed);
+    EXPECT_FALSE(again.ok);
+    EXPECT_EQ(again.violation, stats.failure.violation);
+    EXPECT_EQ(again.choices, stats.failure.choices);
+
+    ScheduleResult replayed = explorer.replay(stats.failure.choices);
+    EXPECT_FALSE(replayed.ok);
+    EXPECT_EQ(replayed.violation, stats.failure.violation);
+
+    // Перебор находит ту же ошибку и в самом маленьком классе. Там первое уведомление - cv.notify_all при начале
+    // занятия, которого еще никто не ждет, поэтому теряется второе - преподавателю о начале занятия
+    options.max_attempts = 1;
+    options.lose_notification = 2;
+    ScheduleExplorer tiny(tinyRoom(), options);
+    ExploreStats exhaustive = tiny.exploreExhaustive(1, 1000000);
+    EXPECT_FALSE(exhaustive.failure.ok);
+    EXPECT_FALSE(tiny.replay(exhaustive.failure.choices).ok);
+}
+
+/**
+ * @brief Тест 5: При подготовке следующего занятия студенты не ждут конца занятия, начатого подряд с их собственным, вне класса
+ *
+ * Впущенный или ждавший начала студент мог получить мьютекс уже после того, как его занятие закончилось и в той же
+ * критической секции началось следующее занятие его группы - стенд проверяет, что такой студент его не просиживает.
+ */
+TEST_F(ScheduleTest, PrestagedSessionsKeepInvariants) {
+    RoomConfig config = smallRoom(true);
+    config.prestage_next_session = true;
+    ScheduleExplorer explorer(config);
+
+    ExploreStats stats = explorer.exploreRandom(1, 1000);
+    std::cout << "Занятий: " << stats.sessions << ", из них подряд с подготовкой: " << stats.prestaged_sessions << std::endl;
+    EXPECT_TRUE(stats.failure.ok) << "зерно " << stats.failure.seed << ": " << stats.failure.violation;
+    EXPECT_EQ(stats.schedules, 1000);
+    EXPECT_GT(stats.prestaged_sessions, 0);
+
+    ScheduleOptions options;
+    options.max_attempts = 1;
+    RoomConfig tiny = tinyRoom();
+    tiny.prestage_next_session = true;
+    ScheduleExplorer exhaustive(tiny, options);
+    ExploreStats all = exhaustive.exploreExhaustive(1, 1000000);
+    EXPECT_TRUE(all.failure.ok) << all.failure.violation;
+    EXPECT_TRUE(all.complete);
+    EXPECT_GT(all.prestaged_sessions, 0);
+}
+
+/**
+ * @brief Тест 6: Ограниченная очередь и срок ожидания места сохраняют счетчики ожидающих
+ *
+ * Срок ожидания впуска может истечь, когда класс уже впустил студента: тогда студент принимает впуск, а не выходит
+ * из очереди сам. Стенд проверяет, что такие расписания действительно встречаются.
+ */
+TEST_F(ScheduleTest, BoundedWaitListWithTimeoutKeepsInvariants) {
+    RoomConfig config = smallRoom(true);
+    config.wait_list_limit = 1;
+    config.wait_timeout_ms = 50;
+    ScheduleExplorer explorer(config);
+
+    ExploreStats stats = explorer.exploreRandom(1, 1000);
+    std::cout << "Не дождались места: " << stats.seat_timeouts << ", не встали в очередь: " << stats.seat_rejections
+              << ", впущены после срока: " << stats.raced_timeouts << std::endl;
+    EXPECT_TRUE(stats.failure.ok) << "зерно " << stats.failure.seed << ": " << stats.failure.violation;
+    EXPECT_EQ(stats.schedules, 1000);
+    EXPECT_GT(stats.seat_timeouts, 0);
+    EXPECT_GT(stats.seat_rejections, 0);
+    EXPECT_GT(stats.raced_timeouts, 0);
+
+    config.batched_admission = false;
+    ScheduleExplorer unbatched(config);
+    ExploreStats plain = unbatched.exploreRandom(1, 1000);
+    EXPECT_TRUE(plain.failure.ok) << "зерно " << plain.failure.seed << ": " << plain.failure.violation;
+    EXPECT_GT(plain.seat_timeouts, 0);
+    EXPECT_GT(plain.seat_rejections, 0);
+}
+
+/**
+ * @brief Тест 7: Вход без мьютекса класса сохраняет счетчики присутствия и посещения
+ *
+ * Студент, вошедший в свободный класс одной CAS-операцией, ставит флаг присутствия уже после нее; начало занятия
+ * должно дождаться его флага, чтобы выгнать его или засчитать посещение. Стенд проверяет, что такие входы и посещения,
+ * прошедшие целиком без мьютекса класса, действительно встречаются - в том числе вместе с подготовкой занятий.
+ */
+TEST_F(ScheduleTest, LockFreeEntryKeepsInvariants) {
+    RoomConfig config = smallRoom(true);
+    ScheduleExplorer explorer(config);
+
+    ExploreStats stats = explorer.exploreRandom(1, 1000);
+    std::cout << "Входов без мьютекса: " << stats.lock_free_entries << ", посещений без мьютекса: " << stats.lock_free_visits
+              << std::endl;
+    EXPECT_TRUE(stats.failure.ok) << "зерно " << stats.failure.seed << ": " << stats.failure.violation;
+    EXPECT_GT(stats.lock_free_entries, 0);
+    EXPECT_GT(stats.lock_free_visits, 0);
+
+    config.prestage_next_session = true;
+    ScheduleExplorer prestaged(config);
+    ExploreStats both = prestaged.exploreRandom(1, 1000);
+    EXPECT_TRUE(both.failure.ok) << "зерно " << both.failure.seed << ": " << both.failure.violation;
+    EXPECT_GT(both.lock_free_visits, 0);
+
+    // Перебор: двое студентов КС-40 начинают занятие, первый из них входит без мьютекса. Полный перебор без
+    // вытеснений занимает около 50 тысяч расписаний, поэтому проверяется только его начало
+    ScheduleOptions options;
+    options.max_attempts = 1;
+    RoomConfig tiny = tinyRoom();
+    tiny.total_ks40 = 2;
+    tiny.need_ks40 = 2;
+    ScheduleExplorer exhaustive(tiny, options);
+    ExploreStats all = exhaustive.exploreExhaustive(0, 5000);
+    EXPECT_TRUE(all.failure.ok) << all.failure.violation;
+    EXPECT_EQ(all.schedules, 5000);
+    EXPECT_GT(all.lock_free_entries, 0);
+}
@@ -0,0 +1,151 @@
+﻿#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <iostream>
+#include <locale>
+#include <clocale>
+#include "../include/computerRoom.h"
+
+class StressTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::setlocale(LC_ALL, "en_US.UTF-8");
+        std::locale::global(std::locale("en_US.UTF-8"));
+        std::wcout.imbue(std::locale("en_US.UTF-8"));
+    }
+
+    static constexpr int CAPACITY = 20;
+    static constexpr int THREADS = 64;
+};
+
+/**
+ * @brief Тест 1: Быстрый путь входа не превышает вместимость класса при 64 конкурирующих потоках
+ */
+TEST_F(StressTest, FastPathNeverExceedsCapacity) {
+    ComputerRoom room;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stop{ false };
+    std::atomic<int> holders{ 0 };
+    std::atomic<int> max_holders{ 0 };
+    std::atomic<int> max_occupancy{ 0 };
+
+    for (int i = 0; i < THREADS; ++i) {
+        threads.emplace_back([&, i]() {
+            int group = i % 2 + 1;
+            while (!stop) {
+                if (!room.tryAcquireSeat(group)) continue;
+                int now = ++holders;
+                int seen = max_holders.load();
+                while (now > seen && !max_holders.compare_exchange_weak(seen, now)) {}
+                int occ = room.currentOccupancy();
+                seen = max_occupancy.load();
+                while (occ > seen && !max_occupancy.compare_exchange_weak(seen, occ)) {}
+                holders--;
+                room.releaseSeat();
+            }
+            });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    stop = true;
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_LE(max_holders.load(), CAPACITY);
+    EXPECT_LE(max_occupancy.load(), CAPACITY);
+    EXPECT_EQ(room.currentOccupancy(), 0);
+}
+
+/**
+ * @brief Тест 2: Вместимость не превышается при полной симуляции обеих групп
+ */
+TEST_F(StressTest, StudentsNeverExceedCapacity) {
+    ComputerRoom room;
+    std::vector<std::thread> students;
+    std::atomic<bool> stop{ false };
+    int max_occupancy = 0;
+
+    for (int i = 0; i < 30; ++i) {
+        students.emplace_back([&room, i]() {
+            room.studentBehavior(1, i);
+            });
+    }
+    for (int i = 0; i < 24; ++i) {
+        students.emplace_back([&room, i]() {
+            room.studentBehavior(2, i);
+            });
+    }
+
+    std::thread sampler([&]() {
+        while (!stop) {
+            max_occupancy = std::max(max_occupancy, room.currentOccupancy());
+            std::this_thread::yield();
+        }
+        });
+
+    std::this_thread::sleep_for(std::chrono::seconds(8));
+    room.stop();
+    for (auto& student : students) {
+        if (student.joinable()) student.join();
+    }
+    stop = true;
+    sampler.join();
+
+    EXPECT_LE(max_occupancy, CAPACITY);
+}
+
+/**
+ * @brief Тест 3: Пропускная способность входа/выхода при 64 потоках
+ *
+ * Сравниваем быстрый путь (CAS) с тем же счетчиком мест под глобальным мьютексом
+ */
+TEST_F(StressTest, AdmissionThroughputAt64Threads) {
+    const auto duration = std::chrono::seconds(1);
+
+    auto run = [&](auto&& admit_once) {
+        std::vector<std::thread> threads;
+        std::atomic<bool> stop{ false };
+        std::atomic<long long> ops{ 0 };
+        for (int i = 0; i < THREADS; ++i) {
+            threads.emplace_back([&, i]() {
+                long long local = 0;
+                while (!stop) {
+                    if (admit_once(i % 2 + 1)) local++;
+                }
+                ops += local;
+                });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+        for (auto& thread : threads) thread.join();
+        return ops.load();
+    };
+
+    ComputerRoom room;
+    long long fast_ops = run([&room](int group) {
+        if (!room.tryAcquireSeat(group)) return false;
+        room.releaseSeat();
+        return true;
+        });
+
+    std::mutex mtx;
+    int occupancy = 0;
+    long long locked_ops = run([&](int) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (occupancy >= CAPACITY) return false;
+            occupancy++;
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        occupancy--;
+        return true;
+        });
+
+    std::cout << "Входов в секунду при " << THREADS << " потоках: CAS " << fast_ops
+              << ", мьютекс " << locked_ops << std::endl;
+
+    EXPECT_GT(fast_ops, 0);
+    EXPECT_EQ(room.currentOccupancy(), 0);
+}
@@ -7,6 +7,10 @@
 #include <locale>
 #include <clocale>
 #include "../include/computerRoom.h"
+#include "../include/capacityPlanner.h"
+#include "../include/markovEstimator.h"
+#include "../include/roomSimulator.h"
+#include <algorithm>
 
 class SystemTest : public ::testing::Test {
 protected:
@@ -75,6 +79,16 @@ TEST_F(SystemTest, CompleteSystemSimulationUntilCompletion) {
     room.printStatistics();
 
     EXPECT_TRUE(room.allStudentsCompleted()) << "Система не достигла конечного состояния";
+
+    // Каждый студент один раз дошел до второго посещения и один раз записал кол-во выгонов
+    StudentLatency all;
+    all.merge(room.studentLatency(1));
+    all.merge(room.studentLatency(2));
+    EXPECT_EQ(all.time_to_completion_us.count(), 54u);
+    EXPECT_EQ(all.evictions.count(), 54u);
+    EXPECT_GT(all.time_to_seat_us.count(), 0u);
+    EXPECT_GT(all.time_to_session_us.count(), 0u);
+    EXPECT_LE(all.time_to_completion_us.percentile(50.0), all.time_to_completion_us.max());
 }
 
 /**
@@ -129,3 +143,230 @@ TEST_F(SystemTest, SystemBoundaryConditions) {
     std::cout << "Все граничные условия обработаны корректно" << std::endl;
     SUCCEED();
 }
+
+/**
+ * @brief Тест 3: Планировщик находит самую дешевую конфигурацию, удовлетворяющую цели
+ *
+ * Проверяем найденную конфигурацию на других зернах и что вместимость на единицу меньше цель не выполняет
+ */
+TEST_F(SystemTest, CapacityPlannerFindsCheapestFeasibleConfig) {
+    RoomConfig base;
+    PlanTarget target;
+    target.percentile = 95.0;
+    target.deadline_ms = 120000;
+    PlanSpace space;
+    space.need_ks40_values = { 15 };
+    space.need_ks44_values = { 12 };
+    PlanOptions options;
+    options.runs_per_point = 200;
+
+    PlanResult result = planCapacity(base, target, space, options);
+    ASSERT_TRUE(result.found);
+    std::cout << "Найдено мест: " << result.best.config.capacity << ", p95 " << result.best.percentile_ms << " мс, оценено точек "
+              << result.evaluated.size() << std::endl;
+
+    EXPECT_TRUE(result.best.feasible);
+    EXPECT_LE(result.best.percentile_ms, target.deadline_ms);
+    EXPECT_GE(result.best.config.capacity, 15);
+
+    options.seed = 100000;
+    PlanPoint recheck = evaluatePlanPoint(result.best.config, target, options);
+    EXPECT_LE(recheck.exceed_share, 0.15);
+
+    if (result.best.config.capacity > 15) {
+        RoomConfig smaller = result.best.config;
+        smaller.capacity--;
+        options.seed = 1;
+        EXPECT_FALSE(evaluatePlanPoint(smaller, target, options).feasible);
+    }
+}
+
+/**
+ * @brief Тест 4: Недостижимая цель отбрасывается досрочно, без полного числа прогонов
+ */
+TEST_F(SystemTest, CapacityPlannerStopsEarlyOnInfeasibleTarget) {
+    RoomConfig base;
+    PlanTarget target;
+    target.deadline_ms = 5000; // За 5 секунд нельзя провести 4 занятия по 5 секунд
+    PlanSpace space;
+    PlanOptions options;
+
+    PlanResult result = planCapacity(base, target, space, options);
+    EXPECT_FALSE(result.found);
+    ASSERT_FALSE(result.evaluated.empty());
+    for (const PlanPoint& point : result.evaluated) {
+        EXPECT_FALSE(point.feasible);
+        EXPECT_TRUE(point.stopped_early);
+        EXPECT_LT(point.runs, options.runs_per_point);
+    }
+}
+
+/**
+ * @brief Тест 5: Аналитическая оценка согласуется с моделью класса и отсекает заведомо недопустимые точки
+ *
+ * Модель предполагает случайный порядок входа, а RoomSimulator обходит студентов по кругу, поэтому
+ * сравнение выполняется с допуском, а не точно
+ */
+TEST_F(SystemTest, MarkovEstimateMatchesSimulatorAndPrunesPlanner) {
+    RoomConfig config;
+    config.verbose = false;
+
+    auto begin = std::chrono::steady_clock::now();
+    MarkovEstimate estimate = MarkovEstimator(config).estimate();
+    auto solve_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    ASSERT_TRUE(estimate.feasible);
+    EXPECT_LT(solve_ms, 100);
+
+    RoomSimulator simulator(config);
+    std::vector<int> times;
+    double sessions = 0.0;
+    for (uint64_t seed = 1; seed <= 400; ++seed) {
+        SimResult result = simulator.run(seed, 600000);
+        ASSERT_TRUE(result.completed);
+        times.push_back(result.completion_ms);
+        sessions += result.sessions;
+    }
+    std::sort(times.begin(), times.end());
+    sessions /= times.size();
+    double sim_p50 = times[times.size() / 2];
+    double sim_p95 = times[times.size() * 95 / 100];
+
+    std::cout << "Модель: занятий " << estimate.expected_sessions << ", p50 " << estimate.percentileMs(50) << " мс, p95 "
+              << estimate.percentileMs(95) << " мс (" << solve_ms << " мс на решение)" << std::endl;
+    std::cout << "Симуляция: занятий " << sessions << ", p50 " << sim_p50 << " мс, p95 " << sim_p95 << " мс" << std::endl;
+
+    EXPECT_NEAR(estimate.expected_sessions, sessions, 0.25 * sessions);
+    EXPECT_NEAR(estimate.percentileMs(50), sim_p50, 0.25 * sim_p50);
+    EXPECT_NEAR(estimate.percentileMs(95), sim_p95, 0.25 * sim_p95);
+
+    // Порог выше вместимости: ни одно занятие КС-40 не начнется
+    RoomConfig impossible = config;
+    impossible.capacity = 10;
+    EXPECT_FALSE(MarkovEstimator(impossible).estimate().feasible);
+
+    // Цель в 5 секунд отсекается моделью без единого прогона
+    PlanTarget target;
+    target.deadline_ms = 5000;
+    PlanSpace space;
+    space.need_ks40_values = { 15 };
+    space.need_ks44_values = { 12 };
+    PlanOptions options;
+    options.model_prune_factor = 1.0;
+    PlanResult result = planCapacity(config, target, space, options);
+    EXPECT_FALSE(result.found);
+    ASSERT_FALSE(result.evaluated.empty());
+    for (const PlanPoint& point : result.evaluated) {
+        EXPECT_TRUE(point.pruned);
+        EXPECT_EQ(point.runs, 0);
+    }
+}
+
+/**
+ * @brief Тест 6: Ограничение очереди ожидания места - доля отказов против p99 ожидания места
+ *
+ * Чем короче очередь, тем больше попыток отклоняется сразу и тем меньше ожидание места у впущенных;
+ * тайм-аут очереди ограничивает ожидание места сверху.
+ */
+TEST_F(SystemTest, BoundedWaitListTradesRejectionsForSeatLatency) {
+    RoomConfig base;
+    base.session_ms = 300;
+    base.min_wait_ms = 100;
+    base.max_wait_ms = 200;
+    base.retry_delay_ms = 50;
+    base.verbose = false;
+
+    struct Point {
+        double rejection_share;
+        uint64_t p99_seat_us;
+        RoomMetrics metrics;
+    };
+    auto runFor = [](const RoomConfig& config) {
+        ComputerRoom room(config);
+        std::vector<std::thread> students;
+        for (int i = 0; i < config.total_ks40; ++i) {
+            students.emplace_back([&room, i]() {
+                room.studentBehavior(1, i);
+                });
+        }
+        for (int i = 0; i < config.total_ks44; ++i) {
+            students.emplace_back([&room, i]() {
+                room.studentBehavior(2, i);
+                });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+        room.stop();
+        for (auto& student : students) {
+            if (student.joinable()) student.join();
+        }
+
+        StudentLatency all;
+        all.merge(room.studentLatency(1));
+        all.merge(room.studentLatency(2));
+        Point point;
+        point.metrics = room.metrics();
+        long long refused = point.metrics.seat_rejections + point.metrics.seat_timeouts;
+        long long attempts = refused + static_cast<long long>(all.time_to_seat_us.count());
+        point.rejection_share = attempts > 0 ? static_cast<double>(refused) / attempts : 0.0;
+        point.p99_seat_us = all.time_to_seat_us.percentile(99.0);
+        return point;
+    };
+
+    std::vector<Point> curve;
+    for (int limit : { 0, 16, 8, 2 }) {
+        RoomConfig config = base;
+        config.wait_list_limit = limit;
+        curve.push_back(runFor(config));
+        std::cout << "Очередь " << (limit ? std::to_string(limit) : std::string("без ограничения")) << ": отказов "
+                  << curve.back().rejection_share * 100 << "%, p99 ожидания места "
+                  << curve.back().p99_seat_us / 1000.0 << " мс, посещений " << curve.back().metrics.visits_credited << std::endl;
+    }
+    EXPECT_EQ(curve.front().metrics.seat_rejections, 0);
+    EXPECT_GT(curve.back().metrics.seat_rejections, 0);
+    EXPECT_GT(curve.back().rejection_share, curve.front().rejection_share);
+    EXPECT_LT(curve.back().p99_seat_us, curve.front().p99_seat_us);
+
+    RoomConfig timed = base;
+    timed.wait_timeout_ms = 100;
+    Point timeout_point = runFor(timed);
+    std::cout << "Тайм-аут очереди 100 мс: отказов " << timeout_point.rejection_share * 100 << "%, p99 ожидания места "
+              << timeout_point.p99_seat_us / 1000.0 << " мс" << std::endl;
+    EXPECT_GT(timeout_point.metrics.seat_timeouts, 0);
+    EXPECT_EQ(timeout_point.metrics.seat_rejections, 0);
+    EXPECT_LT(timeout_point.p99_seat_us, 150000u); // Тайм-аут плюс погрешность корзины и захват мьютекса
+
+    // Без пакетного впуска ограничения работают так же
+    RoomConfig unbatched = base;
+    unbatched.batched_admission = false;
+    unbatched.wait_list_limit = 2;
+    unbatched.wait_timeout_ms = 100;
+    Point unbatched_point = runFor(unbatched);
+    EXPECT_GT(unbatched_point.metrics.seat_rejections + unbatched_point.metrics.seat_timeouts, 0);
+    EXPECT_LT(unbatched_point.p99_seat_us, 150000u);
+}
+
+/**
+ * @brief Тест 7: Оценка не выходит за горизонт модели, когда одна из групп почти не завершается
+ *
+ * Конфигурации, при которых распределение доходит до MAX_SESSIONS занятий (вторая - из сетки PlanSpace по умолчанию).
+ */
+TEST_F(SystemTest, MarkovEstimateStopsAtHorizon) {
+    RoomConfig base;
+    base.verbose = false;
+    const int points[2][3] = { { 20, 1, 20 }, { 12, 10, 12 } };
+    for (const auto& point : points) {
+        RoomConfig config = base;
+        config.capacity = point[0];
+        config.need_ks40 = point[1];
+        config.need_ks44 = point[2];
+        MarkovEstimate estimate = MarkovEstimator(config).estimate();
+        ASSERT_LE(estimate.completion_cdf.size(), static_cast<size_t>(MarkovEstimator::MAX_SESSIONS + 1));
+        EXPECT_EQ(estimate.completion_cdf.size(), estimate.completion_ms.size());
+        double previous = 0.0;
+        for (double cdf : estimate.completion_cdf) {
+            EXPECT_GE(cdf, previous - 1e-12);
+            EXPECT_LE(cdf, 1.0 + 1e-9);
+            previous = cdf;
+        }
+        EXPECT_GE(estimate.expected_sessions, 0.0);
+    }
+}
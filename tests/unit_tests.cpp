@@ -1,7 +1,24 @@
 ﻿#include <gtest/gtest.h>
 #include <locale>
 #include <clocale>
+#include <sstream>
 #include "../include/computerRoom.h"
+#include "../include/traceRecorder.h"
+#include "../include/roomSimulator.h"
+#include "../include/latencyHistogram.h"
+#include "../include/roomEvents.h"
+#include "../include/visitIndex.h"
+#include "../include/roomEnsemble.h"
+#include "../include/capacityPlanner.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 class UnitTest : public ::testing::Test {
 protected:
@@ -50,3 +67,314 @@ TEST_F(UnitTest, MultipleStopCallsAreSafe) {
     room.stop();
     SUCCEED();
 }
+
+/**
+ * @brief Тест 5: Запись временной шкалы в формате Chrome trace-event JSON и отбрасывание интервалов сверх буфера
+ */
+TEST_F(UnitTest, TraceRecorderWritesChromeTraceEvents) {
+    TraceRecorder tracer(2);
+    auto begin = TraceRecorder::Clock::now();
+    auto end = begin + std::chrono::milliseconds(3);
+    tracer.record(TraceRecorder::Span::WaitSeat, 1, 7, begin, end);
+    tracer.record(TraceRecorder::Span::Session, 2, 1, begin, end);
+    tracer.record(TraceRecorder::Span::Attend, 2, 3, begin, end);
+
+    EXPECT_EQ(tracer.eventCount(), 2u);
+    EXPECT_EQ(tracer.droppedCount(), 1u);
+
+    std::ostringstream json;
+    tracer.writeChromeTrace(json);
+    std::string text = json.str();
+    EXPECT_EQ(text.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(text.find("\"name\":\"wait_seat\",\"cat\":\"student\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(text.find("\"dur\":3000,\"pid\":1,\"tid\":7"), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"session\""), std::string::npos);
+    EXPECT_EQ(text.find("attend"), std::string::npos);
+}
+
+/**
+ * @brief Тест 6: Модель класса воспроизводима по зерну и успевает до таймаута main.cpp при параметрах по умолчанию
+ */
+TEST_F(UnitTest, SimulatorIsDeterministicPerSeed) {
+    RoomConfig config;
+    RoomSimulator simulator(config);
+    EXPECT_EQ(simulator.tickMs(), 1000);
+
+    SimResult first = simulator.run(42, 200000);
+    SimResult second = simulator.run(42, 200000);
+    EXPECT_EQ(first.completed, second.completed);
+    EXPECT_EQ(first.completion_ms, second.completion_ms);
+    EXPECT_EQ(first.sessions, second.sessions);
+
+    EXPECT_TRUE(first.completed);
+    EXPECT_GE(first.sessions, 4); // Каждой группе нужно минимум 2 занятия
+}
+
+/**
+ * @brief Тест 7: Перцентили гистограммы задержек с погрешностью корзин и сложение гистограмм
+ */
+TEST_F(UnitTest, LatencyHistogramPercentilesAndMerge) {
+    LatencyHistogram first;
+    LatencyHistogram second;
+    for (uint64_t value = 1; value <= 1000; ++value) first.record(value);
+    for (uint64_t value = 1001; value <= 2000; ++value) second.record(value);
+
+    // Относительная погрешность корзин не больше 1/SUB_BUCKETS
+    const double tolerance = 1.0 / LatencyHistogram::SUB_BUCKETS;
+    EXPECT_NEAR(static_cast<double>(first.percentile(50.0)), 500.0, 500.0 * tolerance);
+    EXPECT_NEAR(static_cast<double>(first.percentile(99.0)), 990.0, 990.0 * tolerance);
+    EXPECT_EQ(first.percentile(100.0), 1000u);
+    EXPECT_EQ(first.max(), 1000u);
+
+    first.merge(second);
+    EXPECT_EQ(first.count(), 2000u);
+    EXPECT_EQ(first.sum(), 2000u * 2001u / 2u);
+    EXPECT_EQ(first.max(), 2000u);
+    EXPECT_NEAR(static_cast<double>(first.percentile(50.0)), 1000.0, 1000.0 * tolerance);
+    EXPECT_NEAR(static_cast<double>(first.percentile(99.9)), 1998.0, 1998.0 * tolerance);
+
+    LatencyHistogram empty;
+    EXPECT_EQ(empty.percentile(99.0), 0u);
+}
+
+/**
+ * @brief Тест 8: Очередь событий с одним производителем и несколькими потребителями
+ *
+ * При Drop каждое событие либо получено ровно одним потребителем, либо учтено как отброшенное.
+ * При Coalesce события сверх очереди приходят объединенными, и сумма count равна числу опубликованных.
+ */
+TEST_F(UnitTest, EventSubscriptionDeliversOnceOrCountsOverflow) {
+    const uint64_t total = 200000;
+    EventSubscription queue(256, OverflowPolicy::Drop);
+    std::atomic<bool> producing{ true };
+    std::vector<std::vector<uint64_t>> received(3);
+    std::vector<std::thread> consumers;
+    for (auto& seqs : received) {
+        consumers.emplace_back([&queue, &producing, &seqs]() {
+            RoomEvent batch[64];
+            while (true) {
+                bool last = !producing.load();
+                size_t taken = queue.drain(batch, 64);
+                for (size_t i = 0; i < taken; ++i) seqs.push_back(batch[i].seq);
+                if (taken == 0 && last) break;
+                if (taken == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (uint64_t seq = 0; seq < total; ++seq) {
+        RoomEvent event;
+        event.seq = seq;
+        queue.publish(event);
+    }
+    producing = false;
+    for (auto& consumer : consumers) consumer.join();
+
+    std::vector<uint64_t> all;
+    for (const auto& seqs : received) {
+        EXPECT_TRUE(std::is_sorted(seqs.begin(), seqs.end()));
+        all.insert(all.end(), seqs.begin(), seqs.end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end());
+    EXPECT_EQ(all.size() + queue.dropped(), total);
+
+    EventSubscription coalescing(8, OverflowPolicy::Coalesce);
+    for (int i = 0; i < 100; ++i) {
+        RoomEvent event;
+        event.seq = static_cast<uint64_t>(i);
+        event.kind = (i % 2) ? RoomEventKind::Entered : RoomEventKind::Left;
+        event.group = 1;
+        coalescing.publish(event);
+    }
+    std::vector<RoomEvent> events;
+    while (coalescing.drain(events, 3) > 0) {}
+    uint64_t delivered = 0;
+    for (const RoomEvent& event : events) delivered += event.count;
+    EXPECT_EQ(delivered, 100u);
+    EXPECT_EQ(coalescing.coalesced(), 100u - coalescing.capacity());
+    EXPECT_EQ(events.size(), coalescing.capacity() + 2); // Очередь и по одному объединенному событию на вид
+    uint64_t newest = 0;
+    for (const RoomEvent& event : events) newest = std::max(newest, event.seq);
+    EXPECT_EQ(newest, 99u);
+
+    // Публикация вперемешку с чтением одним потребителем: объединенные события не обгоняют очередь и наоборот
+    EventSubscription interleaved(8, OverflowPolicy::Coalesce);
+    std::vector<RoomEvent> ordered;
+    uint64_t next = 0;
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 5 + round % 13; ++i) {
+            RoomEvent event;
+            event.seq = next++;
+            event.kind = static_cast<RoomEventKind>(event.seq % 3);
+            event.group = static_cast<int8_t>(1 + event.seq % 2);
+            interleaved.publish(event);
+        }
+        interleaved.drain(ordered, 1 + round % 4);
+    }
+    while (interleaved.drain(ordered, 4) > 0) {}
+    uint64_t ordered_total = 0;
+    for (const RoomEvent& event : ordered) ordered_total += event.count;
+    EXPECT_EQ(ordered_total, next);
+    EXPECT_GT(interleaved.coalesced(), 0u);
+    EXPECT_TRUE(std::is_sorted(ordered.begin(), ordered.end(),
+                               [](const RoomEvent& a, const RoomEvent& b) { return a.seq < b.seq; }));
+}
+
+/**
+ * @brief Тест 9: Индекс посещений совпадает с полным обходом после каждого изменения
+ *
+ * Случайные изменения посещений сверяются с подсчетом по массиву; обход корзин дает каждого студента ровно один раз.
+ */
+TEST_F(UnitTest, VisitIndexMatchesRosterScan) {
+    const int students = 1000;
+    VisitIndex index(students, 2);
+    std::vector<int> visits(students, 0);
+    EXPECT_EQ(index.count(0), students);
+    EXPECT_EQ(index.lagging(), students);
+    EXPECT_FALSE(index.allCompleted());
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> pick(0, students - 1);
+    for (int step = 0; step < 20000; ++step) {
+        int id = pick(gen);
+        visits[id] = (step % 7 == 0) ? 0 : visits[id] + 1; // Иногда сброс, как при восстановлении из точки
+        index.setVisits(id, visits[id]);
+
+        if (step % 997 == 0) {
+            for (int bucket = 0; bucket <= 2; ++bucket) {
+                int expected = static_cast<int>(std::count_if(visits.begin(), visits.end(), [bucket](int v) {
+                    return bucket < 2 ? v == bucket : v >= 2;
+                }));
+                EXPECT_EQ(index.count(bucket), expected);
+
+                int listed = 0;
+                for (int i = index.first(bucket); i >= 0; i = index.next(i)) {
+                    EXPECT_EQ(index.bucketOf(i), bucket);
+                    listed++;
+                }
+                EXPECT_EQ(listed, expected);
+            }
+        }
+    }
+    EXPECT_EQ(index.count(5), index.count(2));
+
+    for (int id = 0; id < students; ++id) index.setVisits(id, 2);
+    EXPECT_TRUE(index.allCompleted());
+    EXPECT_EQ(index.lagging(), 0);
+    EXPECT_EQ(index.first(0), -1);
+
+    // Класс отвечает по индексу: в начале все студенты отстают
+    EXPECT_EQ(room.studentsWithVisits(1, 0), 30);
+    EXPECT_EQ(room.studentsWithVisits(2, 2), 0);
+    EXPECT_EQ(room.laggingStudents(2).size(), 24u);
+    EXPECT_EQ(room.laggingStudents(1, 5).size(), 5u);
+}
+
+/**
+ * @brief Тест 10: Пакетная модель дает те же результаты, что RoomSimulator, с теми же зернами
+ *
+ * Кол-во зерен не кратно RoomEnsemble::LANES; малая вместимость дает прогоны, не завершившиеся к отсечке.
+ */
+TEST_F(UnitTest, RoomEnsembleMatchesScalarSimulator) {
+    std::vector<RoomConfig> configs(3);
+    configs[1].capacity = 12;
+    configs[2].session_ms = 300;
+    configs[2].min_wait_ms = 100;
+    configs[2].max_wait_ms = 700;
+    configs[2].retry_delay_ms = 50;
+
+    std::vector<uint64_t> seeds;
+    for (uint64_t seed = 1; seed <= 21; ++seed) seeds.push_back(seed * 7919);
+
+    int unfinished = 0;
+    for (const RoomConfig& config : configs) {
+        RoomSimulator simulator(config);
+        RoomEnsemble ensemble(config);
+        EXPECT_EQ(ensemble.tickMs(), simulator.tickMs());
+
+        std::vector<SimResult> results = ensemble.run(seeds, 60000);
+        ASSERT_EQ(results.size(), seeds.size());
+        for (size_t i = 0; i < seeds.size(); ++i) {
+            SimResult expected = simulator.run(seeds[i], 60000);
+            EXPECT_EQ(results[i].completed, expected.completed) << "seed " << seeds[i];
+            EXPECT_EQ(results[i].completion_ms, expected.completion_ms) << "seed " << seeds[i];
+            EXPECT_EQ(results[i].sessions, expected.sessions) << "seed " << seeds[i];
+            if (!expected.completed) unfinished++;
+        }
+    }
+    EXPECT_GT(unfinished, 0);
+
+    // Планировщик с пакетной моделью оценивает точку так же
+    RoomConfig config;
+    PlanTarget target;
+    PlanOptions options;
+    options.runs_per_point = 20;
+    options.batch_runs = 20;
+    options.threads = 2;
+    PlanPoint scalar = evaluatePlanPoint(config, target, options);
+    options.lockstep_ensemble = true;
+    PlanPoint lockstep = evaluatePlanPoint(config, target, options);
+    EXPECT_EQ(lockstep.runs, scalar.runs);
+    EXPECT_EQ(lockstep.percentile_ms, scalar.percentile_ms);
+    EXPECT_EQ(lockstep.exceed_share, scalar.exceed_share);
+}
+
+#ifndef _WIN32
+/**
+ * @brief Тест 11: Контрольная точка, прерванная посреди записи, не портит предыдущую
+ *
+ * Точки пишутся в половины файла по очереди; половина, отстающая на точку, догоняет ее копированием измененных записей.
+ */
+TEST_F(UnitTest, CheckpointFileKeepsPreviousPointOnTornWrite) {
+    std::string path = "/tmp/computer_room_checkpoint_file_" + std::to_string(getpid()) + ".bin";
+    auto header = [](long long visits) {
+        CheckpointHeader written{};
+        written.total_ks40 = 3;
+        written.total_ks44 = 1;
+        written.visits_credited = visits;
+        return written;
+    };
+    auto record = [](uint16_t visits) {
+        CheckpointRecord written{};
+        written.visits = visits;
+        return written;
+    };
+
+    CheckpointFile file;
+    ASSERT_TRUE(file.create(path, 4));
+    file.beginWrite();
+    for (int i = 0; i < 4; ++i) file.writeRecord(i, record(1));
+    ASSERT_TRUE(file.commit(header(4)));
+    file.beginWrite();
+    file.writeRecord(2, record(2));
+    ASSERT_TRUE(file.commit(header(5)));
+    // Третья точка меняет другого студента: запись 2 должна прийти из второй точки
+    file.beginWrite();
+    file.writeRecord(0, record(2));
+    ASSERT_TRUE(file.commit(header(6)));
+    EXPECT_EQ(file.header().generation, 3u);
+
+    // Четвертая точка не завершена: процесс "упал" после части записей
+    file.beginWrite();
+    file.writeRecord(3, record(2));
+    file.close();
+
+    CheckpointFile reopened;
+    ASSERT_TRUE(reopened.openReadOnly(path));
+    EXPECT_EQ(reopened.header().generation, 3u);
+    EXPECT_EQ(reopened.header().visits_credited, 6);
+    EXPECT_EQ(reopened.record(0).visits, 2);
+    EXPECT_EQ(reopened.record(1).visits, 1);
+    EXPECT_EQ(reopened.record(2).visits, 2);
+    EXPECT_EQ(reopened.record(3).visits, 1);
+    reopened.close();
+
+    // Файл без единой завершенной точки не открывается
+    ASSERT_TRUE(file.create(path, 4));
+    file.beginWrite();
+    file.writeRecord(0, record(1));
+    file.close();
+    EXPECT_FALSE(reopened.openReadOnly(path));
+    std::remove(path.c_str());
+}
+#endif